@@ -0,0 +1,47 @@
+#include "schedule.h"
+#include "mutation.h"
+#include "configuration.h"
+#include "racing.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char *argv[])
+{
+    srand(time(NULL));
+
+    std::string output = argc > 1 ? argv[1] : "tuned_configuration";
+
+    // instance classes over the grid produced by generator.cpp
+    std::vector<InstanceClass> classes = {
+        {2, 8, 100, 1000},
+        {2, 8, 1100, 2000},
+        {10, 20, 100, 1000},
+        {10, 20, 1100, 2000},
+    };
+    std::vector<std::vector<Schedule>> instances(classes.size());
+    for (int i = 0; i < 200; ++i) {
+        Schedule schedule("input/" + std::to_string(i) + ".csv");
+        for (long long c = 0; c < (long long)classes.size(); ++c) {
+            if (classes[c].contains(schedule.get_proc_num(), schedule.get_task_num())) {
+                instances[c].push_back(schedule);
+                break;
+            }
+        }
+    }
+
+    RacingSettings settings;
+    settings.seed = time(NULL);
+    ConfigurationFile configuration;
+    for (long long c = 0; c < (long long)classes.size(); ++c) {
+        RacingTuner<Schedule, Mutation> tuner(Mutation{}, settings);
+        AnnealingConfiguration best = tuner.tune(instances[c]);
+        std::cout << "Class " << c << " (" << instances[c].size() << " instances, "
+                  << tuner.get_evaluations() << " runs): " << best.repr() << std::endl;
+        configuration.add(classes[c], best);
+    }
+    configuration.save(output);
+
+    return 0;
+}
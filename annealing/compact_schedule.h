@@ -0,0 +1,223 @@
+#ifndef COMPACT_SCHEDULE_H
+#define COMPACT_SCHEDULE_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include "schedule.h"
+
+// Memory footprint of one schedule: the duration array is shared by all copies,
+// the assignment is private to every copy.
+struct MemoryUsage {
+    long long shared_bytes = 0;
+    long long private_bytes = 0;
+};
+
+// Schedule for huge instances: 32-bit task and processor ids, DurationT-wide
+// durations (uint16_t or uint32_t) shared read-only between copies, 64-bit costs.
+template<typename DurationT = uint32_t>
+class CompactSchedule : AbstractSchedule {
+    using TaskId = uint32_t;
+    using ProcId = uint32_t;
+
+    ProcId _proc_num = 0;
+    TaskId _task_num = 0;
+    std::shared_ptr<const std::vector<DurationT>> _task_time{};
+    std::vector<ProcId> _task_to_proc{};
+    std::vector<std::vector<TaskId>> _proc_to_task{};
+    // processor loads and the criterion are kept up to date by transfer_task
+    std::vector<uint64_t> _proc_load{};
+    uint64_t _quality = 0;
+
+    void assign_randomly();
+public:
+    CompactSchedule() {}
+    CompactSchedule(std::string filename);
+    CompactSchedule(long long proc_num, std::shared_ptr<const std::vector<DurationT>> task_time);
+    virtual long long get_quality() const override;
+    void transfer_task(long long task_idx, long long proc_from, long long proc_to);
+    long long get_proc_num() const;
+    long long get_task_num() const;
+    long long get_proc_task_num(long long proc) const;
+    long long get_task_proc(long long task) const;
+    std::shared_ptr<const std::vector<DurationT>> get_task_time() const;
+    MemoryUsage memory_usage() const;
+    std::string memory_report(long long chains) const;
+    std::string repr() const;
+};
+
+template<typename DurationT>
+CompactSchedule<DurationT>::CompactSchedule(std::string filename) {
+    std::ifstream file(filename);
+    long long proc_num = 0, task_num = 0;
+    std::string line;
+
+    if (!(file >> proc_num >> task_num) || proc_num < 1 || task_num < 0 ||
+        proc_num > std::numeric_limits<ProcId>::max() || task_num > std::numeric_limits<TaskId>::max()) {
+        throw std::invalid_argument("Wrong schedule header in " + filename);
+    }
+
+    auto task_time = std::make_shared<std::vector<DurationT>>(task_num);
+    while (file >> line) {
+        long long delimiter = line.find(',');
+        long long task = std::stoll(line.substr(0, delimiter));
+        long long time = std::stoll(line.substr(delimiter + 1));
+        if (task < 0 || task >= task_num) {
+            throw std::out_of_range("Task id is out of range in " + filename);
+        }
+        if (time < 0 || time > std::numeric_limits<DurationT>::max()) {
+            throw std::out_of_range("Task time does not fit the duration type in " + filename);
+        }
+        (*task_time)[task] = time;
+    }
+    file.close();
+
+    _proc_num = proc_num;
+    _task_num = task_num;
+    _task_time = task_time;
+    assign_randomly();
+}
+
+template<typename DurationT>
+CompactSchedule<DurationT>::CompactSchedule(long long proc_num, std::shared_ptr<const std::vector<DurationT>> task_time) {
+    if (proc_num < 1 || proc_num > std::numeric_limits<ProcId>::max() ||
+        task_time->size() > std::numeric_limits<TaskId>::max()) {
+        throw std::invalid_argument("Schedule does not fit 32-bit ids");
+    }
+    _proc_num = proc_num;
+    _task_num = task_time->size();
+    _task_time = task_time;
+    assign_randomly();
+}
+
+template<typename DurationT>
+void CompactSchedule<DurationT>::assign_randomly() {
+    _proc_to_task.assign(_proc_num, {});
+    _task_to_proc.resize(_task_num);
+    _proc_load.assign(_proc_num, 0);
+    _quality = 0;
+
+    const auto& task_time = *_task_time;
+    for (TaskId task = 0; task < _task_num; ++task) {
+        ProcId proc = rand() % _proc_num;
+        _proc_to_task[proc].push_back(task);
+        _task_to_proc[task] = proc;
+        _proc_load[proc] += task_time[task];
+        _quality += _proc_load[proc];
+    }
+}
+
+template<typename DurationT>
+long long CompactSchedule<DurationT>::get_quality() const {
+    return _quality;
+}
+
+template<typename DurationT>
+void CompactSchedule<DurationT>::transfer_task(long long task_idx, long long proc_from, long long proc_to) {
+    const auto& task_time = *_task_time;
+    auto& from = _proc_to_task[proc_from];
+    TaskId task = from[task_idx];
+    uint64_t time = task_time[task];
+
+    // the task leaves its completion time, every later task on proc_from finishes earlier by time
+    uint64_t finish = 0;
+    for (long long idx = 0; idx <= task_idx; ++idx) {
+        finish += task_time[from[idx]];
+    }
+    _quality -= finish + time * (from.size() - task_idx - 1);
+    _proc_load[proc_from] -= time;
+    from.erase(from.begin() + task_idx);
+
+    // the task finishes after everything already on proc_to
+    _proc_load[proc_to] += time;
+    _quality += _proc_load[proc_to];
+    _proc_to_task[proc_to].push_back(task);
+
+    _task_to_proc[task] = proc_to;
+}
+
+template<typename DurationT>
+long long CompactSchedule<DurationT>::get_proc_num() const {
+    return _proc_num;
+}
+
+template<typename DurationT>
+long long CompactSchedule<DurationT>::get_task_num() const {
+    return _task_num;
+}
+
+template<typename DurationT>
+long long CompactSchedule<DurationT>::get_proc_task_num(long long proc) const {
+    return _proc_to_task[proc].size();
+}
+
+template<typename DurationT>
+long long CompactSchedule<DurationT>::get_task_proc(long long task) const {
+    return _task_to_proc[task];
+}
+
+template<typename DurationT>
+std::shared_ptr<const std::vector<DurationT>> CompactSchedule<DurationT>::get_task_time() const {
+    return _task_time;
+}
+
+template<typename DurationT>
+MemoryUsage CompactSchedule<DurationT>::memory_usage() const {
+    MemoryUsage usage;
+    if (_task_time) {
+        usage.shared_bytes = sizeof(std::vector<DurationT>) + _task_time->capacity() * sizeof(DurationT);
+    }
+    usage.private_bytes = sizeof(*this) + _task_to_proc.capacity() * sizeof(ProcId) +
+                          _proc_load.capacity() * sizeof(uint64_t) +
+                          _proc_to_task.capacity() * sizeof(std::vector<TaskId>);
+    for (const auto& proc_schedule : _proc_to_task) {
+        usage.private_bytes += proc_schedule.capacity() * sizeof(TaskId);
+    }
+    return usage;
+}
+
+template<typename DurationT>
+std::string CompactSchedule<DurationT>::memory_report(long long chains) const {
+    // every annealing chain holds the current, the best and the candidate schedule
+    const long long copies_per_chain = 3;
+    MemoryUsage usage = memory_usage();
+    long long total = usage.shared_bytes + chains * copies_per_chain * usage.private_bytes;
+    // Schedule stores 64-bit time, task -> proc and proc -> task entries, durations copied with every schedule
+    long long wide = 3 * sizeof(long long) * (long long)_task_num +
+                     _proc_num * (long long)sizeof(std::vector<long long>);
+    long long wide_total = chains * copies_per_chain * wide;
+
+    std::stringstream ss;
+    ss << "tasks: " << _task_num << ", procs: " << _proc_num << ", duration bytes: " << sizeof(DurationT) << "\n";
+    ss << "shared durations: " << usage.shared_bytes << " bytes\n";
+    ss << "assignment per copy: " << usage.private_bytes << " bytes\n";
+    ss << "total for " << chains << " chains: " << total << " bytes\n";
+    ss << "Schedule for " << chains << " chains: " << wide_total << " bytes";
+    return ss.str();
+}
+
+template<typename DurationT>
+std::string CompactSchedule<DurationT>::repr() const {
+    std::stringstream ss;
+    for (long long proc = 0; proc < _proc_num; ++proc) {
+        const auto& proc_schedule = _proc_to_task[proc];
+        ss << proc << ":";
+        for (long long task_idx = 0; task_idx < proc_schedule.size(); ++task_idx) {
+            ss << proc_schedule[task_idx];
+            if (task_idx + 1 < proc_schedule.size()) {
+                ss << ",";
+            }
+        }
+        if (proc + 1 < _proc_num) {
+            ss << "\n";
+        }
+    }
+    return ss.str();
+}
+
+#endif
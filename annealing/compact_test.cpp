@@ -0,0 +1,56 @@
+#include "temperature.h"
+#include "compact_schedule.h"
+#include "mutation.h"
+#include "simulated_annealing.h"
+#include "instance_generator.h"
+
+#include <iostream>
+#include <chrono>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    srand(time(NULL));
+
+    long long task_num = argc > 1 ? std::stoll(argv[1]) : 1000000;
+    long long proc_num = argc > 2 ? std::stoll(argv[2]) : 20;
+    long long chains = argc > 3 ? std::stoll(argv[3]) : 32;
+    long long iterations = argc > 4 ? std::stoll(argv[4]) : 1000;
+
+    GeneratorSettings settings;
+    settings.seed = time(NULL);
+    auto task_time = InstanceGenerator(settings).generate_task_time<uint16_t>(proc_num, task_num);
+
+    using ScheduleT = CompactSchedule<uint16_t>;
+    ScheduleT schedule(proc_num, task_time);
+    std::cout << schedule.memory_report(chains) << std::endl;
+
+    // huge instances keep improving for a long time, so every chain runs a fixed number of iterations
+    using AlgoT = Annealing<ScheduleT, TransferMutation<ScheduleT>, BoltzmannTemperature>;
+    BoltzmannTemperature temperature;
+    temperature.set(1000000);
+    std::vector<AlgoT> models;
+    for (long long i = 0; i < chains; ++i) {
+        models.push_back(AlgoT(schedule, TransferMutation<ScheduleT>{}, temperature));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (long long i = 0; i < chains; ++i) {
+        threads.push_back(std::thread{[&models, i, iterations] { models[i].step(iterations); }});
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> ms_double = end - start;
+
+    long long best = schedule.get_quality();
+    for (const auto& model : models) {
+        best = std::min(best, model.get_best_schedule().get_quality());
+    }
+    std::cout << schedule.get_quality() << " -> " << best << std::endl;
+    std::cout << ms_double.count() << std::endl;
+
+    return 0;
+}
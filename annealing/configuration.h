@@ -0,0 +1,187 @@
+#ifndef CONFIGURATION_H
+#define CONFIGURATION_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include "temperature.h"
+#include "simulated_annealing.h"
+
+enum class TemperatureLaw {
+    BOLTZMANN,
+    CAUCHY,
+    GENERALIZED,
+};
+
+std::string law_to_string(TemperatureLaw law) {
+    switch (law) {
+        case TemperatureLaw::BOLTZMANN:
+            return "boltzmann";
+        case TemperatureLaw::CAUCHY:
+            return "cauchy";
+        default:
+            return "generalized";
+    }
+}
+
+TemperatureLaw law_from_string(const std::string& name) {
+    if (name == "boltzmann") {
+        return TemperatureLaw::BOLTZMANN;
+    } else if (name == "cauchy") {
+        return TemperatureLaw::CAUCHY;
+    } else if (name == "generalized") {
+        return TemperatureLaw::GENERALIZED;
+    }
+    throw std::invalid_argument("Unknown temperature law: " + name);
+}
+
+// parameters of one annealing run, defaults match the values used before tuning
+struct AnnealingConfiguration {
+    long long limit = 100;
+    long long parallel_limit = 10;
+    double initial_temperature = 1000000;
+    TemperatureLaw law = TemperatureLaw::BOLTZMANN;
+    long long threads = 1;
+
+    std::string repr() const {
+        std::stringstream ss;
+        ss << "limit=" << limit << " parallel_limit=" << parallel_limit
+           << " temperature=" << initial_temperature << " law=" << law_to_string(law)
+           << " threads=" << threads;
+        return ss.str();
+    }
+
+    // parses "key=value" pairs, missing keys keep their defaults
+    static AnnealingConfiguration parse(const std::string& line) {
+        AnnealingConfiguration config;
+        std::stringstream ss(line);
+        std::string word;
+        while (ss >> word) {
+            auto delimiter = word.find('=');
+            if (delimiter == std::string::npos) {
+                throw std::invalid_argument("Wrong configuration entry: " + word);
+            }
+            std::string key = word.substr(0, delimiter);
+            std::string value = word.substr(delimiter + 1);
+            if (key == "limit") {
+                config.limit = std::stoll(value);
+            } else if (key == "parallel_limit") {
+                config.parallel_limit = std::stoll(value);
+            } else if (key == "temperature") {
+                config.initial_temperature = std::stod(value);
+            } else if (key == "law") {
+                config.law = law_from_string(value);
+            } else if (key == "threads") {
+                config.threads = std::stoll(value);
+            } else {
+                throw std::invalid_argument("Unknown configuration key: " + key);
+            }
+        }
+        return config;
+    }
+};
+
+template<typename ScheduleT, typename MutationT, typename TemperatureT>
+ScheduleT run_annealing(const ScheduleT& schedule, MutationT mutation, const AnnealingConfiguration& config) {
+    TemperatureT temperature;
+    temperature.set(config.initial_temperature);
+    if (config.threads > 1) {
+        return ParallelAnnealing<ScheduleT, MutationT, TemperatureT>(config.threads, schedule, mutation, temperature,
+                                                                     config.parallel_limit, config.limit);
+    }
+    Annealing<ScheduleT, MutationT, TemperatureT> algo(schedule, mutation, temperature, config.limit);
+    algo.start();
+    return algo.get_best_schedule();
+}
+
+// runs annealing with the temperature law chosen at runtime
+template<typename ScheduleT, typename MutationT>
+ScheduleT solve(const ScheduleT& schedule, MutationT mutation, const AnnealingConfiguration& config) {
+    switch (config.law) {
+        case TemperatureLaw::BOLTZMANN:
+            return run_annealing<ScheduleT, MutationT, BoltzmannTemperature>(schedule, mutation, config);
+        case TemperatureLaw::CAUCHY:
+            return run_annealing<ScheduleT, MutationT, CauchyTemperature>(schedule, mutation, config);
+        default:
+            return run_annealing<ScheduleT, MutationT, GeneralizedTemperature>(schedule, mutation, config);
+    }
+}
+
+struct InstanceClass {
+    long long min_proc = 0;
+    long long max_proc = 0;
+    long long min_task = 0;
+    long long max_task = 0;
+
+    bool contains(long long proc_num, long long task_num) const {
+        return min_proc <= proc_num && proc_num <= max_proc && min_task <= task_num && task_num <= max_task;
+    }
+};
+
+// Per-instance-class configurations. File format, one class per line:
+// <min_proc> <max_proc> <min_task> <max_task> limit=... parallel_limit=... temperature=... law=... threads=...
+class ConfigurationFile {
+    std::vector<std::pair<InstanceClass, AnnealingConfiguration>> _classes{};
+    AnnealingConfiguration _default{};
+public:
+    ConfigurationFile() {}
+    ConfigurationFile(std::string filename);
+    void add(const InstanceClass& instance_class, const AnnealingConfiguration& config);
+    AnnealingConfiguration get(long long proc_num, long long task_num) const;
+    long long get_class_num() const;
+    void save(std::string filename) const;
+};
+
+ConfigurationFile::ConfigurationFile(std::string filename) {
+    // a missing file is not an error, the solver just keeps the defaults
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::stringstream ss(line);
+        InstanceClass instance_class;
+        if (!(ss >> instance_class.min_proc >> instance_class.max_proc
+                 >> instance_class.min_task >> instance_class.max_task)) {
+            throw std::invalid_argument("Wrong instance class: " + line);
+        }
+        std::string rest;
+        std::getline(ss, rest);
+        add(instance_class, AnnealingConfiguration::parse(rest));
+    }
+    file.close();
+}
+
+void ConfigurationFile::add(const InstanceClass& instance_class, const AnnealingConfiguration& config) {
+    _classes.push_back({instance_class, config});
+}
+
+AnnealingConfiguration ConfigurationFile::get(long long proc_num, long long task_num) const {
+    for (const auto& [instance_class, config] : _classes) {
+        if (instance_class.contains(proc_num, task_num)) {
+            return config;
+        }
+    }
+    return _default;
+}
+
+long long ConfigurationFile::get_class_num() const {
+    return _classes.size();
+}
+
+void ConfigurationFile::save(std::string filename) const {
+    std::ofstream file(filename);
+    file << "# min_proc max_proc min_task max_task parameters\n";
+    for (const auto& [instance_class, config] : _classes) {
+        file << instance_class.min_proc << " " << instance_class.max_proc << " "
+             << instance_class.min_task << " " << instance_class.max_task << " "
+             << config.repr() << "\n";
+    }
+    file.close();
+}
+
+#endif
@@ -1,15 +1,19 @@
-#include <random>
-#include <fstream>
+#include "instance_generator.h"
+
 #include <iostream>
 #include <chrono>
 #include <string>
-#include <map>
 
 int main(int argc, char *argv[]) {
-    srand(time(NULL));
-
-    long long low_time, upper_time;
-    std::cin >> low_time >> upper_time;
+    // usage: generator [uniform|heavy_tailed|bimodal|clustered] [csv|bin], bounds are read from stdin
+    GeneratorSettings settings;
+    settings.seed = time(NULL);
+    std::cin >> settings.low_time >> settings.upper_time;
+    if (argc > 1) {
+        settings.distribution = distribution_from_string(argv[1]);
+    }
+    bool binary = argc > 2 && std::string(argv[2]) == "bin";
+    InstanceGenerator generator(settings);
 
     long long proc_nums[10] = {2, 4, 6, 8, 10, 12, 14, 16, 18, 20};
     long long task_nums[20] = {100, 200, 300, 400, 500, 600, 700, 800, 900, 1000,
@@ -18,16 +22,14 @@ int main(int argc, char *argv[]) {
     int i = 0;
     for (auto proc_num : proc_nums) {
         for (auto task_num : task_nums) {
-            std::ofstream file("input/" + std::to_string(i) + ".csv");
-            file << proc_num << "\n";
-            file << task_num << "\n";
-
-            for (long long i = 0; i < task_num; ++i) {
-                file << i << "," << (rand() % (upper_time - low_time + 1)) + low_time << "\n";
+            if (binary) {
+                generator.write_binary("input/" + std::to_string(i) + ".bin", proc_num, task_num);
+            } else {
+                generator.write_csv("input/" + std::to_string(i) + ".csv", proc_num, task_num);
             }
             ++i;
         }
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,162 @@
+#ifndef INSTANCE_GENERATOR_H
+#define INSTANCE_GENERATOR_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+#include "cmath"
+#include "schedule.h"
+
+enum class DurationDistribution {
+    UNIFORM,
+    HEAVY_TAILED, // Pareto, most tasks are short, a few are very long
+    BIMODAL, // mix of short and long tasks
+    CLUSTERED, // durations gather around a few random centers
+};
+
+DurationDistribution distribution_from_string(const std::string& name) {
+    if (name == "uniform") {
+        return DurationDistribution::UNIFORM;
+    } else if (name == "heavy_tailed") {
+        return DurationDistribution::HEAVY_TAILED;
+    } else if (name == "bimodal") {
+        return DurationDistribution::BIMODAL;
+    } else if (name == "clustered") {
+        return DurationDistribution::CLUSTERED;
+    }
+    throw std::invalid_argument("Unknown distribution: " + name);
+}
+
+struct GeneratorSettings {
+    long long low_time = 1;
+    long long upper_time = 100;
+    DurationDistribution distribution = DurationDistribution::UNIFORM;
+    uint64_t seed = 0;
+    double pareto_alpha = 1.5;
+    double short_share = 0.8; // share of short tasks for BIMODAL
+    long long clusters = 5;
+    double cluster_spread = 0.02; // cluster width relative to the time range
+};
+
+// Samples durations from the raw mt19937_64 stream only (the std distributions
+// differ between standard libraries), so a seed gives the same instance everywhere.
+class DurationSampler {
+    GeneratorSettings _settings;
+    std::mt19937_64 _generator;
+    std::vector<double> _centers{};
+
+    double real() {
+        return (_generator() >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
+    }
+
+    long long clamp(double time) const {
+        return std::clamp<long long>(std::llround(time), _settings.low_time, _settings.upper_time);
+    }
+public:
+    DurationSampler(const GeneratorSettings& settings, uint64_t seed) : _settings(settings), _generator(seed) {
+        if (settings.low_time < 0 || settings.low_time > settings.upper_time) {
+            throw std::invalid_argument("Wrong duration bounds!");
+        }
+        if (settings.distribution == DurationDistribution::CLUSTERED) {
+            for (long long i = 0; i < std::max(1LL, settings.clusters); ++i) {
+                _centers.push_back(settings.low_time + real() * (settings.upper_time - settings.low_time));
+            }
+        }
+    }
+
+    long long next() {
+        double range = _settings.upper_time - _settings.low_time;
+        switch (_settings.distribution) {
+            case DurationDistribution::UNIFORM:
+                return _settings.low_time + (long long)(real() * (range + 1));
+            case DurationDistribution::HEAVY_TAILED:
+                return clamp(std::max(1LL, _settings.low_time) * std::pow(1 - real(), -1 / _settings.pareto_alpha));
+            case DurationDistribution::BIMODAL: {
+                double center = real() < _settings.short_share ? 0.1 : 0.9;
+                return clamp(_settings.low_time + (center + 0.1 * (real() - 0.5)) * range);
+            }
+            default: {
+                double center = _centers[_generator() % _centers.size()];
+                return clamp(center + _settings.cluster_spread * range * (2 * real() - 1));
+            }
+        }
+    }
+};
+
+class InstanceGenerator {
+    GeneratorSettings _settings;
+
+    // every instance gets its own stream, so sizes can be generated in any order
+    uint64_t instance_seed(long long proc_num, long long task_num) const {
+        uint64_t seed = _settings.seed ^ (proc_num * 0x9E3779B97F4A7C15ULL) ^ (task_num * 0xBF58476D1CE4E5B9ULL);
+        seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+        return seed ^ (seed >> 31);
+    }
+public:
+    InstanceGenerator(GeneratorSettings settings = GeneratorSettings{}) : _settings(settings) {}
+
+    // every sample lies in [low_time, upper_time], so bounds that fit DurationT make narrowing exact
+    template<typename DurationT = long long>
+    std::shared_ptr<const std::vector<DurationT>> generate_task_time(long long proc_num, long long task_num) const {
+        static_assert(std::is_integral_v<DurationT>, "durations are integers");
+        DurationSampler sampler(_settings, instance_seed(proc_num, task_num)); // checks 0 <= low_time <= upper_time
+        if ((unsigned long long)_settings.upper_time > (unsigned long long)std::numeric_limits<DurationT>::max()) {
+            throw std::out_of_range("Durations do not fit the duration type!");
+        }
+        auto task_time = std::make_shared<std::vector<DurationT>>(task_num);
+        for (auto& time : *task_time) {
+            time = sampler.next();
+        }
+        return task_time;
+    }
+
+    std::shared_ptr<const Instance> generate(long long proc_num, long long task_num) const {
+        return std::make_shared<const Instance>(proc_num, *generate_task_time(proc_num, task_num));
+    }
+
+    // streams the instance in chunks, memory use does not depend on task_num
+    void write_binary(std::string filename, long long proc_num, long long task_num) const {
+        const long long chunk_size = 1 << 16;
+        // the sampler checks the bounds, so a bad setting leaves no file behind
+        DurationSampler sampler(_settings, instance_seed(proc_num, task_num));
+        FILE* file = std::fopen(filename.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Can not open " + filename);
+        }
+        write_binary_header(file, proc_num, task_num, filename);
+
+        std::vector<int64_t> chunk;
+        chunk.reserve(chunk_size);
+        for (long long task = 0; task < task_num; task += chunk_size) {
+            chunk.clear();
+            for (long long i = task; i < std::min(task_num, task + chunk_size); ++i) {
+                chunk.push_back(sampler.next());
+            }
+            write_binary_block(file, chunk.data(), sizeof(int64_t), chunk.size(), filename);
+        }
+        if (std::fclose(file) != 0) {
+            throw std::runtime_error("Can not write " + filename);
+        }
+    }
+
+    void write_csv(std::string filename, long long proc_num, long long task_num) const {
+        DurationSampler sampler(_settings, instance_seed(proc_num, task_num));
+        std::ofstream file(filename);
+        file << proc_num << "\n";
+        file << task_num << "\n";
+
+        for (long long task = 0; task < task_num; ++task) {
+            file << task << "," << sampler.next() << "\n";
+        }
+    }
+};
+
+#endif
@@ -2,6 +2,7 @@
 #include "schedule.h"
 #include "mutation.h"
 #include "simulated_annealing.h"
+#include "configuration.h"
 
 #include <iostream>
 #include <sstream>
@@ -12,21 +13,22 @@ int main()
 {
     srand(time(NULL));
 
+    // parameters tuned per instance class by autotune.cpp, defaults if there is no file
+    ConfigurationFile configuration("tuned_configuration");
+
     int n = 5;
     for (int i = 0; i < 200; ++i) {
         std::cout << "No: " << i << std::endl;
         double average_time = 0;
         for (int j = 0; j < n; ++j) {
-            BoltzmannTemperature temperature;
-            temperature.set(1000000);
             Schedule schedule("input/" + std::to_string(i) + ".csv");
             Mutation mutation;
-            Annealing<Schedule, Mutation, BoltzmannTemperature> algo(schedule, mutation, temperature);
+            auto config = configuration.get(schedule.get_proc_num(), schedule.get_task_num());
             auto start = std::chrono::high_resolution_clock::now();
-            algo.start();
+            Schedule best = solve(schedule, mutation, config);
             auto end = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double, std::milli> ms_double = end - start;
-            std::cout << algo.get_best_schedule().get_quality() << std::endl;
+            std::cout << best.get_quality() << std::endl;
             average_time += ms_double.count();
         }
         average_time /= n;
@@ -9,10 +9,11 @@ public:
     virtual ScheduleT mutate(ScheduleT schedule) = 0;
 };
 
-class Mutation : public AbstractMutation<Schedule> {
+template<typename ScheduleT>
+class TransferMutation : public AbstractMutation<ScheduleT> {
 public:
-    Mutation() {}
-    virtual Schedule mutate(Schedule schedule) override {
+    TransferMutation() {}
+    virtual ScheduleT mutate(ScheduleT schedule) override {
         if (schedule.get_proc_num() == 1) {
             return schedule;
         }
@@ -38,4 +39,9 @@ public:
     };
 };
 
+class Mutation : public TransferMutation<Schedule> {
+public:
+    Mutation() {}
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,257 @@
+#ifndef RACING_H
+#define RACING_H
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <future>
+#include <numeric>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "cmath"
+#include "configuration.h"
+#include "thread_pool.h"
+
+struct RacingSettings {
+    long long candidates = 16; // configurations raced per iteration
+    long long iterations = 3; // race iterations, each restarts around the elites
+    long long elites = 3; // survivors carried over to the next iteration
+    long long first_test = 5; // instances evaluated before the first elimination
+    long long max_evaluations = 600; // total number of annealing runs
+    long long max_threads = std::max(1u, std::thread::hardware_concurrency()); // threads shared by all runs
+    double time_penalty = 1.0; // cost of one millisecond in criterion units
+    unsigned seed = 0;
+};
+
+// Counting semaphore over hardware threads: an evaluation holds as many slots
+// as its configuration runs threads, so concurrent runs never oversubscribe the machine.
+class ThreadSlots {
+    long long _free;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+public:
+    explicit ThreadSlots(long long slots) : _free(slots) {}
+
+    void acquire(long long slots) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait(lock, [this, slots] { return _free >= slots; });
+        _free -= slots;
+    }
+
+    void release(long long slots) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _free += slots;
+        }
+        _condition.notify_all();
+    }
+};
+
+// Iterated F-race: candidates are evaluated instance by instance, after every
+// instance the Friedman test decides whether the worst ones can be dropped.
+template<typename ScheduleT, typename MutationT>
+class RacingTuner {
+    RacingSettings _settings;
+    MutationT _mutation;
+    ThreadPool _pool;
+    ThreadSlots _slots;
+    std::mt19937 _generator;
+    long long _evaluations = 0;
+
+    double log_uniform(double low, double high) {
+        std::uniform_real_distribution<double> distribution(std::log(low), std::log(high));
+        return std::exp(distribution(_generator));
+    }
+
+    long long uniform(long long low, long long high) {
+        std::uniform_int_distribution<long long> distribution(low, high);
+        return distribution(_generator);
+    }
+
+    AnnealingConfiguration sample() {
+        AnnealingConfiguration config;
+        config.limit = std::llround(log_uniform(10, 2000));
+        config.parallel_limit = uniform(1, 30);
+        config.initial_temperature = log_uniform(100, 100000000);
+        config.law = static_cast<TemperatureLaw>(uniform(0, 2));
+        config.threads = uniform(1, _settings.max_threads);
+        return config;
+    }
+
+    // samples a new configuration near an elite one
+    AnnealingConfiguration perturb(const AnnealingConfiguration& elite) {
+        std::normal_distribution<double> noise(0, 0.3);
+        AnnealingConfiguration config = elite;
+        config.limit = std::clamp<long long>(std::llround(elite.limit * std::exp(noise(_generator))), 10, 2000);
+        config.parallel_limit = std::clamp<long long>(std::llround(elite.parallel_limit * std::exp(noise(_generator))),
+                                                      1, 30);
+        config.initial_temperature = std::clamp(elite.initial_temperature * std::exp(3 * noise(_generator)),
+                                                100.0, 100000000.0);
+        if (uniform(0, 4) == 0) {
+            config.law = static_cast<TemperatureLaw>(uniform(0, 2));
+        }
+        config.threads = std::clamp<long long>(elite.threads + uniform(-1, 1), 1, _settings.max_threads);
+        return config;
+    }
+
+    // the run is timed only while it owns its threads, so the time penalty measures
+    // the configuration and not the contention with other candidates
+    double evaluate(const ScheduleT& instance, const AnnealingConfiguration& config) {
+        long long slots = std::min(std::max<long long>(1, config.threads),
+                                   std::max<long long>(1, _settings.max_threads));
+        _slots.acquire(slots);
+        auto start = std::chrono::high_resolution_clock::now();
+        ScheduleT best = solve(instance, _mutation, config);
+        auto end = std::chrono::high_resolution_clock::now();
+        _slots.release(slots);
+        std::chrono::duration<double, std::milli> ms_double = end - start;
+        return best.get_quality() + _settings.time_penalty * ms_double.count();
+    }
+
+    // ranks of one block, ties get the average rank
+    static std::vector<double> rank(const std::vector<double>& costs) {
+        std::vector<long long> order(costs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&costs](long long a, long long b) { return costs[a] < costs[b]; });
+        std::vector<double> ranks(costs.size());
+        long long n = order.size();
+        for (long long i = 0; i < n;) {
+            long long j = i;
+            while (j + 1 < n && costs[order[j + 1]] == costs[order[i]]) {
+                ++j;
+            }
+            for (long long t = i; t <= j; ++t) {
+                ranks[order[t]] = (i + j) / 2.0 + 1;
+            }
+            i = j + 1;
+        }
+        return ranks;
+    }
+
+    // Friedman test with Conover's post-hoc comparison against the best candidate,
+    // returns indices of candidates that survive
+    static std::vector<long long> eliminate(const std::vector<std::vector<double>>& costs,
+                                            const std::vector<long long>& alive) {
+        long long k = alive.size();
+        long long b = costs[alive[0]].size();
+        if (b < 2) {
+            return alive;
+        }
+        std::vector<double> rank_sums(k, 0);
+        double a = 0;
+        for (long long block = 0; block < b; ++block) {
+            std::vector<double> block_costs(k);
+            for (long long i = 0; i < k; ++i) {
+                block_costs[i] = costs[alive[i]][block];
+            }
+            auto ranks = rank(block_costs);
+            for (long long i = 0; i < k; ++i) {
+                rank_sums[i] += ranks[i];
+                a += ranks[i] * ranks[i];
+            }
+        }
+
+        double c = b * k * (k + 1) * (k + 1) / 4.0;
+        if (a - c <= 0) {
+            return alive; // all blocks are ties
+        }
+        double spread = 0;
+        for (double sum : rank_sums) {
+            spread += (sum - b * (k + 1) / 2.0) * (sum - b * (k + 1) / 2.0);
+        }
+        double statistic = (k - 1) * spread / (a - c);
+
+        // chi-square quantile at alpha = 0.05 by the Wilson-Hilferty approximation
+        double df = k - 1;
+        double z = 1.6449;
+        double critical = df * std::pow(1 - 2 / (9 * df) + z * std::sqrt(2 / (9 * df)), 3);
+        if (statistic <= critical) {
+            return alive;
+        }
+
+        double difference = 1.96 * std::sqrt(2 * b * (1 - statistic / (b * (k - 1))) * (a - c) /
+                                              ((b - 1) * (k - 1)));
+        double best = *std::min_element(rank_sums.begin(), rank_sums.end());
+        std::vector<long long> survivors;
+        for (long long i = 0; i < k; ++i) {
+            if (rank_sums[i] - best <= difference) {
+                survivors.push_back(alive[i]);
+            }
+        }
+        return survivors;
+    }
+
+    // races candidates, returns survivors ordered from best to worst
+    std::vector<AnnealingConfiguration> race(const std::vector<AnnealingConfiguration>& candidates,
+                                             const std::vector<ScheduleT>& instances, long long budget) {
+        std::vector<std::vector<double>> costs(candidates.size());
+        std::vector<long long> alive(candidates.size());
+        std::iota(alive.begin(), alive.end(), 0);
+
+        for (long long block = 0; alive.size() > 1 && budget >= (long long)alive.size(); ++block) {
+            const ScheduleT& instance = instances[block % instances.size()];
+            std::vector<std::future<double>> results;
+            for (long long i : alive) {
+                results.push_back(_pool.submit([this, &instance, &candidates, i] {
+                    return evaluate(instance, candidates[i]);
+                }));
+            }
+            for (long long i = 0; i < (long long)alive.size(); ++i) {
+                costs[alive[i]].push_back(results[i].get());
+            }
+            budget -= alive.size();
+            _evaluations += alive.size();
+
+            if (block + 1 >= _settings.first_test) {
+                alive = eliminate(costs, alive);
+            }
+        }
+
+        auto mean = [&costs](long long i) {
+            return std::accumulate(costs[i].begin(), costs[i].end(), 0.0) / std::max<long long>(1, costs[i].size());
+        };
+        std::sort(alive.begin(), alive.end(), [&mean](long long a, long long b) { return mean(a) < mean(b); });
+        std::vector<AnnealingConfiguration> survivors;
+        for (long long i : alive) {
+            survivors.push_back(candidates[i]);
+        }
+        return survivors;
+    }
+public:
+    RacingTuner(MutationT mutation, RacingSettings settings = RacingSettings{}) :
+                _settings(settings), _mutation(mutation), _pool(std::max<long long>(1, settings.max_threads)),
+                _slots(std::max<long long>(1, settings.max_threads)), _generator(settings.seed) {}
+
+    AnnealingConfiguration tune(const std::vector<ScheduleT>& instances) {
+        if (instances.empty()) {
+            return AnnealingConfiguration{};
+        }
+        _evaluations = 0;
+        // the untuned defaults take part in the first race
+        std::vector<AnnealingConfiguration> elites{AnnealingConfiguration{}};
+        long long budget = _settings.max_evaluations / std::max<long long>(1, _settings.iterations);
+
+        for (long long iteration = 0; iteration < _settings.iterations; ++iteration) {
+            std::vector<AnnealingConfiguration> candidates = elites;
+            while ((long long)candidates.size() < _settings.candidates) {
+                if (iteration == 0) {
+                    candidates.push_back(sample());
+                } else {
+                    candidates.push_back(perturb(elites[uniform(0, elites.size() - 1)]));
+                }
+            }
+            auto survivors = race(candidates, instances, budget);
+            survivors.resize(std::min<long long>(survivors.size(), _settings.elites));
+            elites = survivors;
+        }
+        return elites[0];
+    }
+
+    long long get_evaluations() const {
+        return _evaluations;
+    }
+};
+
+#endif
@@ -3,9 +3,14 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
 #include "iostream"
 #include "assert.h"
 
@@ -14,39 +19,212 @@ public:
     virtual long long get_quality() const = 0;
 };
 
-class Schedule : AbstractSchedule {
+// Binary instance format: 8-byte magic, int64 proc_num, int64 task_num, then task_num
+// int64 durations in host byte order
+const char BINARY_MAGIC[8] = {'S', 'C', 'H', 'E', 'D', 'B', 'I', 'N'};
+
+// fwrite that fails loudly: a short write closes the file and throws
+void write_binary_block(FILE* file, const void* data, size_t size, size_t count, const std::string& filename) {
+    if (std::fwrite(data, size, count, file) != count) {
+        std::fclose(file);
+        throw std::runtime_error("Can not write " + filename);
+    }
+}
+
+void write_binary_header(FILE* file, long long proc_num, long long task_num, const std::string& filename) {
+    int64_t header[2] = {proc_num, task_num};
+    write_binary_block(file, BINARY_MAGIC, 1, sizeof(BINARY_MAGIC), filename);
+    write_binary_block(file, header, sizeof(int64_t), 2, filename);
+}
+
+// Immutable problem data, shared by every schedule built on it
+class Instance {
     long long _proc_num = 0;
-    long long _task_num = 0;
     std::vector<long long> _task_time{};
+public:
+    Instance(long long proc_num, std::vector<long long> task_time);
+    static std::shared_ptr<const Instance> load(std::string filename);
+    static std::shared_ptr<const Instance> load_binary(std::ifstream& file);
+    void save_binary(std::string filename) const;
+    long long get_proc_num() const;
+    long long get_task_num() const;
+    long long get_task_time(long long task) const;
+};
+
+// Mutable part of a schedule: which processor runs which tasks and in what order
+class Assignment {
     std::vector<long long> _task_to_proc{};
     std::vector<std::vector<long long>> _proc_to_task{};
+public:
+    Assignment() {}
+    Assignment(long long proc_num, long long task_num);
+    void append_task(long long task, long long proc);
+    void transfer_task(long long task_idx, long long proc_from, long long proc_to);
+    long long get_proc_task_num(long long proc) const;
+    long long get_task_proc(long long task) const;
+    const std::vector<long long>& get_proc_tasks(long long proc) const;
+};
+
+class Schedule : AbstractSchedule {
+    std::shared_ptr<const Instance> _instance{};
+    Assignment _assignment{};
 public:
     Schedule() {}
     Schedule(std::string filename);
+    Schedule(long long proc_num, const std::vector<long long>& task_time);
+    Schedule(std::shared_ptr<const Instance> instance);
     virtual long long get_quality() const override;
     void transfer_task(long long task, long long proc_from, long long proc_to);
     long long get_proc_num() const;
     long long get_task_num() const;
     long long get_proc_task_num(long long proc) const;
+    long long get_task_proc(long long task) const;
+    std::shared_ptr<const Instance> get_instance() const;
+    const Assignment& get_assignment() const;
     std::string repr() const;
 };
 
-long long Schedule::get_proc_num() const {
+Instance::Instance(long long proc_num, std::vector<long long> task_time) :
+                   _proc_num(proc_num), _task_time(std::move(task_time)) {}
+
+std::shared_ptr<const Instance> Instance::load(std::string filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream ss;
+    std::string line;
+    long long proc_num = 0, task_num = 0;
+    std::vector<long long> task_time;
+
+    char magic[sizeof(BINARY_MAGIC)] = {};
+    if (file.read(magic, sizeof(magic)) && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0) {
+        return load_binary(file);
+    }
+    file.clear();
+    file.seekg(0);
+
+    if (file.is_open()) {
+        file >> line;
+        ss = std::stringstream(line);
+        ss >> proc_num; // read proc_num
+        file >> line;
+        ss = std::stringstream(line);
+        ss >> task_num; // read task_num
+
+        task_time.resize(task_num);
+
+        long long task, time;
+        while (file >> line) {
+            long long delimiter = line.find(',');
+            std::stringstream new_ss;
+            new_ss << line.substr(0, delimiter) << " " << line.substr(delimiter + 1, line.size() - delimiter);
+            new_ss >> task >> time;
+            task_time[task] = time;
+        }
+    }
+
+    file.close();
+    return std::make_shared<const Instance>(proc_num, std::move(task_time));
+}
+
+// reads everything after the magic
+std::shared_ptr<const Instance> Instance::load_binary(std::ifstream& file) {
+    static_assert(sizeof(long long) == sizeof(int64_t));
+    int64_t header[2] = {0, 0};
+    if (!file.read((char*)header, sizeof(header)) || header[0] < 1 || header[1] < 0) {
+        throw std::runtime_error("Wrong binary instance header!");
+    }
+    std::vector<long long> task_time(header[1]);
+    if (!file.read((char*)task_time.data(), task_time.size() * sizeof(int64_t))) {
+        throw std::runtime_error("Binary instance is truncated!");
+    }
+    return std::make_shared<const Instance>(header[0], std::move(task_time));
+}
+
+void Instance::save_binary(std::string filename) const {
+    FILE* file = std::fopen(filename.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("Can not open " + filename);
+    }
+    write_binary_header(file, _proc_num, _task_time.size(), filename);
+    write_binary_block(file, _task_time.data(), sizeof(long long), _task_time.size(), filename);
+    if (std::fclose(file) != 0) {
+        throw std::runtime_error("Can not write " + filename);
+    }
+}
+
+long long Instance::get_proc_num() const {
     return _proc_num;
 }
 
+long long Instance::get_task_num() const {
+    return _task_time.size();
+}
+
+long long Instance::get_task_time(long long task) const {
+    return _task_time[task];
+}
+
+Assignment::Assignment(long long proc_num, long long task_num) {
+    _proc_to_task.resize(proc_num);
+    _task_to_proc.resize(task_num);
+}
+
+void Assignment::append_task(long long task, long long proc) {
+    _proc_to_task[proc].push_back(task);
+    _task_to_proc[task] = proc;
+}
+
+void Assignment::transfer_task(long long task_idx, long long proc_from, long long proc_to) {
+    // delete task from first proc
+    long long task = _proc_to_task[proc_from][task_idx]; // task number
+    _proc_to_task[proc_from].erase(_proc_to_task[proc_from].begin() + task_idx);
+
+    // add task to the end of second proc
+    _proc_to_task[proc_to].push_back(task);
+
+    _task_to_proc[task] = proc_to; // update task -> proc mapping
+}
+
+long long Assignment::get_proc_task_num(long long proc) const {
+    return _proc_to_task[proc].size();
+}
+
+long long Assignment::get_task_proc(long long task) const {
+    return _task_to_proc[task];
+}
+
+const std::vector<long long>& Assignment::get_proc_tasks(long long proc) const {
+    return _proc_to_task[proc];
+}
+
+long long Schedule::get_proc_num() const {
+    return _instance ? _instance->get_proc_num() : 0;
+}
+
 long long Schedule::get_task_num() const {
-    return _task_num;
+    return _instance ? _instance->get_task_num() : 0;
 }
 
 long long Schedule::get_proc_task_num(long long proc) const {
-    return _proc_to_task[proc].size();
+    return _assignment.get_proc_task_num(proc);
+}
+
+long long Schedule::get_task_proc(long long task) const {
+    return _assignment.get_task_proc(task);
+}
+
+std::shared_ptr<const Instance> Schedule::get_instance() const {
+    return _instance;
+}
+
+const Assignment& Schedule::get_assignment() const {
+    return _assignment;
 }
 
 std::string Schedule::repr() const {
     std::stringstream ss;
-    long long proc = 0;
-    for (const auto& proc_schedule : _proc_to_task) {
+    long long proc_num = get_proc_num();
+    for (long long proc = 0; proc < proc_num; ++proc) {
+        const auto& proc_schedule = _assignment.get_proc_tasks(proc);
         ss << proc << ":";
         for (long long task_idx = 0; task_idx < proc_schedule.size(); ++task_idx) {
             ss << proc_schedule[task_idx];
@@ -54,68 +232,43 @@ std::string Schedule::repr() const {
                 ss << ",";
             }
         }
-        if (proc + 1 < _proc_num) {
+        if (proc + 1 < proc_num) {
             ss << "\n";
         }
-        ++proc;
     }
     return ss.str();
 }
 
 void Schedule::transfer_task(long long task_idx, long long proc_from, long long proc_to) {
-    // delete task from first proc
-    long long task = _proc_to_task[proc_from][task_idx]; // task number
-    _proc_to_task[proc_from].erase(_proc_to_task[proc_from].begin() + task_idx);
-
-    // add task to the end of second proc
-    _proc_to_task[proc_to].push_back(task);
-
-    _task_to_proc[task] = proc_to; // update task -> proc mapping
+    _assignment.transfer_task(task_idx, proc_from, proc_to);
 }
 
-Schedule::Schedule(std::string filename) {
-    std::ifstream file(filename);
-    std::stringstream ss;
-    std::string line;
-
-    if (file.is_open()) {
-        file >> line;
-        ss = std::stringstream(line);
-        ss >> _proc_num; // read proc_num
-        file >> line;
-        ss = std::stringstream(line);
-        ss >> _task_num; // read task_num
+Schedule::Schedule(std::shared_ptr<const Instance> instance) : _instance(instance) {
+    long long proc_num = _instance->get_proc_num();
+    long long task_num = _instance->get_task_num();
+    _assignment = Assignment(proc_num, task_num);
 
-        _proc_to_task.resize(_proc_num);
-        _task_time.resize(_task_num);
-        _task_to_proc.resize(_task_num);
-        
-        long long task, time;
-        while (file >> line) {
-            long long delimiter = line.find(',');
-            std::stringstream new_ss;
-            new_ss << line.substr(0, delimiter) << " " << line.substr(delimiter + 1, line.size() - delimiter);
-            new_ss >> task >> time;
-            _task_time[task] = time;
-            long long proc = rand() % _proc_num;
-            _proc_to_task[proc].push_back(task);
-            _task_to_proc[task] = proc;
-        }
+    for (long long task = 0; task < task_num; ++task) {
+        _assignment.append_task(task, rand() % proc_num);
     }
-
-    file.close();
 }
 
+Schedule::Schedule(std::string filename) : Schedule(Instance::load(filename)) {}
+
+Schedule::Schedule(long long proc_num, const std::vector<long long>& task_time) :
+                   Schedule(std::make_shared<const Instance>(proc_num, task_time)) {}
+
 long long Schedule::get_quality() const {
     long long quality = 0;
-    for (const auto& proc_schedule : _proc_to_task) {
+    long long proc_num = get_proc_num();
+    for (long long proc = 0; proc < proc_num; ++proc) {
         long long start_time = 0;
-        for (long long task : proc_schedule) {
-            quality += start_time + _task_time[task];
-            start_time += _task_time[task];
+        for (long long task : _assignment.get_proc_tasks(proc)) {
+            quality += start_time + _instance->get_task_time(task);
+            start_time += _instance->get_task_time(task);
         }
     }
     return quality;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,32 @@
+#include "service.h"
+
+#include <csignal>
+#include <iostream>
+#include <string>
+
+SolverService* running_service = nullptr;
+
+void handle_signal(int) {
+    if (running_service != nullptr) {
+        running_service->stop();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    srand(time(NULL));
+
+    std::string socket_path = argc > 1 ? argv[1] : "/tmp/annealing.sock";
+    ConfigurationFile configuration("tuned_configuration");
+
+    SolverService service(socket_path, configuration);
+    running_service = &service;
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+
+    std::cout << "Listening on " << socket_path << std::endl;
+    service.run();
+    running_service = nullptr;
+
+    return 0;
+}
@@ -0,0 +1,468 @@
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include <atomic>
+#include <cerrno>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "schedule.h"
+#include "mutation.h"
+#include "temperature.h"
+#include "simulated_annealing.h"
+#include "configuration.h"
+#include "thread_pool.h"
+
+class AbstractJob {
+public:
+    virtual ~AbstractJob() {}
+    virtual bool step(long long iterations) = 0;
+    virtual Schedule get_best_schedule() const = 0;
+};
+
+template<typename TemperatureT>
+class AnnealingJob : public AbstractJob {
+    Annealing<Schedule, Mutation, TemperatureT> _algo;
+public:
+    AnnealingJob(const Schedule& schedule, const AnnealingConfiguration& config) :
+                 _algo(schedule, Mutation{}, make_temperature(config), config.limit) {}
+
+    static TemperatureT make_temperature(const AnnealingConfiguration& config) {
+        TemperatureT temperature;
+        temperature.set(config.initial_temperature);
+        return temperature;
+    }
+
+    virtual bool step(long long iterations) override {
+        return _algo.step(iterations);
+    }
+
+    virtual Schedule get_best_schedule() const override {
+        return _algo.get_best_schedule();
+    }
+};
+
+std::unique_ptr<AbstractJob> make_job(const Schedule& schedule, const AnnealingConfiguration& config) {
+    switch (config.law) {
+        case TemperatureLaw::BOLTZMANN:
+            return std::make_unique<AnnealingJob<BoltzmannTemperature>>(schedule, config);
+        case TemperatureLaw::CAUCHY:
+            return std::make_unique<AnnealingJob<CauchyTemperature>>(schedule, config);
+        default:
+            return std::make_unique<AnnealingJob<GeneralizedTemperature>>(schedule, config);
+    }
+}
+
+// Long-running solver listening on a Unix domain socket. Line protocol:
+//   -> submit <proc_num> <task_num> <time_0> ... <time_{task_num - 1}>
+//   <- accepted <job>
+//   <- improved <job> <quality> <proc of task 0> ... <proc of task_num - 1>   (every time the best schedule improves)
+//   <- done <job> <quality> <proc of task 0> ... <proc of task_num - 1>
+//   -> cancel <job>
+//   <- cancelled <job> <quality> <proc of task 0> ... <proc of task_num - 1>  (best schedule found so far)
+//   <- error <message>
+// Jobs run in slices of annealing iterations on a fixed worker pool, a slice
+// puts its job back at the end of the queue, so any number of jobs share the workers.
+// Submit lines are parsed on the pool as well, the event loop only splits input into lines.
+// A malformed or oversized request gets an error line, it never stops the service.
+class SolverService {
+    static const long long MAX_PROC_NUM = 1 << 16;
+    static const long long MAX_TASK_NUM = 1 << 22;
+    static const long long MAX_LINE_SIZE = 1 << 28; // longest submit line with MAX_TASK_NUM times
+
+    struct Job {
+        long long id = 0;
+        int client = -1;
+        long long session = -1;
+        std::unique_ptr<AbstractJob> annealing{};
+        long long reported_quality = -1;
+        std::atomic<bool> cancelled{false};
+        bool cancel_requested = false; // guarded by _mutex, the client waits for a cancelled line
+    };
+
+    // a descriptor is reused after disconnect, the session tells connections apart
+    struct Client {
+        long long session = -1;
+        std::string input{};
+        long long scanned = 0; // input before this offset has no newline
+        std::string output{};
+    };
+
+    std::string _socket_path;
+    ConfigurationFile _configuration;
+    long long _slice;
+    int _listener = -1;
+    int _wakeup[2] = {-1, -1};
+    std::atomic<bool> _running{false};
+    std::mutex _mutex; // guards _clients and _jobs
+    std::map<int, Client> _clients{};
+    std::map<long long, std::shared_ptr<Job>> _jobs{};
+    long long _next_id = 0;
+    long long _next_session = 0;
+    ThreadPool _pool; // destroyed first, while jobs and clients are still alive
+
+    void wake() {
+        char byte = 0;
+        if (write(_wakeup[1], &byte, 1) < 0) {
+            // the pipe is full, poll wakes up anyway
+        }
+    }
+
+    // requires the lock
+    Client* find_client(int client, long long session) {
+        auto it = _clients.find(client);
+        if (it == _clients.end() || it->second.session != session) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    void send(int client, long long session, const std::string& line) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Client* state = find_client(client, session);
+            if (state == nullptr) {
+                return;
+            }
+            state->output += line;
+            state->output += '\n';
+        }
+        wake();
+    }
+
+    static std::string result_line(const std::string& kind, long long id, const Schedule& best) {
+        std::stringstream ss;
+        ss << kind << " " << id << " " << best.get_quality();
+        for (long long task = 0; task < best.get_task_num(); ++task) {
+            ss << " " << best.get_task_proc(task);
+        }
+        return ss.str();
+    }
+
+    // Output of a slice goes through the job, not the raw descriptor: disconnect()
+    // cancels the jobs of a client under the same lock before its descriptor can be
+    // reused, so a line of a cancelled job never reaches a new client.
+    bool send_job(const Job& job, const std::string& line) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Client* state = find_client(job.client, job.session);
+            if (job.cancelled || state == nullptr) {
+                return false;
+            }
+            state->output += line;
+            state->output += '\n';
+        }
+        wake();
+        return true;
+    }
+
+    void schedule(std::shared_ptr<Job> job) {
+        _pool.submit([this, job] { run_slice(job); });
+    }
+
+    // Sends the last line of a job and forgets it in one step: a cancel either comes
+    // before and is answered with the best schedule so far, or finds no job.
+    void complete(const std::shared_ptr<Job>& job, bool finished) {
+        Schedule best = job->annealing->get_best_schedule();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.erase(job->id);
+            Client* state = find_client(job->client, job->session);
+            if (state != nullptr && (job->cancel_requested || (finished && !job->cancelled))) {
+                state->output += result_line(job->cancel_requested ? "cancelled" : "done", job->id, best);
+                state->output += '\n';
+            }
+        }
+        wake();
+    }
+
+    void run_slice(std::shared_ptr<Job> job) {
+        bool finished = job->cancelled || job->annealing->step(_slice);
+        if (job->cancelled) {
+            complete(job, false);
+            return;
+        }
+        Schedule best = job->annealing->get_best_schedule();
+        long long quality = best.get_quality();
+        if (job->reported_quality < 0 || quality < job->reported_quality) {
+            job->reported_quality = quality;
+            if (!send_job(*job, result_line("improved", job->id, best))) {
+                complete(job, false);
+                return;
+            }
+        }
+        if (!finished) {
+            schedule(job);
+            return;
+        }
+        complete(job, true);
+    }
+
+    void submit(int client, long long session, std::stringstream& ss) {
+        long long proc_num = 0, task_num = 0;
+        if (!(ss >> proc_num >> task_num) || proc_num < 1 || task_num < 0) {
+            send(client, session, "error expected proc_num and task_num");
+            return;
+        }
+        if (proc_num > MAX_PROC_NUM || task_num > MAX_TASK_NUM) {
+            send(client, session, "error at most " + std::to_string(MAX_PROC_NUM) + " processors and " +
+                                  std::to_string(MAX_TASK_NUM) + " tasks");
+            return;
+        }
+        std::vector<long long> task_time(task_num);
+        for (auto& time : task_time) {
+            if (!(ss >> time) || time < 0) {
+                send(client, session, "error expected " + std::to_string(task_num) + " task times");
+                return;
+            }
+        }
+
+        auto job = std::make_shared<Job>();
+        job->client = client;
+        job->session = session;
+        job->annealing = make_job(Schedule(proc_num, task_time), _configuration.get(proc_num, task_num));
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Client* state = find_client(client, session);
+            if (state == nullptr) {
+                return; // the client left while the line was parsed
+            }
+            job->id = _next_id++;
+            _jobs[job->id] = job;
+            state->output += "accepted " + std::to_string(job->id) + "\n";
+        }
+        wake();
+        schedule(job);
+    }
+
+    // the job answers with the best schedule so far when it stops
+    void cancel(int client, long long session, std::stringstream& ss) {
+        long long id = 0;
+        if (!(ss >> id)) {
+            send(client, session, "error expected job id");
+            return;
+        }
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _jobs.find(id);
+            if (it != _jobs.end() && it->second->client == client && it->second->session == session) {
+                it->second->cancelled = true;
+                it->second->cancel_requested = true;
+                found = true;
+            }
+        }
+        if (!found) {
+            send(client, session, "error unknown job");
+        }
+    }
+
+    void handle_line(int client, long long session, const std::string& line) {
+        std::stringstream ss(line);
+        std::string command;
+        if (!(ss >> command)) {
+            return;
+        }
+        try {
+            if (command == "submit") {
+                submit(client, session, ss);
+            } else if (command == "cancel") {
+                cancel(client, session, ss);
+            } else {
+                send(client, session, "error unknown command " + command);
+            }
+        } catch (const std::exception& e) {
+            send(client, session, std::string("error ") + e.what());
+        }
+    }
+
+    void disconnect(int client) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& [id, job] : _jobs) {
+            if (job->client == client) {
+                job->cancelled = true;
+                job->cancel_requested = false;
+            }
+        }
+        _clients.erase(client);
+        close(client);
+    }
+
+    void accept_client() {
+        int client = accept(_listener, nullptr, nullptr);
+        if (client < 0) {
+            return;
+        }
+        fcntl(client, F_SETFL, O_NONBLOCK);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clients[client] = Client{};
+        _clients[client].session = _next_session++;
+    }
+
+    // returns false if the client has gone away
+    bool read_client(int client) {
+        char buffer[65536];
+        ssize_t size = read(client, buffer, sizeof(buffer));
+        if (size <= 0) {
+            return false;
+        }
+        std::vector<std::string> lines;
+        bool overflow = false;
+        long long session = -1;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Client& state = _clients[client];
+            session = state.session;
+            std::string& input = state.input;
+            input.append(buffer, size);
+            // only the new bytes can end a line
+            long long start = 0;
+            for (auto end = input.find('\n', state.scanned); end != std::string::npos; end = input.find('\n', start)) {
+                lines.push_back(input.substr(start, end - start));
+                start = end + 1;
+            }
+            input.erase(0, start);
+            state.scanned = input.size();
+            if ((long long)input.size() > MAX_LINE_SIZE) {
+                input.clear();
+                state.scanned = 0;
+                overflow = true;
+            }
+        }
+        for (auto& line : lines) {
+            if (line.compare(0, 6, "submit") == 0) {
+                // parsing takes time proportional to the line, keep it off the event loop
+                _pool.submit([this, client, session, line = std::move(line)] { handle_line(client, session, line); });
+            } else {
+                handle_line(client, session, line);
+            }
+        }
+        if (overflow) {
+            send(client, session, "error line is longer than " + std::to_string(MAX_LINE_SIZE) + " bytes");
+        }
+        return true;
+    }
+
+    bool write_client(int client) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::string& output = _clients[client].output;
+        ssize_t size = ::send(client, output.data(), output.size(), MSG_NOSIGNAL);
+        if (size < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        output.erase(0, size);
+        return true;
+    }
+
+    void listen_socket() {
+        if (pipe(_wakeup) < 0) {
+            throw std::runtime_error("Can not create wakeup pipe!");
+        }
+        fcntl(_wakeup[0], F_SETFL, O_NONBLOCK);
+        fcntl(_wakeup[1], F_SETFL, O_NONBLOCK);
+
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (_socket_path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Socket path is too long!");
+        }
+        _socket_path.copy(address.sun_path, _socket_path.size());
+        unlink(_socket_path.c_str());
+
+        _listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (_listener < 0 || bind(_listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(_listener, 128) < 0) {
+            throw std::runtime_error("Can not listen on " + _socket_path);
+        }
+        fcntl(_listener, F_SETFL, O_NONBLOCK);
+    }
+public:
+    SolverService(std::string socket_path, ConfigurationFile configuration = ConfigurationFile{},
+                  long long threads = std::thread::hardware_concurrency(), long long slice = 1000) :
+                  _socket_path(socket_path), _configuration(configuration), _slice(slice), _pool(threads) {
+        listen_socket();
+    }
+
+    SolverService(const SolverService&) = delete;
+    SolverService& operator=(const SolverService&) = delete;
+
+    ~SolverService() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto& [id, job] : _jobs) {
+                job->cancelled = true;
+            }
+            for (auto& [client, state] : _clients) {
+                close(client);
+            }
+        }
+        close(_listener);
+        close(_wakeup[0]);
+        close(_wakeup[1]);
+        unlink(_socket_path.c_str());
+    }
+
+    // serves clients until stop() is called
+    void run() {
+        _running = true;
+        while (_running) {
+            std::vector<pollfd> fds = {{_listener, POLLIN, 0}, {_wakeup[0], POLLIN, 0}};
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                for (const auto& [client, state] : _clients) {
+                    short events = POLLIN;
+                    if (!state.output.empty()) {
+                        events |= POLLOUT;
+                    }
+                    fds.push_back({client, events, 0});
+                }
+            }
+
+            if (poll(fds.data(), fds.size(), -1) < 0) {
+                continue; // interrupted by a signal
+            }
+
+            if (fds[1].revents & POLLIN) {
+                char buffer[256];
+                while (read(_wakeup[0], buffer, sizeof(buffer)) > 0) {}
+            }
+            for (long long i = 2; i < (long long)fds.size(); ++i) {
+                bool alive = true;
+                if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                    alive = read_client(fds[i].fd);
+                }
+                if (alive && (fds[i].revents & POLLOUT)) {
+                    alive = write_client(fds[i].fd);
+                }
+                if (!alive) {
+                    disconnect(fds[i].fd);
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                accept_client();
+            }
+        }
+    }
+
+    // safe to call from a signal handler
+    void stop() {
+        _running = false;
+        wake();
+    }
+
+    long long get_job_num() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _jobs.size();
+    }
+};
+
+#endif
@@ -12,24 +12,26 @@ class Annealing {
     ScheduleT _best_schedule;
     MutationT _mutation;
     TemperatureT _temperature;
+    long long _iteration = 0;
     long long _best_iteration = 0;
     long long _limit = 100;
 public:
-    Annealing(ScheduleT schedule, MutationT mutation, TemperatureT temperature) {
+    Annealing(ScheduleT schedule, MutationT mutation, TemperatureT temperature, long long limit = 100) {
+        _limit = limit;
         _current_schedule = schedule;
         _best_schedule = schedule;
         _mutation = mutation;
         _temperature = temperature;
     };
 
-    void start() {
-        long long iteration = 0;
-        while (iteration - _best_iteration <= _limit) {
+    // performs at most the given number of iterations, returns true once the search has stopped
+    bool step(long long iterations) {
+        for (long long i = 0; i < iterations && !finished(); ++i) {
             ScheduleT new_schedule = _mutation.mutate(_current_schedule);
             double delta = new_schedule.get_quality() - _current_schedule.get_quality();
             if (_best_schedule.get_quality() - new_schedule.get_quality() > 0) {
                 _best_schedule = new_schedule;
-                _best_iteration = iteration;
+                _best_iteration = _iteration;
                 _current_schedule = new_schedule;
             } else if (delta <= 0) {
                 _current_schedule = new_schedule;
@@ -40,8 +42,17 @@ public:
                 }
             }
             _temperature.decrease();
-            ++iteration;
+            ++_iteration;
         }
+        return finished();
+    }
+
+    bool finished() const {
+        return _iteration - _best_iteration > _limit;
+    }
+
+    void start() {
+        while (!step(_limit + 1)) {}
     }
 
     void parallel_start(ScheduleT& parallel_best_schedule, std::mutex& mutex) {
@@ -60,7 +71,7 @@ public:
 
 template<typename ScheduleT, typename MutationT, typename TemperatureT>
 ScheduleT ParallelAnnealing(long long Nproc, ScheduleT initial_schedule, MutationT mutation, 
-                            TemperatureT temperature, long long parallel_limit = 10) {
+                            TemperatureT temperature, long long parallel_limit = 10, long long limit = 100) {
     std::mutex mutex;
     ScheduleT parallel_best_schedule = initial_schedule;
     long long iteration = 0;
@@ -71,7 +82,7 @@ ScheduleT ParallelAnnealing(long long Nproc, ScheduleT initial_schedule, Mutatio
         std::vector<std::thread> threads;
 
         for (long long i = 0; i < Nproc; ++i) {
-            models.push_back(Annealing<ScheduleT, MutationT, TemperatureT>(initial_schedule, mutation, temperature));
+            models.push_back(Annealing<ScheduleT, MutationT, TemperatureT>(initial_schedule, mutation, temperature, limit));
         }
 
         for (long long i = 0; i < Nproc; ++i) {
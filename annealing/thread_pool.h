@@ -0,0 +1,78 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+    std::vector<std::thread> _workers{};
+    std::queue<std::function<void()>> _tasks{};
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopped = false;
+
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this] { return _stopped || !_tasks.empty(); });
+                if (_stopped && _tasks.empty()) {
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop();
+            }
+            task();
+        }
+    }
+public:
+    ThreadPool(long long threads = std::thread::hardware_concurrency()) {
+        if (threads < 1) {
+            threads = 1;
+        }
+        for (long long i = 0; i < threads; ++i) {
+            _workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _condition.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    long long size() const {
+        return _workers.size();
+    }
+
+    template<typename F>
+    auto submit(F function) -> std::future<decltype(function())> {
+        using ResultT = decltype(function());
+        // packaged_task is move-only, std::function needs a copyable callable
+        auto task = std::make_shared<std::packaged_task<ResultT()>>(std::move(function));
+        std::future<ResultT> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push([task] { (*task)(); });
+        }
+        _condition.notify_one();
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <chrono>
+#include <cstdlib>
+
+/**
+ * @brief Seven-point stencil on a grid^3 mesh with a dense block x block coupling per pair of nodes
+ *
+ * @param grid side of the mesh
+ * @param block unknowns per node
+ * @return Matrix<double>
+ */
+Matrix<double> elasticity(int grid, int block) {
+    int nodes = grid * grid * grid;
+    int n = nodes * block;
+    Matrix_builder<double> builder(n, n);
+    for (int v = 0; v < nodes; ++v) {
+        int x = v % grid, y = v / grid % grid, z = v / grid / grid;
+        for (int other : {v, v - 1, v + 1, v - grid, v + grid, v - grid * grid, v + grid * grid}) {
+            if (other < 0 || other >= nodes) {
+                continue;
+            }
+            int ox = other % grid, oy = other / grid % grid, oz = other / grid / grid;
+            if (other != v && std::abs(ox - x) + std::abs(oy - y) + std::abs(oz - z) != 1) {
+                continue;
+            }
+            for (int i = 0; i < block; ++i) {
+                for (int j = 0; j < block; ++j) {
+                    builder.add(v * block + i, other * block + j, other == v ? (i == j ? 8.0 : 0.5) : -0.25);
+                }
+            }
+        }
+    }
+    return builder.build();
+}
+
+template<typename F>
+double measure(F f, int repeats = 1) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int k = 0; k < repeats; ++k) {
+        f();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+}
+
+int main() {
+    std::cout << "block n nnz detected csr_spmv_ms bsr_spmv_ms csr_spgemm_ms bsr_spgemm_ms" << std::endl;
+    for (int block : {3, 4}) {
+        for (int grid : {16, 32}) {
+            Matrix<double> scalar = elasticity(grid, block);
+            int n = std::get<0>(scalar.get_dimentions());
+            std::vector<double> x(n, 1.0);
+            std::cout << block << " " << n << " " << scalar.nnz() << " " << scalar.block_size() << " "
+                      << measure([&] { scalar * x; }, 20);
+            visit_blocks(scalar, [&](const auto& blocked) {
+                std::cout << " " << measure([&] { blocked * x; }, 20);
+                std::cout << " " << measure([&] { scalar * scalar; }) << " " << measure([&] { blocked * blocked; });
+            });
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <chrono>
+#include <random>
+#include <thread>
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * @brief Fill builder with nnz random entries from given number of threads
+ *
+ * @param builder builder with a slot per thread
+ * @param nnz number of entries
+ * @param n dimention
+ */
+void fill(Matrix_builder<double>& builder, std::size_t nnz, int n) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < builder.slots(); ++t) {
+        threads.emplace_back([&builder, nnz, n, t] {
+            std::mt19937 generator(t);
+            std::size_t count = nnz / builder.slots();
+            builder.reserve(t, count);
+            for (std::size_t k = 0; k < count; ++k) {
+                builder.add(t, generator() % n, generator() % n, 1.0 + generator() % 9);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+int main() {
+    int max_threads = matrix_thread_count();
+    std::cout << "nnz threads element_ms fill_ms build_ms" << std::endl;
+    for (std::size_t nnz = 100000; nnz <= 10000000; nnz *= 10) {
+        int n = nnz / 4;
+        // element by element through the access operator
+        double element_ms = nnz <= 1000000 ? measure([nnz, n] {
+            std::mt19937 generator(0);
+            Matrix<double> a(n, n);
+            for (std::size_t k = 0; k < nnz; ++k) {
+                a(generator() % n, generator() % n) += 1.0 + generator() % 9;
+            }
+            a.nnz();
+        }) : 0;
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            set_matrix_threads(threads);
+            Matrix_builder<double> builder(n, n, threads);
+            double fill_ms = measure([&builder, nnz, n] { fill(builder, nnz, n); });
+            double build_ms = measure([&builder] { auto a = builder.build(); });
+            std::cout << nnz << " " << threads << " " << element_ms << " " << fill_ms << " " << build_ms << std::endl;
+        }
+    }
+    return 0;
+}
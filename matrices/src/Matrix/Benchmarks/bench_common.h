@@ -0,0 +1,113 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include "../Matrix.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+/**
+ * @brief Number of heap allocations and bytes allocated since start
+ *
+ * Counted by the replacements of global operator new below, so a benchmark
+ * includes this header from its only translation unit.
+ */
+inline std::atomic<std::size_t> allocations{0};
+inline std::atomic<std::size_t> allocated{0};
+
+/**
+ * @brief Allocate and count, alignment 0 is the default one of malloc
+ *
+ * @param size bytes
+ * @param alignment alignment
+ * @return void*
+ */
+inline void* counted_allocate(std::size_t size, std::size_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated.fetch_add(size, std::memory_order_relaxed);
+    size = std::max<std::size_t>(size, 1);
+    void* p = alignment == 0 ? std::malloc(size)
+                             : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(std::size_t size) {
+    return counted_allocate(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+    return counted_allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, std::size_t(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_allocate(size, std::size_t(alignment));
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+/**
+ * @brief Random square matrix with about nnz nonzeros
+ *
+ * @param n dimention
+ * @param nnz number of nonzeros
+ * @param seed seed
+ * @return Matrix<double>
+ */
+inline Matrix<double> random_matrix(int n, std::size_t nnz, int seed) {
+    std::mt19937 generator(seed);
+    Matrix_builder<double> builder(n, n);
+    builder.reserve(0, nnz);
+    for (std::size_t k = 0; k < nnz; ++k) {
+        builder.add(generator() % n, generator() % n, 1.0 + generator() % 9);
+    }
+    return builder.build();
+}
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+#endif
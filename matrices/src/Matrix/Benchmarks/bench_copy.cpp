@@ -0,0 +1,41 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "bench_common.h"
+#include "iostream"
+
+/**
+ * @brief Stage of a pipeline that takes and returns matrix by value, deep copies on request
+ *
+ * @param matrix matrix
+ * @param deep force a private copy of values
+ * @return Matrix<double>
+ */
+Matrix<double> stage(Matrix<double> matrix, bool deep) {
+    if (deep) {
+        matrix *= 1.0;
+    }
+    return matrix;
+}
+
+int main() {
+    const int stages = 10;
+    std::cout << "nnz deep_ms deep_mb shared_ms shared_mb" << std::endl;
+    for (std::size_t nnz = 100000; nnz <= 10000000; nnz *= 10) {
+        Matrix<double> a = random_matrix(nnz / 4, nnz, 1);
+        a.nnz();
+        double ms[2];
+        double mb[2];
+        for (int deep = 1; deep >= 0; --deep) {
+            std::size_t before = allocated;
+            ms[deep] = measure([&] {
+                std::vector<Matrix<double>> kept;
+                for (int s = 0; s < stages; ++s) {
+                    kept.push_back(stage(a, deep));
+                }
+            });
+            mb[deep] = (allocated - before) / 1e6;
+        }
+        std::cout << nnz << " " << ms[1] << " " << mb[1] << " " << ms[0] << " " << mb[0] << std::endl;
+    }
+    return 0;
+}
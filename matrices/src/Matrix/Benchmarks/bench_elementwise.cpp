@@ -0,0 +1,50 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "bench_common.h"
+#include "iostream"
+
+int main() {
+    std::cout << "nnz negated_sub_ms negated_sub_allocations sub_ms sub_allocations "
+              << "lookup_hadamard_ms hadamard_ms masked_ms" << std::endl;
+    for (std::size_t nnz = 10000; nnz <= 10000000; nnz *= 10) {
+        int n = nnz / 4;
+        Matrix<double> a = random_matrix(n, nnz, 1), b = random_matrix(n, nnz, 2);
+
+        // a - b through a negated copy of b
+        std::size_t before = allocations;
+        double negated_sub_ms = measure([&] {
+            Matrix<double> res = a;
+            res += Matrix<double>(-b);
+        });
+        std::size_t negated_sub_allocations = allocations - before;
+
+        before = allocations;
+        double sub_ms = measure([&] {
+            Matrix<double> res = a;
+            res -= b;
+        });
+        std::size_t sub_allocations = allocations - before;
+
+        // a .* b by looking up every nonzero of a in b
+        double lookup_hadamard_ms = measure([&] {
+            const auto& storage = a.storage();
+            Matrix_builder<double> builder(n, n);
+            for (int r = 0; r < n; ++r) {
+                for (std::size_t k = storage.ptr[r]; k < storage.ptr[r + 1]; ++k) {
+                    double value = b.at(r, storage.idx[k]);
+                    if (value != 0) {
+                        builder.add(r, storage.idx[k], storage.values[k] * value);
+                    }
+                }
+            }
+            auto res = builder.build();
+        });
+        double hadamard_ms = measure([&] { auto res = a.hadamard(b); });
+        double masked_ms = measure([&] { auto res = a.masked(b, true); });
+
+        std::cout << nnz << " " << negated_sub_ms << " " << negated_sub_allocations << " " << sub_ms << " "
+                  << sub_allocations << " " << lookup_hadamard_ms << " " << hadamard_ms << " " << masked_ms
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../../Rational_number/Rational_number.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <chrono>
+
+using Exact = Rational_number<long long>;
+
+/**
+ * @brief Discrete Laplacian on a path with ends of weight 3 / 2, its determinant is (n + 3) / 4
+ *
+ * @param n dimention
+ * @return Matrix<Exact>
+ */
+Matrix<Exact> laplacian(int n) {
+    Matrix_builder<Exact> builder(n, n);
+    for (int i = 0; i < n; ++i) {
+        builder.add(i, i, i == 0 || i == n - 1 ? Exact(3, 2) : Exact(2));
+        if (i > 0) {
+            builder.add(i, i - 1, Exact(-1));
+            builder.add(i - 1, i, Exact(-1));
+        }
+    }
+    return builder.build();
+}
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    std::cout << "n bareiss_det_ms modular_det_ms bareiss_solve_ms modular_solve_ms" << std::endl;
+    for (int n = 250; n <= 4000; n *= 2) {
+        Matrix<Exact> a = laplacian(n);
+        std::vector<Exact> b(n, Exact(1));
+        std::cout << n;
+        for (Exact_method method : {Exact_method::BAREISS, Exact_method::MODULAR}) {
+            std::cout << " " << measure([&a, method] { a.determinant(method); });
+        }
+        for (Exact_method method : {Exact_method::BAREISS, Exact_method::MODULAR}) {
+            std::cout << " " << measure([&a, &b, method] { a.solve(b, method); });
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "bench_common.h"
+#include "iostream"
+
+int main() {
+    std::cout << "nnz eager_ms eager_allocations fused_ms fused_allocations" << std::endl;
+    for (std::size_t nnz = 10000; nnz <= 10000000; nnz *= 10) {
+        int n = nnz / 4;
+        Matrix<double> a = random_matrix(n, nnz, 1), b = random_matrix(n, nnz, 2);
+        Matrix<double> c = random_matrix(n, nnz, 3), d = random_matrix(n, nnz, 4);
+
+        // a + b - 2c + d with a temporary matrix per operation
+        std::size_t before = allocations;
+        double eager_ms = measure([&] {
+            Matrix<double> res = a;
+            res += b;
+            Matrix<double> scaled = c;
+            scaled *= 2.0;
+            res += -scaled;
+            res += d;
+        });
+        std::size_t eager_allocations = allocations - before;
+
+        before = allocations;
+        double fused_ms = measure([&] { Matrix<double> res = a + b - 2.0 * c + d; });
+        std::size_t fused_allocations = allocations - before;
+
+        std::cout << nnz << " " << eager_ms << " " << eager_allocations << " "
+                  << fused_ms << " " << fused_allocations << std::endl;
+    }
+    return 0;
+}
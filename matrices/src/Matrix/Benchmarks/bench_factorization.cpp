@@ -0,0 +1,55 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <chrono>
+#include <optional>
+
+/**
+ * @brief Five-point Laplacian on a grid x grid mesh, convection makes it nonsymmetric
+ *
+ * @param grid side of the mesh
+ * @param convection difference of opposite off-diagonal values
+ * @return Matrix<double>
+ */
+Matrix<double> laplacian(int grid, double convection) {
+    int n = grid * grid;
+    Matrix_builder<double> builder(n, n);
+    for (int v = 0; v < n; ++v) {
+        builder.add(v, v, 4.0);
+        if (v % grid > 0) {
+            builder.add(v, v - 1, -1.0 - convection);
+            builder.add(v - 1, v, -1.0 + convection);
+        }
+        if (v >= grid) {
+            builder.add(v, v - grid, -1.0 - convection);
+            builder.add(v - grid, v, -1.0 + convection);
+        }
+    }
+    return builder.build();
+}
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    std::cout << "n nnz cholesky_nnz cholesky_ms cholesky_solve_ms lu_nnz lu_ms lu_solve_ms" << std::endl;
+    for (int grid = 50; grid <= 400; grid *= 2) {
+        Matrix<double> spd = laplacian(grid, 0.0);
+        Matrix<double> convective = laplacian(grid, 0.5);
+        std::vector<double> b(grid * grid, 1.0);
+        std::optional<Sparse_cholesky<double>> cholesky;
+        std::optional<Sparse_lu<double>> lu;
+        double cholesky_ms = measure([&] { cholesky.emplace(spd.cholesky()); });
+        double cholesky_solve_ms = measure([&] { cholesky->solve(b); });
+        double lu_ms = measure([&] { lu.emplace(convective.lu()); });
+        double lu_solve_ms = measure([&] { lu->solve(b); });
+        std::cout << grid * grid << " " << spd.nnz() << " " << cholesky->nnz() << " " << cholesky_ms << " "
+                  << cholesky_solve_ms << " " << lu->nnz() << " " << lu_ms << " " << lu_solve_ms << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../../Rational_number/Rational_number.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <chrono>
+#include <random>
+#include <sys/stat.h>
+
+using Value = Rational_number<long long>;
+
+/**
+ * @brief Random square matrix with about 4 nonzeros per row
+ *
+ * @param nnz number of nonzeros
+ * @return Matrix<Value>
+ */
+Matrix<Value> random_matrix(std::size_t nnz) {
+    int n = nnz / 4;
+    std::mt19937 generator(n);
+    Compressed_storage<Value> storage(n);
+    for (int r = 0; r < n; ++r) {
+        for (int k = 0; k < 4; ++k) {
+            // sorted distinct columns
+            storage.push_back(n / 4 * k + generator() % (n / 4), Value(1 + generator() % 99, 1 + generator() % 9));
+        }
+        storage.ptr[r + 1] = storage.nnz();
+    }
+    return Matrix<Value>({n, n}, storage);
+}
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+double megabytes(const std::string& filename) {
+    struct stat info;
+    stat(filename.c_str(), &info);
+    return info.st_size / 1e6;
+}
+
+int main() {
+    std::cout << "nnz text_mb text_save_ms text_load_ms binary_mb binary_save_ms binary_open_ms binary_load_ms"
+              << std::endl;
+    for (std::size_t nnz = 100000; nnz <= 100000000; nnz *= 10) {
+        Matrix<Value> a = random_matrix(nnz);
+        double text_save_ms = measure([&a] { a.save("bench_io.txt"); });
+        double text_load_ms = measure([] { Matrix<Value> b("bench_io.txt"); });
+        double binary_save_ms = measure([&a] { a.save_binary("bench_io.bin"); });
+        double binary_open_ms = measure([] { Binary_matrix_view<Value> view("bench_io.bin"); });
+        double binary_load_ms = measure([] { auto b = Matrix<Value>::load_binary("bench_io.bin"); });
+        std::cout << nnz << " " << megabytes("bench_io.txt") << " " << text_save_ms << " " << text_load_ms << " "
+                  << megabytes("bench_io.bin") << " " << binary_save_ms << " " << binary_open_ms << " "
+                  << binary_load_ms << std::endl;
+    }
+    std::remove("bench_io.txt");
+    std::remove("bench_io.bin");
+    return 0;
+}
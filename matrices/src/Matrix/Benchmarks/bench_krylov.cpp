@@ -0,0 +1,56 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+
+/**
+ * @brief Five-point Laplacian on a grid x grid mesh, convection makes it nonsymmetric
+ *
+ * @param grid side of the mesh
+ * @param convection difference of opposite off-diagonal values
+ * @return Matrix<double>
+ */
+Matrix<double> laplacian(int grid, double convection) {
+    int n = grid * grid;
+    Matrix_builder<double> builder(n, n);
+    for (int v = 0; v < n; ++v) {
+        builder.add(v, v, 4.0);
+        if (v % grid > 0) {
+            builder.add(v, v - 1, -1.0 - convection);
+            builder.add(v - 1, v, -1.0 + convection);
+        }
+        if (v >= grid) {
+            builder.add(v, v - grid, -1.0 - convection);
+            builder.add(v - grid, v, -1.0 + convection);
+        }
+    }
+    return builder.build();
+}
+
+int main() {
+    const char* methods[] = {"cg", "bicgstab", "gmres"};
+    const char* preconditioners[] = {"none", "jacobi", "ilu0", "ichol0"};
+    // CG runs on the symmetric matrix, the others on the convective one
+    std::vector<std::pair<Krylov_method, Preconditioner_type>> runs{
+        {Krylov_method::CG, Preconditioner_type::JACOBI},
+        {Krylov_method::CG, Preconditioner_type::ICHOL0},
+        {Krylov_method::BICGSTAB, Preconditioner_type::ILU0},
+        {Krylov_method::GMRES, Preconditioner_type::ILU0},
+    };
+    Solver_options options;
+    options.tolerance = 1e-6;
+    options.max_iterations = 10000;
+    std::cout << "n method preconditioner report" << std::endl;
+    for (int grid = 250; grid <= 1000; grid *= 2) {
+        Matrix<double> spd = laplacian(grid, 0.0);
+        Matrix<double> convective = laplacian(grid, 0.5);
+        std::vector<double> b(grid * grid, 1.0);
+        for (auto [method, type] : runs) {
+            std::vector<double> x;
+            const Matrix<double>& a = method == Krylov_method::CG ? spd : convective;
+            Solver_report report = a.iterative_solve(b, x, method, type, options);
+            std::cout << grid * grid << " " << methods[int(method)] << " " << preconditioners[int(type)] << " "
+                      << report << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/**
+ * @brief n x n matrix with a band of width 3 and per_row random entries per row, written tile row by tile row
+ *
+ * The matrix is never built in memory, only one row of tiles at a time.
+ *
+ * @param filename output file
+ * @param n size
+ * @param per_row random entries per row
+ * @param tile_size side of tiles
+ */
+void write_random(const std::string& filename, int n, int per_row, int tile_size) {
+    std::mt19937 random(3);
+    std::uniform_int_distribution<int> column(0, n - 1);
+    Tile_writer<double> writer(filename, {n, n}, tile_size);
+    auto [tile_rows, tile_columns] = writer.tiles();
+    for (int i = 0; i < tile_rows; ++i) {
+        Matrix_builder<double> builder(writer.tile_rows(i), n);
+        for (int r = 0; r < writer.tile_rows(i); ++r) {
+            int row = i * tile_size + r;
+            for (int c = std::max(0, row - 1); c <= std::min(n - 1, row + 1); ++c) {
+                builder.add(r, c, c == row ? 4.0 : -1.0);
+            }
+            for (int k = 0; k < per_row; ++k) {
+                builder.add(r, column(random), 0.5);
+            }
+        }
+        Matrix<double> strip = builder.build();
+        const auto& storage = strip.storage();
+        for (int j = 0; j < tile_columns; ++j) {
+            Compressed_storage<double> tile(writer.tile_rows(i));
+            for (int r = 0; r < writer.tile_rows(i); ++r) {
+                auto begin = storage.idx.begin() + storage.ptr[r], end = storage.idx.begin() + storage.ptr[r + 1];
+                for (auto it = std::lower_bound(begin, end, j * tile_size); it != end && *it < (j + 1) * tile_size;
+                     ++it) {
+                    tile.push_back(*it - j * tile_size, storage.values[it - storage.idx.begin()]);
+                }
+                tile.ptr[r + 1] = tile.nnz();
+            }
+            writer.write(i, j, tile);
+        }
+    }
+    writer.finish();
+}
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    const int n = 1000000;
+    const int tile_size = 1 << 16;
+    std::cout << "budget_mb write_ms transpose_ms add_ms multiply_ms product_nnz" << std::endl;
+    for (std::size_t budget_mb : {16, 256}) {
+        std::size_t budget = budget_mb << 20;
+        double write_ms = measure([&] { write_random("bench_a.tiles", n, 2, tile_size); });
+        Tiled_matrix<double> a("bench_a.tiles", budget);
+        double transpose_ms = 0, add_ms = 0, multiply_ms = 0;
+        std::size_t product_nnz = 0;
+        transpose_ms = measure([&] { a.transpose("bench_at.tiles"); });
+        Tiled_matrix<double> at("bench_at.tiles", budget);
+        add_ms = measure([&] { a.add(at, "bench_sum.tiles"); });
+        multiply_ms = measure([&] { product_nnz = a.multiply(at, "bench_product.tiles").nnz(); });
+        std::cout << budget_mb << " " << write_ms << " " << transpose_ms << " " << add_ms << " " << multiply_ms << " "
+                  << product_nnz << std::endl;
+        std::cout << "  a: " << a.statistics() << std::endl;
+        std::cout << "  a^T: " << at.statistics() << std::endl;
+    }
+    for (const char* name : {"bench_a.tiles", "bench_at.tiles", "bench_sum.tiles", "bench_product.tiles"}) {
+        std::remove(name);
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <chrono>
+#include <random>
+
+/**
+ * @brief Random square matrix with about nnz nonzeros (repeated cells are summed)
+ * 
+ * @param n dimention
+ * @param nnz number of generated entries
+ * @return Matrix<double> 
+ */
+Matrix<double> random_matrix(int n, std::size_t nnz) {
+    std::mt19937 generator(n);
+    Matrix_builder<double> builder(n, n);
+    for (std::size_t k = 0; k < nnz; ++k) {
+        int i = generator() % n, j = generator() % n;
+        builder.add(i, j, 1.0 + generator() % 9);
+    }
+    return builder.build();
+}
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main() {
+    int max_threads = matrix_thread_count();
+    std::cout << "threads dispatch_us" << std::endl;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::vector<int> bounds(threads + 1);
+        for (int t = 0; t <= threads; ++t) {
+            bounds[t] = t;
+        }
+        std::vector<int> sink(threads);
+        const int calls = 10000;
+        double ms = measure([&] {
+            for (int k = 0; k < calls; ++k) {
+                parallel_ranges(bounds, [&sink](int t, int, int) { ++sink[t]; });
+            }
+        });
+        std::cout << threads << " " << ms * 1000 / calls << std::endl;
+    }
+
+    std::cout << "nnz threads spgemm_ms spmv_ms" << std::endl;
+    for (std::size_t nnz = 10000; nnz <= 10000000; nnz *= 10) {
+        // about 4 nonzeros per row keeps the product size proportional to nnz
+        Matrix<double> a = random_matrix(nnz / 4, nnz);
+        std::vector<double> x(nnz / 4, 1.0);
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            set_matrix_threads(threads);
+            double spgemm_ms = measure([&a] { auto c = a * a; });
+            double spmv_ms = measure([&a, &x] { auto y = a * x; });
+            std::cout << nnz << " " << threads << " " << spgemm_ms << " " << spmv_ms << std::endl;
+        }
+    }
+    return 0;
+}
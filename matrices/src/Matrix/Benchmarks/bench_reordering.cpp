@@ -0,0 +1,68 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+/**
+ * @brief Seven-point stencil on a grid^3 mesh (five-point on grid^2 if flat) with randomly numbered vertices
+ *
+ * @param grid side of the mesh
+ * @param flat two-dimensional mesh
+ * @return Matrix<double>
+ */
+Matrix<double> scrambled_mesh(int grid, bool flat) {
+    int n = flat ? grid * grid : grid * grid * grid;
+    std::vector<int> label(n);
+    for (int v = 0; v < n; ++v) {
+        label[v] = v;
+    }
+    std::shuffle(label.begin(), label.end(), std::mt19937(7));
+    Matrix_builder<double> builder(n, n);
+    for (int v = 0; v < n; ++v) {
+        builder.add(label[v], label[v], 6.0);
+        for (int step : {1, grid, grid * grid}) {
+            if (flat && step == grid * grid) {
+                continue;
+            }
+            if (v / step % grid > 0) {
+                builder.add(label[v], label[v - step], -1.0);
+                builder.add(label[v - step], label[v], -1.0);
+            }
+        }
+    }
+    return builder.build();
+}
+
+template<typename F>
+double measure(F f, int repeats = 1) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int k = 0; k < repeats; ++k) {
+        f();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+}
+
+int main() {
+    std::cout << "mesh n ordering ordering_ms permute_ms bandwidth profile spmv_ms" << std::endl;
+    for (auto [grid, flat] : {std::pair{1000, true}, std::pair{96, false}}) {
+        Matrix<double> scrambled = scrambled_mesh(grid, flat);
+        int n = std::get<0>(scrambled.get_dimentions());
+        std::vector<double> x(n, 1.0);
+        std::string mesh = flat ? "2d" : "3d";
+        std::cout << mesh << " " << n << " none 0 0 " << scrambled.bandwidth() << " " << scrambled.profile() << " "
+                  << measure([&] { scrambled * x; }, 20) << std::endl;
+        for (auto [method, name] : {std::pair{Reordering::RCM, "rcm"}, std::pair{Reordering::PARTITION, "partition"}}) {
+            Matrix<double> reordered = scrambled;
+            std::vector<int> order;
+            double ordering_ms = measure([&] { order = reordered.ordering(method); });
+            double permute_ms = measure([&] { reordered.permute(order); });
+            std::cout << mesh << " " << n << " " << name << " " << ordering_ms << " " << permute_ms << " "
+                      << reordered.bandwidth() << " " << reordered.profile() << " "
+                      << measure([&] { reordered * x; }, 20) << std::endl;
+        }
+    }
+    return 0;
+}
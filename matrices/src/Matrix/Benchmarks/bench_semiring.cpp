@@ -0,0 +1,154 @@
+#include "../../Exceptions/Exceptions.h"
+#include "../Matrix.h"
+#include "iostream"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/**
+ * @brief Undirected R-MAT graph with weights 1..9 saved in Matrix Market format
+ *
+ * @param filename output file
+ * @param scale log2 of the number of vertices
+ * @param edge_factor edges per vertex
+ */
+void write_rmat(const std::string& filename, int scale, int edge_factor) {
+    int n = 1 << scale;
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int> weight(1, 9);
+    Matrix_builder<double> builder(n, n);
+    for (long long e = 0; e < (long long)edge_factor * n; ++e) {
+        int from = 0, to = 0;
+        for (int bit = 0; bit < scale; ++bit) {
+            double p = uniform(random);
+            int row = p > 0.57 + 0.19 ? 1 : 0;
+            int column = (p > 0.57 && p <= 0.57 + 0.19) || p > 0.57 + 0.19 + 0.19 ? 1 : 0;
+            from |= row << bit;
+            to |= column << bit;
+        }
+        if (from != to) {
+            double w = weight(random);
+            builder.add(from, to, w);
+            builder.add(to, from, w);
+        }
+    }
+    builder.build().save_matrix_market(filename);
+}
+
+template<typename F>
+double measure(F f) {
+    auto start = std::chrono::high_resolution_clock::now();
+    f();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+/**
+ * @brief Direction-optimizing BFS: push while the frontier is small, masked pull otherwise
+ *
+ * @return int number of levels
+ */
+int bfs(const Matrix<double>& graph, int source) {
+    int n = std::get<0>(graph.get_dimentions());
+    std::vector<char> visited(n, 0);
+    std::vector<double> frontier(n, 0.0);
+    frontier[source] = 1;
+    visited[source] = 1;
+    int levels = 0;
+    for (std::size_t size = 1; size > 0; ++levels) {
+        std::vector<double> next(n, 0.0);
+        if (size * 20 < std::size_t(n)) {
+            graph.vxm<Or_and<double>>(next, frontier, Vector_mask{&visited, true});
+        } else {
+            graph.mxv<Or_and<double>>(next, frontier, Vector_mask{&visited, true});
+        }
+        size = 0;
+        for (int v = 0; v < n; ++v) {
+            if (next[v] != 0) {
+                visited[v] = 1;
+                ++size;
+            }
+        }
+        frontier.swap(next);
+    }
+    return levels;
+}
+
+/**
+ * @brief Bellman-Ford in (min, +) with a min accumulator
+ *
+ * @return int number of rounds
+ */
+int shortest_paths(const Matrix<double>& graph, int source) {
+    int n = std::get<0>(graph.get_dimentions());
+    std::vector<double> distances(n, Min_plus<double>::zero());
+    distances[source] = 0;
+    int rounds = 0;
+    for (bool changed = true; changed; ++rounds) {
+        std::vector<double> next = distances;
+        graph.mxv<Min_plus<double>>(next, distances, {}, Semiring_accumulator<Min_plus<double>>());
+        changed = next != distances;
+        distances.swap(next);
+    }
+    return rounds;
+}
+
+int main() {
+    std::string filename = "bench_semiring.mtx";
+    std::cout << "scale n nnz load_ms threads bfs_ms levels sssp_ms rounds triangles_ms triangles" << std::endl;
+    for (int scale : {16, 18}) {
+        write_rmat(filename, scale, 16);
+        Matrix<double> graph;
+        double load_ms = measure([&] { graph = Matrix<double>(filename); });
+        int n = std::get<0>(graph.get_dimentions());
+        // vertices relabeled by decreasing degree keep the rows of hubs in L short, triangles
+        // are counted as C<L> = L L^T by dot products of rows of L
+        const auto& storage = graph.storage();
+        std::vector<int> order(n);
+        for (int v = 0; v < n; ++v) {
+            order[v] = v;
+        }
+        std::stable_sort(order.begin(), order.end(), [&storage](int u, int v) {
+            return storage.ptr[u + 1] - storage.ptr[u] > storage.ptr[v + 1] - storage.ptr[v];
+        });
+        std::vector<int> label(n);
+        for (int k = 0; k < n; ++k) {
+            label[order[k]] = k;
+        }
+        Matrix_builder<double> builder(n, n);
+        for (int r = 0; r < n; ++r) {
+            for (std::size_t k = storage.ptr[r]; k < storage.ptr[r + 1]; ++k) {
+                if (label[storage.idx[k]] < label[r]) {
+                    builder.add(label[r], label[storage.idx[k]], 1.0);
+                }
+            }
+        }
+        Matrix<double> lower = builder.build();
+        Matrix<double> upper = ~lower;
+        int hardware = matrix_thread_count();
+        for (int threads : {1, hardware}) {
+            set_matrix_threads(threads);
+            int levels = 0, rounds = 0;
+            double triangles = 0;
+            double bfs_ms = measure([&] { levels = bfs(graph, 0); });
+            double sssp_ms = measure([&] { rounds = shortest_paths(graph, 0); });
+            double triangles_ms = measure([&] {
+                Matrix<double> wedges = lower.mxm<Plus_times<double>>(upper, lower);
+                for (double value : wedges.storage().values) {
+                    triangles += value;
+                }
+            });
+            std::cout << scale << " " << n << " " << graph.nnz() << " " << load_ms << " " << threads << " " << bfs_ms
+                      << " " << levels << " " << sssp_ms << " " << rounds << " " << triangles_ms << " "
+                      << triangles << std::endl;
+            if (hardware == 1) {
+                break;
+            }
+        }
+        set_matrix_threads(hardware);
+    }
+    std::remove(filename.c_str());
+    return 0;
+}
@@ -0,0 +1,178 @@
+#ifndef BLOCK_MATRIX_H
+#define BLOCK_MATRIX_H
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Block_storage.h"
+#include "../Exceptions/Exceptions.h"
+
+template<typename T>
+class Matrix;
+
+/**
+ * @brief Block-sparse matrix with B x B dense blocks (BSR)
+ *
+ * Meant for matrices with dense sub-blocks, e.g. several unknowns per mesh
+ * node: one column index serves B * B values and products run fixed-size
+ * micro-kernels. Structural zeros inside stored blocks are kept.
+ *
+ * @tparam T
+ * @tparam B block size
+ */
+template<typename T, int B>
+class Block_matrix {
+    /**
+     * @brief dimentions of matrix (rows, columns) before padding
+     */
+    std::tuple<int, int> _dimentions{0, 0};
+    /**
+     * @brief blocks
+     */
+    Block_storage<T, B> _storage{};
+    /**
+     * @brief epsilon of the scalar matrix
+     */
+    double _eps = 0.0001;
+public:
+    /**
+     * @brief Constructor of zero matrix
+     *
+     * @param n number of rows
+     * @param m number of columns
+     */
+    Block_matrix(int n = 0, int m = 0) : _dimentions(n, m), _storage((n + B - 1) / B) {}
+
+    /**
+     * @brief Constructor from blocks
+     *
+     * @param dimentions dimentions of matrix
+     * @param storage blocks covering the dimentions
+     * @param eps epsilon
+     */
+    Block_matrix(const std::tuple<int, int>& dimentions, Block_storage<T, B> storage, double eps = 0.0001) :
+            _dimentions(dimentions), _storage(std::move(storage)), _eps(eps) {
+        if (_storage.major() != (std::get<0>(dimentions) + B - 1) / B) {
+            throw MatrixException("Wrong input - block rows do not cover the matrix!");
+        }
+    }
+
+    /**
+     * @brief Constructor from scalar matrix
+     *
+     * @param matrix matrix
+     */
+    explicit Block_matrix(const Matrix<T>& matrix) :
+            _dimentions(matrix.get_dimentions()),
+            _storage(Block_storage<T, B>::from_scalar(matrix.storage(), std::get<1>(matrix.get_dimentions()))),
+            _eps(matrix.get_eps()) {}
+
+    /**
+     * @brief Scalar matrix with the same values
+     *
+     * @return Matrix<T>
+     */
+    Matrix<T> to_matrix() const {
+        return Matrix<T>(_dimentions, _storage.to_scalar(std::get<0>(_dimentions), std::get<1>(_dimentions)), _eps);
+    }
+
+    /**
+     * @brief Get the dimentions of matrix
+     *
+     * @return std::tuple<int, int>
+     */
+    std::tuple<int, int> get_dimentions() const {
+        return _dimentions;
+    }
+
+    /**
+     * @brief Get blocks of matrix
+     *
+     * @return const Block_storage<T, B>&
+     */
+    const Block_storage<T, B>& storage() const {
+        return _storage;
+    }
+
+    /**
+     * @brief Number of stored blocks
+     *
+     * @return std::size_t
+     */
+    std::size_t blocks() const {
+        return _storage.blocks();
+    }
+
+    /**
+     * @brief Block size
+     *
+     * @return int
+     */
+    static constexpr int block_size() {
+        return B;
+    }
+
+    /**
+     * @brief Matrix * vector operator
+     *
+     * @param lhs left matrix
+     * @param x vector of size equal to the number of columns
+     * @return std::vector<T>
+     */
+    friend std::vector<T> operator*(const Block_matrix& lhs, const std::vector<T>& x) {
+        int columns = std::get<1>(lhs._dimentions);
+        if (int(x.size()) != columns) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        std::vector<T> res;
+        if (columns % B == 0) {
+            res = block_spmv(lhs._storage, x);
+        } else {
+            std::vector<T> padded(x);
+            padded.resize(std::size_t(columns + B - 1) / B * B, T());
+            res = block_spmv(lhs._storage, padded);
+        }
+        res.resize(std::get<0>(lhs._dimentions));
+        return res;
+    }
+
+    /**
+     * @brief * operator
+     *
+     * @param lhs left matrix
+     * @param rhs right matrix
+     * @return Block_matrix
+     */
+    friend Block_matrix operator*(const Block_matrix& lhs, const Block_matrix& rhs) {
+        if (std::get<1>(lhs._dimentions) != std::get<0>(rhs._dimentions)) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        int columns = std::get<1>(rhs._dimentions);
+        return Block_matrix({std::get<0>(lhs._dimentions), columns},
+                            block_spgemm(lhs._storage, rhs._storage, (columns + B - 1) / B), lhs._eps);
+    }
+};
+
+/**
+ * @brief Call f with the matrix converted to the block size detected from its pattern
+ *
+ * The size is chosen at run time by detect_block_size, f receives
+ * Block_matrix<T, B> for B from BLOCK_SIZES and runs the kernels compiled for it.
+ *
+ * @param matrix scalar matrix, e.g. just loaded from a file
+ * @param f generic callable taking const Block_matrix<T, B>&
+ */
+template<typename T, typename Function>
+void visit_blocks(const Matrix<T>& matrix, Function f) {
+    switch (detect_block_size(matrix.storage(), std::get<1>(matrix.get_dimentions()))) {
+        case 2: f(Block_matrix<T, 2>(matrix)); break;
+        case 3: f(Block_matrix<T, 3>(matrix)); break;
+        case 4: f(Block_matrix<T, 4>(matrix)); break;
+        case 6: f(Block_matrix<T, 6>(matrix)); break;
+        case 8: f(Block_matrix<T, 8>(matrix)); break;
+        default: f(Block_matrix<T, 1>(matrix)); break;
+    }
+}
+
+#endif
@@ -0,0 +1,400 @@
+#ifndef BLOCK_STORAGE_H
+#define BLOCK_STORAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Dense_kernels.h"
+#include "Parallel_kernels.h"
+#include "Spgemm.h"
+
+// vector registers are only passed between functions compiled for the same target
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+/**
+ * @brief Block sizes with compiled kernels, 1 is the scalar layout
+ */
+const int BLOCK_SIZES[] = {1, 2, 3, 4, 6, 8};
+
+/**
+ * @brief Block compressed sparse rows (BSR): CSR over B x B dense blocks
+ *
+ * Block k of block row i covers rows from i * B and columns from idx[k] * B,
+ * its values are stored column-major at values[k * B * B]. Dimensions that are not
+ * multiples of B are padded with zeros.
+ *
+ * @tparam T
+ * @tparam B block size
+ */
+template<typename T, int B>
+struct Block_storage {
+    static_assert(B > 0, "Block size must be positive");
+    static const int area = B * B;
+
+    std::vector<std::size_t> ptr{0};
+    std::vector<int> idx{};
+    std::vector<T> values{};
+
+    Block_storage() = default;
+
+    /**
+     * @brief Constructor of empty storage
+     *
+     * @param block_rows number of block rows
+     */
+    explicit Block_storage(int block_rows) : ptr(block_rows + 1, 0) {}
+
+    /**
+     * @brief Number of block rows
+     */
+    int major() const {
+        return ptr.size() - 1;
+    }
+
+    /**
+     * @brief Number of stored blocks
+     */
+    std::size_t blocks() const {
+        return idx.size();
+    }
+
+    /**
+     * @brief Values of block k
+     */
+    const T* block(std::size_t k) const {
+        return values.data() + k * area;
+    }
+
+    T* block(std::size_t k) {
+        return values.data() + k * area;
+    }
+
+    /**
+     * @brief Blocks of scalar CSR, every block with a nonzero is stored whole
+     *
+     * @param a scalar storage (CSR)
+     * @param columns number of columns
+     * @return Block_storage
+     */
+    static Block_storage from_scalar(const Compressed_storage<T>& a, int columns) {
+        int rows = a.major();
+        int block_rows = (rows + B - 1) / B;
+        Block_storage res(block_rows);
+        // position of the block of every block column in the current block row, -1 if none
+        std::vector<long long> slot((columns + B - 1) / B, -1);
+        std::vector<int> found;
+        for (int i = 0; i < block_rows; ++i) {
+            int first = i * B;
+            int last = std::min(rows, first + B);
+            found.clear();
+            for (int r = first; r < last; ++r) {
+                for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                    int j = a.idx[k] / B;
+                    if (slot[j] == -1) {
+                        slot[j] = 0;
+                        found.push_back(j);
+                    }
+                }
+            }
+            std::sort(found.begin(), found.end());
+            std::size_t base = res.idx.size();
+            for (std::size_t t = 0; t < found.size(); ++t) {
+                slot[found[t]] = base + t;
+            }
+            res.idx.insert(res.idx.end(), found.begin(), found.end());
+            res.values.resize(res.idx.size() * area, T());
+            for (int r = first; r < last; ++r) {
+                for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                    int c = a.idx[k];
+                    res.block(slot[c / B])[(c % B) * B + r % B] = a.values[k];
+                }
+            }
+            for (int j : found) {
+                slot[j] = -1;
+            }
+            res.ptr[i + 1] = res.idx.size();
+        }
+        return res;
+    }
+
+    /**
+     * @brief Scalar CSR of the first rows x columns values, zeros of blocks are dropped
+     *
+     * @param rows number of rows
+     * @param columns number of columns
+     * @return Compressed_storage<T>
+     */
+    Compressed_storage<T> to_scalar(int rows, int columns) const {
+        Compressed_storage<T> res(rows);
+        for (int r = 0; r < rows; ++r) {
+            int i = r / B;
+            for (std::size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                const T* values = block(k);
+                for (int j = 0; j < B && idx[k] * B + j < columns; ++j) {
+                    const T& value = values[j * B + r % B];
+                    if (value != T()) {
+                        res.push_back(idx[k] * B + j, value);
+                    }
+                }
+            }
+            res.ptr[r + 1] = res.nnz();
+        }
+        return res;
+    }
+};
+
+/**
+ * @brief Call f(0), ..., f(N - 1) without a loop, so indices of fixed-size arrays are constants
+ */
+template<typename Function, int... I>
+inline void unroll(std::integer_sequence<int, I...>, Function f) {
+    (f(I), ...);
+}
+
+/**
+ * @brief Fixed-size micro-kernel y += sum of A_k x_k over count column-major B x B blocks
+ *
+ * The B values of y stay in registers over all blocks: columns of a block are
+ * whole registers when B is a multiple of the width of Simd, otherwise the
+ * block is unrolled into B * B scalar multiply-adds.
+ *
+ * @param a values of consecutive blocks
+ * @param columns block columns of the blocks, nullptr for a single block applied to x
+ * @param count number of blocks
+ * @param x vector, block column c starts at x + c * B
+ * @param y output of B values
+ */
+template<typename Simd, typename T, int B>
+MATRIX_SIMD_INLINE inline void block_multiply_vector(const T* a, const int* columns, std::size_t count, const T* x,
+                                                     T* y) {
+    if constexpr (Simd::enabled) {
+        if constexpr (B % Simd::width == 0) {
+            constexpr int registers = B / Simd::width;
+            typename Simd::Register acc[registers];
+            for (int t = 0; t < registers; ++t) {
+                acc[t] = Simd::load(y + t * Simd::width);
+            }
+            for (std::size_t k = 0; k < count; ++k, a += B * B) {
+                const T* right = columns == nullptr ? x : x + std::size_t(columns[k]) * B;
+                for (int j = 0; j < B; ++j) {
+                    auto value = Simd::broadcast(right[j]);
+                    for (int t = 0; t < registers; ++t) {
+                        acc[t] = Simd::fma(Simd::load(a + j * B + t * Simd::width), value, acc[t]);
+                    }
+                }
+            }
+            for (int t = 0; t < registers; ++t) {
+                Simd::store(y + t * Simd::width, acc[t]);
+            }
+            return;
+        }
+    }
+    T acc[B];
+    for (int i = 0; i < B; ++i) {
+        acc[i] = y[i];
+    }
+    auto indices = std::make_integer_sequence<int, B>();
+    for (std::size_t k = 0; k < count; ++k, a += B * B) {
+        const T* right = columns == nullptr ? x : x + std::size_t(columns[k]) * B;
+        unroll(indices, [&](int j) {
+            const T& value = right[j];
+            unroll(indices, [&](int i) { acc[i] += a[j * B + i] * value; });
+        });
+    }
+    for (int i = 0; i < B; ++i) {
+        y[i] = acc[i];
+    }
+}
+
+/**
+ * @brief Fixed-size micro-kernel C += A B for column-major B x B blocks
+ *
+ * Column j of C gains A times column j of B.
+ */
+template<typename Simd, typename T, int B>
+MATRIX_SIMD_INLINE inline void block_multiply(const T* a, const T* b, T* c) {
+    for (int j = 0; j < B; ++j) {
+        block_multiply_vector<Simd, T, B>(a, nullptr, 1, b + j * B, c + j * B);
+    }
+}
+
+/**
+ * @brief Block SpMV y = A x, block rows are split between threads
+ *
+ * @param a block storage
+ * @param x vector padded to a multiple of B
+ * @param threads number of threads
+ * @return std::vector<T> result padded to a multiple of B
+ */
+template<typename T, int B>
+std::vector<T> block_spmv(const Block_storage<T, B>& a, const std::vector<T>& x, int threads = matrix_thread_count()) {
+    int block_rows = a.major();
+    std::vector<T> y(std::size_t(block_rows) * B, T());
+    std::vector<std::size_t> work(block_rows);
+    for (int i = 0; i < block_rows; ++i) {
+        work[i] = (a.ptr[i + 1] - a.ptr[i]) * a.area;
+    }
+    threads = useful_threads(a.values.size(), threads);
+    parallel_ranges(partition_rows(work, threads), [&](int, int first, int last) {
+        simd_dispatch<T>([&](auto simd) MATRIX_SIMD_INLINE {
+            for (int i = first; i < last; ++i) {
+                block_multiply_vector<decltype(simd), T, B>(a.block(a.ptr[i]), a.idx.data() + a.ptr[i],
+                                                            a.ptr[i + 1] - a.ptr[i], x.data(),
+                                                            y.data() + std::size_t(i) * B);
+            }
+        });
+    });
+    return y;
+}
+
+/**
+ * @brief Block SpGEMM by rows of blocks (Gustavson)
+ *
+ * The symbolic phase counts the block columns of every block row, the numeric
+ * phase sorts them and accumulates products of blocks in place. Blocks whose
+ * values cancel stay stored.
+ *
+ * @param a left storage
+ * @param b right storage
+ * @param block_columns number of block columns of b
+ * @param threads number of threads
+ * @return Block_storage<T, B>
+ */
+template<typename T, int B>
+Block_storage<T, B> block_spgemm(const Block_storage<T, B>& a, const Block_storage<T, B>& b, int block_columns,
+                                 int threads = matrix_thread_count()) {
+    int block_rows = a.major();
+    std::vector<std::size_t> work(block_rows, 0);
+    std::size_t total = 0;
+    for (int i = 0; i < block_rows; ++i) {
+        for (std::size_t k = a.ptr[i]; k < a.ptr[i + 1]; ++k) {
+            work[i] += b.ptr[a.idx[k] + 1] - b.ptr[a.idx[k]];
+        }
+        total += work[i] * B * a.area;
+    }
+    std::vector<int> bounds = partition_rows(work, useful_threads(total, threads));
+    int parts = bounds.size() - 1;
+    std::vector<std::vector<long long>> slots(parts);
+
+    std::vector<std::size_t> counts(block_rows);
+    parallel_ranges(bounds, [&](int t, int first, int last) {
+        auto& slot = slots[t];
+        slot.assign(block_columns, -1);
+        for (int i = first; i < last; ++i) {
+            std::size_t count = 0;
+            for (std::size_t k = a.ptr[i]; k < a.ptr[i + 1]; ++k) {
+                int c = a.idx[k];
+                for (std::size_t s = b.ptr[c]; s < b.ptr[c + 1]; ++s) {
+                    if (slot[b.idx[s]] != i) {
+                        slot[b.idx[s]] = i;
+                        ++count;
+                    }
+                }
+            }
+            counts[i] = count;
+        }
+    });
+
+    Block_storage<T, B> res(block_rows);
+    res.ptr = counts_to_offsets(counts);
+    res.idx.resize(res.ptr[block_rows]);
+    res.values.resize(res.ptr[block_rows] * res.area, T());
+    parallel_ranges(bounds, [&](int t, int first, int last) {
+        auto& slot = slots[t];
+        std::fill(slot.begin(), slot.end(), -1);
+        for (int i = first; i < last; ++i) {
+            int* columns = res.idx.data() + res.ptr[i];
+            std::size_t count = 0;
+            for (std::size_t k = a.ptr[i]; k < a.ptr[i + 1]; ++k) {
+                int c = a.idx[k];
+                for (std::size_t s = b.ptr[c]; s < b.ptr[c + 1]; ++s) {
+                    if (slot[b.idx[s]] == -1) {
+                        slot[b.idx[s]] = 0;
+                        columns[count++] = b.idx[s];
+                    }
+                }
+            }
+            std::sort(columns, columns + count);
+            for (std::size_t q = 0; q < count; ++q) {
+                slot[columns[q]] = res.ptr[i] + q;
+            }
+            simd_dispatch<T>([&](auto simd) MATRIX_SIMD_INLINE {
+                for (std::size_t k = a.ptr[i]; k < a.ptr[i + 1]; ++k) {
+                    int c = a.idx[k];
+                    for (std::size_t s = b.ptr[c]; s < b.ptr[c + 1]; ++s) {
+                        block_multiply<decltype(simd), T, B>(a.block(k), b.block(s), res.block(slot[b.idx[s]]));
+                    }
+                }
+            });
+            for (std::size_t q = 0; q < count; ++q) {
+                slot[columns[q]] = -1;
+            }
+        }
+    });
+    return res;
+}
+
+/**
+ * @brief Number of B x B blocks holding the nonzeros of scalar CSR
+ *
+ * @param a scalar storage (CSR)
+ * @param columns number of columns
+ * @param size block size
+ * @return std::size_t
+ */
+template<typename T>
+std::size_t count_blocks(const Compressed_storage<T>& a, int columns, int size) {
+    std::vector<int> seen((columns + size - 1) / size, -1);
+    std::size_t res = 0;
+    for (int r = 0; r < a.major(); ++r) {
+        int i = r / size;
+        for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+            int j = a.idx[k] / size;
+            if (seen[j] != i) {
+                seen[j] = i;
+                ++res;
+            }
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief Block size with the least memory traffic of SpMV
+ *
+ * Scalar CSR moves one value and one column index per nonzero, BSR moves B * B
+ * values and one index per block. The size of BLOCK_SIZES with the least
+ * bytes is chosen, explicit zeros padding the blocks count in full.
+ *
+ * @param a scalar storage (CSR)
+ * @param columns number of columns
+ * @return int block size, 1 if no blocking pays off
+ */
+template<typename T>
+int detect_block_size(const Compressed_storage<T>& a, int columns) {
+    int res = 1;
+    double best = double(a.nnz()) * (sizeof(T) + sizeof(int));
+    for (int size : BLOCK_SIZES) {
+        if (size == 1) {
+            continue;
+        }
+        double blocks = count_blocks(a, columns, size);
+        double bytes = blocks * (double(size) * size * sizeof(T) + sizeof(int));
+        if (bytes < best) {
+            best = bytes;
+            res = size;
+        }
+    }
+    return res;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
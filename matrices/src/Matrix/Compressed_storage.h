@@ -0,0 +1,189 @@
+#ifndef COMPRESSED_STORAGE_H
+#define COMPRESSED_STORAGE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <vector>
+
+/**
+ * @brief Compressed sparse storage (CSR when the major dimention is rows)
+ *
+ * Nonzeros of major line r are idx[ptr[r]..ptr[r + 1]) and values[ptr[r]..ptr[r + 1]),
+ * minor indices are sorted inside every line. Read column-major, the same arrays
+ * describe the transposed matrix, so transposed() also converts CSR to CSC.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Compressed_storage {
+    /**
+     * @brief Offsets of major lines, size is major + 1
+     */
+    std::vector<std::size_t> ptr{0};
+    /**
+     * @brief Minor indices of nonzeros
+     */
+    std::vector<int> idx{};
+    /**
+     * @brief Values of nonzeros
+     */
+    std::vector<T> values{};
+
+    /**
+     * @brief Constructor
+     *
+     * @param major number of major lines
+     */
+    explicit Compressed_storage(int major = 0) : ptr(major + 1, 0) {}
+
+    /**
+     * @brief Number of major lines
+     *
+     * @return int
+     */
+    int major() const {
+        return ptr.size() - 1;
+    }
+
+    /**
+     * @brief Number of nonzeros
+     *
+     * @return std::size_t
+     */
+    std::size_t nnz() const {
+        return idx.size();
+    }
+
+    /**
+     * @brief Position of element in idx/values
+     *
+     * @param i major index
+     * @param j minor index
+     * @return std::size_t position or nnz() if element is zero
+     */
+    std::size_t find(int i, int j) const {
+        auto begin = idx.begin() + ptr[i];
+        auto end = idx.begin() + ptr[i + 1];
+        auto it = std::lower_bound(begin, end, j);
+        if (it == end || *it != j) {
+            return nnz();
+        }
+        return it - idx.begin();
+    }
+
+    /**
+     * @brief Append nonzero to the last started line
+     *
+     * @param j minor index
+     * @param value value
+     */
+    void push_back(int j, const T& value) {
+        idx.push_back(j);
+        values.push_back(value);
+    }
+
+    /**
+     * @brief Remove elements for which predicate holds, in one pass
+     *
+     * @param is_zero predicate
+     */
+    template<typename Predicate>
+    void remove_if(Predicate is_zero) {
+        std::size_t out = 0;
+        std::size_t begin = 0;
+        for (int r = 0; r < major(); ++r) {
+            std::size_t end = ptr[r + 1];
+            for (std::size_t k = begin; k < end; ++k) {
+                if (!is_zero(values[k])) {
+                    idx[out] = idx[k];
+                    values[out] = std::move(values[k]);
+                    ++out;
+                }
+            }
+            begin = end;
+            ptr[r + 1] = out;
+        }
+        idx.resize(out);
+        values.resize(out);
+    }
+
+    /**
+     * @brief Storage of the transposed matrix (counting sort by minor index)
+     *
+     * @param minor number of minor lines
+     * @return Compressed_storage
+     */
+    Compressed_storage transposed(int minor) const {
+        Compressed_storage res(minor);
+        for (int j : idx) {
+            ++res.ptr[j + 1];
+        }
+        for (int c = 0; c < minor; ++c) {
+            res.ptr[c + 1] += res.ptr[c];
+        }
+        res.idx.resize(nnz());
+        res.values.resize(nnz());
+        std::vector<std::size_t> next(res.ptr.begin(), res.ptr.end() - 1);
+        for (int r = 0; r < major(); ++r) {
+            for (std::size_t k = ptr[r]; k < ptr[r + 1]; ++k) {
+                std::size_t pos = next[idx[k]]++;
+                res.idx[pos] = r;
+                res.values[pos] = values[k];
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Build storage from map-based representation
+     *
+     * @param data map from (major, minor) to value
+     * @param major number of major lines
+     * @return Compressed_storage
+     */
+    static Compressed_storage from_map(const std::map<std::tuple<int, int>, T>& data, int major) {
+        Compressed_storage res(major);
+        res.idx.reserve(data.size());
+        res.values.reserve(data.size());
+        for (const auto& [key, value] : data) {
+            auto [i, j] = key;
+            ++res.ptr[i + 1];
+            res.push_back(j, value);
+        }
+        for (int r = 0; r < major; ++r) {
+            res.ptr[r + 1] += res.ptr[r];
+        }
+        return res;
+    }
+
+    /**
+     * @brief Convert storage to map-based representation
+     *
+     * @return std::map<std::tuple<int, int>, T>
+     */
+    std::map<std::tuple<int, int>, T> to_map() const {
+        std::map<std::tuple<int, int>, T> data;
+        for (int r = 0; r < major(); ++r) {
+            for (std::size_t k = ptr[r]; k < ptr[r + 1]; ++k) {
+                data.emplace_hint(data.end(), std::tuple<int, int>{r, idx[k]}, values[k]);
+            }
+        }
+        return data;
+    }
+
+    /**
+     * @brief == operator
+     *
+     * @param lhs left storage
+     * @param rhs right storage
+     * @return true
+     * @return false
+     */
+    friend bool operator==(const Compressed_storage& lhs, const Compressed_storage& rhs) {
+        return lhs.ptr == rhs.ptr && lhs.idx == rhs.idx && lhs.values == rhs.values;
+    }
+};
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef DENSE_KERNELS_H
+#define DENSE_KERNELS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "Parallel_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATRIX_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__)
+#define MATRIX_SIMD_INLINE __attribute__((always_inline))
+#else
+#define MATRIX_SIMD_INLINE
+#endif
+
+// vector registers are only passed between functions compiled for the same target
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+/**
+ * @brief Rows of a block of C kept in cache
+ */
+const int GEMM_BLOCK_ROWS = 64;
+/**
+ * @brief Depth of a block (rows of B kept in cache)
+ */
+const int GEMM_BLOCK_DEPTH = 256;
+/**
+ * @brief Columns of a block of C kept in cache
+ */
+const int GEMM_BLOCK_COLUMNS = 512;
+
+/**
+ * @brief Instruction sets of the SIMD kernels, in increasing width
+ */
+enum class Simd_level { SCALAR, AVX2, AVX512 };
+
+/**
+ * @brief Widest instruction set supported by the running CPU, detected once
+ *
+ * @return Simd_level
+ */
+inline Simd_level detected_simd_level() {
+#ifdef MATRIX_SIMD_X86
+    static const Simd_level level = [] {
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+            return Simd_level::SCALAR;
+        }
+        return __builtin_cpu_supports("avx512f") ? Simd_level::AVX512 : Simd_level::AVX2;
+    }();
+    return level;
+#else
+    return Simd_level::SCALAR;
+#endif
+}
+
+inline std::atomic<Simd_level>& simd_level_setting() {
+    static std::atomic<Simd_level> level{detected_simd_level()};
+    return level;
+}
+
+/**
+ * @brief Instruction set used by the kernels
+ *
+ * @return Simd_level
+ */
+inline Simd_level simd_level() {
+    return simd_level_setting().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set instruction set used by the kernels, capped by the CPU
+ *
+ * @param level instruction set
+ */
+inline void set_simd_level(Simd_level level) {
+    simd_level_setting().store(std::min(level, detected_simd_level()), std::memory_order_relaxed);
+}
+
+/**
+ * @brief SIMD operations of an instruction set for T, disabled for types without vector registers
+ *
+ * Operations are compiled for their instruction set whatever the compiler
+ * flags, simd_dispatch() calls them only on CPUs that support it.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Simd_scalar {
+    static const bool enabled = false;
+};
+
+template<typename T>
+struct Simd_avx2 : Simd_scalar<T> {};
+
+template<typename T>
+struct Simd_avx512 : Simd_scalar<T> {};
+
+#ifdef MATRIX_SIMD_X86
+#define MATRIX_AVX2 __attribute__((target("avx2,fma")))
+#define MATRIX_AVX512 __attribute__((target("avx512f")))
+
+template<>
+struct Simd_avx512<double> {
+    static const bool enabled = true;
+    static const int width = 8;
+    using Register = __m512d;
+    MATRIX_AVX512 static Register load(const double* p) { return _mm512_loadu_pd(p); }
+    MATRIX_AVX512 static void store(double* p, Register r) { _mm512_storeu_pd(p, r); }
+    MATRIX_AVX512 static Register broadcast(double v) { return _mm512_set1_pd(v); }
+    MATRIX_AVX512 static Register fma(Register a, Register b, Register c) { return _mm512_fmadd_pd(a, b, c); }
+};
+
+template<>
+struct Simd_avx512<float> {
+    static const bool enabled = true;
+    static const int width = 16;
+    using Register = __m512;
+    MATRIX_AVX512 static Register load(const float* p) { return _mm512_loadu_ps(p); }
+    MATRIX_AVX512 static void store(float* p, Register r) { _mm512_storeu_ps(p, r); }
+    MATRIX_AVX512 static Register broadcast(float v) { return _mm512_set1_ps(v); }
+    MATRIX_AVX512 static Register fma(Register a, Register b, Register c) { return _mm512_fmadd_ps(a, b, c); }
+};
+
+template<>
+struct Simd_avx2<double> {
+    static const bool enabled = true;
+    static const int width = 4;
+    using Register = __m256d;
+    MATRIX_AVX2 static Register load(const double* p) { return _mm256_loadu_pd(p); }
+    MATRIX_AVX2 static void store(double* p, Register r) { _mm256_storeu_pd(p, r); }
+    MATRIX_AVX2 static Register broadcast(double v) { return _mm256_set1_pd(v); }
+    MATRIX_AVX2 static Register fma(Register a, Register b, Register c) { return _mm256_fmadd_pd(a, b, c); }
+};
+
+template<>
+struct Simd_avx2<float> {
+    static const bool enabled = true;
+    static const int width = 8;
+    using Register = __m256;
+    MATRIX_AVX2 static Register load(const float* p) { return _mm256_loadu_ps(p); }
+    MATRIX_AVX2 static void store(float* p, Register r) { _mm256_storeu_ps(p, r); }
+    MATRIX_AVX2 static Register broadcast(float v) { return _mm256_set1_ps(v); }
+    MATRIX_AVX2 static Register fma(Register a, Register b, Register c) { return _mm256_fmadd_ps(a, b, c); }
+};
+
+/**
+ * @brief Entry points compiled for an instruction set, kernels inlined into them use its registers
+ */
+template<typename T, typename Function>
+MATRIX_AVX512 void simd_call_avx512(Function& f) {
+    f(Simd_avx512<T>{});
+}
+
+template<typename T, typename Function>
+MATRIX_AVX2 void simd_call_avx2(Function& f) {
+    f(Simd_avx2<T>{});
+}
+#endif
+
+/**
+ * @brief Call f with the SIMD operations of the widest instruction set of simd_level() enabled for T
+ *
+ * f is a generic lambda marked MATRIX_SIMD_INLINE, it is inlined into an entry
+ * point compiled for the instruction set and branches on decltype(simd)::enabled.
+ *
+ * @param f function of Simd_avx512<T>, Simd_avx2<T> or Simd_scalar<T>
+ */
+template<typename T, typename Function>
+void simd_dispatch(Function f) {
+#ifdef MATRIX_SIMD_X86
+    Simd_level level = simd_level();
+    if constexpr (Simd_avx512<T>::enabled) {
+        if (level == Simd_level::AVX512) {
+            simd_call_avx512<T>(f);
+            return;
+        }
+    }
+    if constexpr (Simd_avx2<T>::enabled) {
+        if (level >= Simd_level::AVX2) {
+            simd_call_avx2<T>(f);
+            return;
+        }
+    }
+#endif
+    f(Simd_scalar<T>{});
+}
+
+/**
+ * @brief Scalar update of block C[i1, i2) x [j1, j2) += A[i1, i2) x [k1, k2) * B[k1, k2) x [j1, j2)
+ *
+ * The innermost loop runs over contiguous rows of B and C.
+ */
+template<typename T>
+void gemm_block_generic(const T* a, const T* b, T* c, int m, int p, int i1, int i2, int k1, int k2, int j1, int j2) {
+    for (int i = i1; i < i2; ++i) {
+        for (int k = k1; k < k2; ++k) {
+            const T& left = a[std::size_t(i) * m + k];
+            if (left == T()) {
+                continue;
+            }
+            const T* right = b + std::size_t(k) * p;
+            T* out = c + std::size_t(i) * p;
+            for (int j = j1; j < j2; ++j) {
+                out[j] += left * right[j];
+            }
+        }
+    }
+}
+
+/**
+ * @brief SIMD update of a block, 4 x (2 * width) tiles of C stay in registers over the whole depth
+ */
+template<typename Simd, typename T>
+MATRIX_SIMD_INLINE inline void gemm_block_simd(const T* a, const T* b, T* c, int m, int p, int i1, int i2, int k1,
+                                               int k2, int j1, int j2) {
+    const int tile_rows = 4;
+    const int tile_columns = 2 * Simd::width;
+    int i_end = i1 + (i2 - i1) / tile_rows * tile_rows;
+    int j_end = j1 + (j2 - j1) / tile_columns * tile_columns;
+
+    for (int i = i1; i < i_end; i += tile_rows) {
+        for (int j = j1; j < j_end; j += tile_columns) {
+            typename Simd::Register acc[tile_rows][2];
+            for (int r = 0; r < tile_rows; ++r) {
+                acc[r][0] = Simd::load(c + std::size_t(i + r) * p + j);
+                acc[r][1] = Simd::load(c + std::size_t(i + r) * p + j + Simd::width);
+            }
+            for (int k = k1; k < k2; ++k) {
+                const T* right = b + std::size_t(k) * p + j;
+                auto b0 = Simd::load(right);
+                auto b1 = Simd::load(right + Simd::width);
+                for (int r = 0; r < tile_rows; ++r) {
+                    auto left = Simd::broadcast(a[std::size_t(i + r) * m + k]);
+                    acc[r][0] = Simd::fma(left, b0, acc[r][0]);
+                    acc[r][1] = Simd::fma(left, b1, acc[r][1]);
+                }
+            }
+            for (int r = 0; r < tile_rows; ++r) {
+                Simd::store(c + std::size_t(i + r) * p + j, acc[r][0]);
+                Simd::store(c + std::size_t(i + r) * p + j + Simd::width, acc[r][1]);
+            }
+        }
+    }
+    // edges that do not fill a whole tile
+    gemm_block_generic(a, b, c, m, p, i1, i_end, k1, k2, j_end, j2);
+    gemm_block_generic(a, b, c, m, p, i_end, i2, k1, k2, j1, j2);
+}
+
+/**
+ * @brief Dense product C += A * B for row-major arrays
+ *
+ * Blocked for cache, rows of C are split between threads. double and float
+ * use AVX2/AVX-512 tiles when the CPU supports them (see simd_level()),
+ * other types the blocked scalar kernel.
+ *
+ * @param a n x m matrix
+ * @param b m x p matrix
+ * @param c n x p matrix
+ * @param threads number of threads
+ */
+template<typename T>
+void dense_gemm(const T* a, const T* b, T* c, int n, int m, int p, int threads = matrix_thread_count()) {
+    std::vector<std::size_t> work(n, std::size_t(m) * p);
+    parallel_ranges(partition_rows(work, useful_threads(std::size_t(n) * m * p, threads)),
+                    [&](int, int first, int last) {
+        simd_dispatch<T>([&](auto simd) MATRIX_SIMD_INLINE {
+            using Simd = decltype(simd);
+            for (int jj = 0; jj < p; jj += GEMM_BLOCK_COLUMNS) {
+                int j2 = std::min(p, jj + GEMM_BLOCK_COLUMNS);
+                for (int kk = 0; kk < m; kk += GEMM_BLOCK_DEPTH) {
+                    int k2 = std::min(m, kk + GEMM_BLOCK_DEPTH);
+                    for (int ii = first; ii < last; ii += GEMM_BLOCK_ROWS) {
+                        int i2 = std::min(last, ii + GEMM_BLOCK_ROWS);
+                        if constexpr (Simd::enabled) {
+                            gemm_block_simd<Simd>(a, b, c, m, p, ii, i2, kk, k2, jj, j2);
+                        } else {
+                            gemm_block_generic(a, b, c, m, p, ii, i2, kk, k2, jj, j2);
+                        }
+                    }
+                }
+            }
+        });
+    });
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif
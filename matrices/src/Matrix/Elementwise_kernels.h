@@ -0,0 +1,159 @@
+#ifndef ELEMENTWISE_KERNELS_H
+#define ELEMENTWISE_KERNELS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Parallel_kernels.h"
+#include "Spgemm.h"
+
+/**
+ * @brief Walk two sorted rows at once
+ *
+ * visit(column, left, right) is called in column order for every cell present
+ * in a only (if LEFT), in both (if BOTH) and in b only (if RIGHT), a missing
+ * value is passed as nullptr.
+ *
+ * @param a left storage
+ * @param b right storage
+ * @param r row
+ * @param visit visitor
+ */
+template<bool LEFT, bool BOTH, bool RIGHT, typename T, typename Visitor>
+void merge_row(const Compressed_storage<T>& a, const Compressed_storage<T>& b, int r, Visitor visit) {
+    std::size_t i = a.ptr[r], a_end = a.ptr[r + 1];
+    std::size_t j = b.ptr[r], b_end = b.ptr[r + 1];
+    while (i < a_end && j < b_end) {
+        if (a.idx[i] < b.idx[j]) {
+            if (LEFT) {
+                visit(a.idx[i], &a.values[i], nullptr);
+            }
+            ++i;
+        } else if (b.idx[j] < a.idx[i]) {
+            if (RIGHT) {
+                visit(b.idx[j], nullptr, &b.values[j]);
+            }
+            ++j;
+        } else {
+            if (BOTH) {
+                visit(a.idx[i], &a.values[i], &b.values[j]);
+            }
+            ++i;
+            ++j;
+        }
+    }
+    for (; LEFT && i < a_end; ++i) {
+        visit(a.idx[i], &a.values[i], nullptr);
+    }
+    for (; RIGHT && j < b_end; ++j) {
+        visit(b.idx[j], nullptr, &b.values[j]);
+    }
+}
+
+/**
+ * @brief Element-wise operation on two storages of equal shape in O(nnz(a) + nnz(b))
+ *
+ * Cells are selected as in merge_row and get op(a, b) with pointers to the
+ * values, nullptr for a missing one, zeros are dropped while writing. A single thread writes into storage
+ * reserved for the largest possible output. Several threads first count cells
+ * of every row, so the output is allocated once and they fill their rows in place.
+ *
+ * @param a left storage
+ * @param b right storage
+ * @param op binary operation on pointers to values
+ * @param is_zero predicate for dropped values
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<bool LEFT, bool BOTH, bool RIGHT, typename T, typename Operation, typename Predicate>
+Compressed_storage<T> merge_present(const Compressed_storage<T>& a, const Compressed_storage<T>& b, Operation op,
+                                    Predicate is_zero, int threads = matrix_thread_count()) {
+    int rows = a.major();
+    threads = useful_threads(a.nnz() + b.nnz(), threads);
+    if (threads == 1) {
+        // one pass into a buffer reserved for the largest possible output
+        std::size_t bound = (LEFT ? a.nnz() : 0) + (RIGHT ? b.nnz() : 0);
+        if (BOTH) {
+            bound = std::max(bound, std::min(a.nnz(), b.nnz()));
+        }
+        Compressed_storage<T> res(rows);
+        res.idx.reserve(bound);
+        res.values.reserve(bound);
+        for (int r = 0; r < rows; ++r) {
+            merge_row<LEFT, BOTH, RIGHT>(a, b, r, [&](int column, const T* left, const T* right) {
+                T value = op(left, right);
+                if (!is_zero(value)) {
+                    res.push_back(column, std::move(value));
+                }
+            });
+            res.ptr[r + 1] = res.nnz();
+        }
+        return res;
+    }
+
+    std::vector<std::size_t> work(rows);
+    for (int r = 0; r < rows; ++r) {
+        work[r] = a.ptr[r + 1] - a.ptr[r] + b.ptr[r + 1] - b.ptr[r];
+    }
+    std::vector<int> bounds = partition_rows(work, threads);
+
+    std::vector<std::size_t> counts(rows, 0);
+    parallel_ranges(bounds, [&](int, int first, int last) {
+        for (int r = first; r < last; ++r) {
+            std::size_t count = 0;
+            merge_row<LEFT, BOTH, RIGHT>(a, b, r, [&count](int, const T*, const T*) { ++count; });
+            counts[r] = count;
+        }
+    });
+
+    Compressed_storage<T> res(rows);
+    res.ptr = counts_to_offsets(counts);
+    res.idx.resize(res.ptr[rows]);
+    res.values.resize(res.ptr[rows]);
+    std::atomic<bool> dropped{false};
+    parallel_ranges(bounds, [&](int, int first, int last) {
+        for (int r = first; r < last; ++r) {
+            std::size_t out = res.ptr[r];
+            merge_row<LEFT, BOTH, RIGHT>(a, b, r, [&](int column, const T* left, const T* right) {
+                T value = op(left, right);
+                if (!is_zero(value)) {
+                    res.idx[out] = column;
+                    res.values[out++] = std::move(value);
+                }
+            });
+            if (out != res.ptr[r + 1]) {
+                counts[r] = out - res.ptr[r];
+                dropped = true;
+            }
+        }
+    });
+    if (dropped) {
+        spgemm_compact(res, counts);
+    }
+    return res;
+}
+
+/**
+ * @brief Element-wise operation on two storages of equal shape in O(nnz(a) + nnz(b))
+ *
+ * As merge_present, op(a, b) gets zero for a missing value.
+ *
+ * @param a left storage
+ * @param b right storage
+ * @param op binary operation
+ * @param is_zero predicate for dropped values
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<bool LEFT, bool BOTH, bool RIGHT, typename T, typename Operation, typename Predicate>
+Compressed_storage<T> merge_storages(const Compressed_storage<T>& a, const Compressed_storage<T>& b, Operation op,
+                                     Predicate is_zero, int threads = matrix_thread_count()) {
+    const T zero = T();
+    return merge_present<LEFT, BOTH, RIGHT>(a, b, [&](const T* left, const T* right) {
+        return op(left != nullptr ? *left : zero, right != nullptr ? *right : zero);
+    }, is_zero, threads);
+}
+
+#endif
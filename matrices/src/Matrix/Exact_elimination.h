@@ -0,0 +1,392 @@
+#ifndef EXACT_ELIMINATION_H
+#define EXACT_ELIMINATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Compressed_storage.h"
+#include "../Exceptions/Exceptions.h"
+#include "../Rational_number/Rational_number.h"
+
+/**
+ * @brief Sign of permutation given as a sequence of distinct values
+ *
+ * @param values values
+ * @return int 1 or -1
+ */
+inline int permutation_sign(const std::vector<int>& values) {
+    std::vector<int> order(values.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&values](int a, int b) { return values[a] < values[b]; });
+    int sign = 1;
+    std::vector<bool> visited(order.size(), false);
+    for (std::size_t k = 0; k < order.size(); ++k) {
+        if (visited[k]) {
+            continue;
+        }
+        std::size_t length = 0;
+        for (std::size_t t = k; !visited[t]; t = order[t]) {
+            visited[t] = true;
+            ++length;
+        }
+        if (length % 2 == 0) {
+            sign = -sign;
+        }
+    }
+    return sign;
+}
+
+/**
+ * @brief Sparse rows under elimination with pivot bookkeeping
+ *
+ * Columns from the number of columns of the matrix on hold right-hand sides
+ * and are never pivots. The pivot is taken from the shortest remaining row, in
+ * its column with the fewest remaining nonzeros, which limits fill-in.
+ *
+ * @tparam V value type, V() is zero
+ */
+template<typename V>
+class Sparse_pivoting {
+protected:
+    /**
+     * @brief Nonzero of a row
+     */
+    struct Entry {
+        int column;
+        V value;
+    };
+
+    using Row = std::vector<Entry>;
+
+    /**
+     * @brief rows sorted by column
+     */
+    std::vector<Row> _rows;
+    /**
+     * @brief number of columns of the matrix
+     */
+    int _columns;
+    /**
+     * @brief pivot column of every row, -1 for remaining rows
+     */
+    std::vector<int> _pivot_column;
+    /**
+     * @brief pivot rows in order of steps
+     */
+    std::vector<int> _pivot_rows{};
+    /**
+     * @brief nonzeros of remaining rows in every column
+     */
+    std::vector<int> _column_count;
+
+    Sparse_pivoting(int rows, int columns) :
+                    _rows(rows), _columns(columns), _pivot_column(rows, -1), _column_count(columns, 0) {}
+
+    /**
+     * @brief Value of row in column
+     */
+    static V find(const Row& row, int column) {
+        auto it = std::lower_bound(row.begin(), row.end(), column,
+                                   [](const Entry& entry, int c) { return entry.column < c; });
+        return it != row.end() && it->column == column ? it->value : V();
+    }
+
+    /**
+     * @brief Number of nonzeros of row in columns of the matrix
+     */
+    int length(const Row& row) const {
+        return std::lower_bound(row.begin(), row.end(), _columns,
+                                [](const Entry& entry, int c) { return entry.column < c; }) - row.begin();
+    }
+
+    void count(const Row& row, int delta) {
+        for (const Entry& entry : row) {
+            if (entry.column < _columns) {
+                _column_count[entry.column] += delta;
+            }
+        }
+    }
+
+    bool remaining(int r) const {
+        return _pivot_column[r] == -1;
+    }
+
+    /**
+     * @brief Choose the next pivot and take its row out of the remaining ones
+     *
+     * @param column pivot column
+     * @return int pivot row or -1 if no remaining row has a nonzero in the matrix
+     */
+    int next_pivot(int& column) {
+        int r = -1;
+        int best = 0;
+        for (int i = 0; i < int(_rows.size()); ++i) {
+            int size = remaining(i) ? length(_rows[i]) : 0;
+            if (size > 0 && (r == -1 || size < best)) {
+                r = i;
+                best = size;
+            }
+        }
+        if (r == -1) {
+            return -1;
+        }
+        const Row& pivot = _rows[r];
+        column = pivot[0].column;
+        for (int k = 1; k < best; ++k) {
+            if (_column_count[pivot[k].column] < _column_count[column]) {
+                column = pivot[k].column;
+            }
+        }
+        count(pivot, -1);
+        _pivot_column[r] = column;
+        _pivot_rows.push_back(r);
+        return r;
+    }
+
+    /**
+     * @brief Sign of the row and column permutation made by pivots
+     */
+    int pivot_sign() const {
+        std::vector<int> columns;
+        for (int r : _pivot_rows) {
+            columns.push_back(_pivot_column[r]);
+        }
+        return permutation_sign(_pivot_rows) * permutation_sign(columns);
+    }
+
+    /**
+     * @brief Is square matrix of full rank
+     */
+    bool full_rank() const {
+        return rank() == int(_rows.size()) && rank() == _columns;
+    }
+public:
+    /**
+     * @brief Rank of the matrix
+     *
+     * @return int
+     */
+    int rank() const {
+        return _pivot_rows.size();
+    }
+};
+
+/**
+ * @brief Integer type of Rational_number
+ */
+template<typename T>
+using rational_integer_t = std::decay_t<decltype(std::declval<T>().numerator())>;
+
+/**
+ * @brief Fraction-free (Bareiss) elimination of a rational matrix
+ *
+ * Every row, together with its right-hand sides, is multiplied by the least
+ * common multiple of its denominators, so elimination runs on integers. A step
+ * with pivot p replaces every other row by (p * row - a * pivot_row) / previous
+ * pivot, the division is exact and entries stay minors of the matrix, so they
+ * grow linearly instead of exponentially. Products are computed in 128 bits and
+ * MatrixException is thrown if a result does not fit the integer type.
+ *
+ * @tparam T Rational_number
+ */
+template<typename T>
+class Bareiss_elimination : public Sparse_pivoting<rational_integer_t<T>> {
+    using I = rational_integer_t<T>;
+    using Base = Sparse_pivoting<I>;
+    using Row = typename Base::Row;
+    using Wide = __int128;
+    using Base::_rows;
+    using Base::_columns;
+    using Base::_pivot_column;
+    using Base::_pivot_rows;
+
+    /**
+     * @brief multiplier of every row
+     */
+    std::vector<I> _scales;
+    /**
+     * @brief last pivot
+     */
+    I _previous = 1;
+
+    static I narrow(Wide value) {
+        if (value > std::numeric_limits<I>::max() || value < std::numeric_limits<I>::min()) {
+            throw MatrixException("Overflow in exact elimination!");
+        }
+        return I(value);
+    }
+
+    static I lcm(I a, I b) {
+        return narrow(Wide(a) / std::gcd(a, b) * b);
+    }
+
+    /**
+     * @brief row = (p * row - a * pivot) / previous, a is the value of row in the pivot column
+     */
+    void update(Row& row, const Row& pivot, I p, I a) {
+        if (a == 0) {
+            if (p != _previous) {
+                for (auto& entry : row) {
+                    entry.value = narrow(Wide(p) * entry.value / _previous);
+                }
+            }
+            return;
+        }
+        Row res;
+        res.reserve(row.size() + pivot.size());
+        auto i = row.begin();
+        auto j = pivot.begin();
+        while (i != row.end() || j != pivot.end()) {
+            Wide value;
+            int column;
+            if (j == pivot.end() || (i != row.end() && i->column < j->column)) {
+                column = i->column;
+                value = Wide(p) * (i++)->value;
+            } else if (i == row.end() || j->column < i->column) {
+                column = j->column;
+                value = -Wide(a) * (j++)->value;
+            } else {
+                column = i->column;
+                value = Wide(p) * (i++)->value - Wide(a) * (j++)->value;
+            }
+            if (value != 0) {
+                res.push_back({column, narrow(value / _previous)});
+            }
+        }
+        row = std::move(res);
+    }
+
+    /**
+     * @brief numerator / denominator in canonical form with positive denominator
+     *
+     * Reduced here with gcd(denominator, numerator % denominator), which cannot overflow on I.
+     */
+    static T fraction(I numerator, I denominator) {
+        if (denominator < 0) {
+            numerator = narrow(-Wide(numerator));
+            denominator = narrow(-Wide(denominator));
+        }
+        I common = std::gcd(denominator, numerator % denominator);
+        return T(numerator / common, denominator / common);
+    }
+
+    /**
+     * @brief Run elimination steps until no remaining row has a nonzero in the matrix
+     *
+     * @param jordan eliminate above pivots as well
+     */
+    void eliminate(bool jordan) {
+        int c;
+        for (int r = this->next_pivot(c); r != -1; r = this->next_pivot(c)) {
+            const Row& pivot = _rows[r];
+            I p = Base::find(pivot, c);
+            for (int i = 0; i < int(_rows.size()); ++i) {
+                bool remaining = this->remaining(i);
+                if (i == r || (!remaining && !jordan)) {
+                    continue;
+                }
+                if (remaining) {
+                    this->count(_rows[i], -1);
+                }
+                update(_rows[i], pivot, p, Base::find(_rows[i], c));
+                if (remaining) {
+                    this->count(_rows[i], 1);
+                }
+            }
+            _previous = p;
+        }
+    }
+public:
+    /**
+     * @brief Eliminate [a | b]
+     *
+     * @param a rows of the matrix
+     * @param columns number of columns of the matrix
+     * @param b rows of right-hand sides, empty or with as many rows as a
+     * @param jordan eliminate above pivots as well, needed for solutions
+     */
+    Bareiss_elimination(const Compressed_storage<T>& a, int columns, const Compressed_storage<T>& b, bool jordan) :
+                        Base(a.major(), columns), _scales(a.major(), 1) {
+        bool has_sides = b.major() == a.major();
+        for (int r = 0; r < a.major(); ++r) {
+            I scale = 1;
+            auto scale_by = [&scale](const T& value) {
+                I denominator = value.denominator() < 0 ? narrow(-Wide(value.denominator())) : value.denominator();
+                scale = lcm(scale, denominator);
+            };
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                scale_by(a.values[k]);
+            }
+            for (std::size_t k = has_sides ? b.ptr[r] : 0; has_sides && k < b.ptr[r + 1]; ++k) {
+                scale_by(b.values[k]);
+            }
+            auto integer = [scale](const T& value) {
+                return narrow(Wide(value.numerator()) * (scale / value.denominator()));
+            };
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                if (a.values[k].numerator() != 0) {
+                    _rows[r].push_back({a.idx[k], integer(a.values[k])});
+                }
+            }
+            for (std::size_t k = has_sides ? b.ptr[r] : 0; has_sides && k < b.ptr[r + 1]; ++k) {
+                if (b.values[k].numerator() != 0) {
+                    _rows[r].push_back({columns + b.idx[k], integer(b.values[k])});
+                }
+            }
+            _scales[r] = scale;
+            this->count(_rows[r], 1);
+        }
+        eliminate(jordan);
+    }
+
+    /**
+     * @brief Determinant of the square matrix
+     *
+     * @return T
+     */
+    T determinant() const {
+        if (!this->full_rank()) {
+            return T();
+        }
+        // the last pivot is the determinant of the permuted integer matrix
+        I numerator = narrow(Wide(_previous) * this->pivot_sign());
+        I denominator = 1;
+        for (I scale : _scales) {
+            I common = std::gcd(numerator, scale);
+            numerator /= common;
+            denominator = narrow(Wide(denominator) * (scale / common));
+        }
+        return fraction(numerator, denominator);
+    }
+
+    /**
+     * @brief Solution X of A X = B for the nonsingular square matrix, needs Gauss-Jordan elimination
+     *
+     * @return Compressed_storage<T> rows of X
+     */
+    Compressed_storage<T> solution() const {
+        if (!this->full_rank()) {
+            throw MatrixException("Matrix is singular!");
+        }
+        // every pivot row is now D * x_c = b with D the last pivot
+        std::vector<int> row_of_column(_columns);
+        for (int r : _pivot_rows) {
+            row_of_column[_pivot_column[r]] = r;
+        }
+        Compressed_storage<T> res(_columns);
+        for (int c = 0; c < _columns; ++c) {
+            const Row& row = _rows[row_of_column[c]];
+            for (std::size_t k = this->length(row); k < row.size(); ++k) {
+                res.push_back(row[k].column - _columns, fraction(row[k].value, _previous));
+            }
+            res.ptr[c + 1] = res.nnz();
+        }
+        return res;
+    }
+};
+
+#endif
@@ -0,0 +1,891 @@
+#ifndef KRYLOV_SOLVERS_H
+#define KRYLOV_SOLVERS_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Parallel_kernels.h"
+#include "../Exceptions/Exceptions.h"
+
+/**
+ * @brief Enum for Krylov methods
+ *
+ */
+enum class Krylov_method {
+    CG,
+    BICGSTAB,
+    GMRES,
+};
+
+/**
+ * @brief Enum for preconditioners of Krylov methods
+ *
+ */
+enum class Preconditioner_type {
+    NONE,
+    JACOBI,
+    ILU0,
+    ICHOL0,
+};
+
+/**
+ * @brief Stopping rules and monitoring of Krylov methods
+ */
+struct Solver_options {
+    /**
+     * @brief stop when the residual norm drops below tolerance * norm of b
+     */
+    double tolerance = 1e-8;
+    /**
+     * @brief largest number of iterations (matrix by vector products)
+     */
+    int max_iterations = 1000;
+    /**
+     * @brief dimention of the Krylov subspace of GMRES before a restart
+     */
+    int restart = 30;
+    /**
+     * @brief number of threads
+     */
+    int threads = matrix_thread_count();
+    /**
+     * @brief called as monitor(iteration, relative residual) after every iteration
+     */
+    std::function<void(int, double)> monitor{};
+};
+
+/**
+ * @brief Outcome of a Krylov method
+ */
+struct Solver_report {
+    /**
+     * @brief number of iterations
+     */
+    int iterations = 0;
+    /**
+     * @brief norm of b - A x relative to the norm of b, computed from x at the end
+     */
+    double residual = 0;
+    /**
+     * @brief wall time including setup of the preconditioner
+     */
+    double seconds = 0;
+    /**
+     * @brief tolerance was reached
+     */
+    bool converged = false;
+
+    /**
+     * @brief << operator
+     *
+     * @param out output stream
+     * @param report report
+     * @return std::ostream&
+     */
+    friend std::ostream& operator<<(std::ostream& out, const Solver_report& report) {
+        return out << (report.converged ? "converged" : "not converged") << " in " << report.iterations
+                   << " iterations, relative residual " << report.residual << ", " << report.seconds << " s";
+    }
+};
+
+/**
+ * @brief Multithreaded fused kernels of Krylov methods
+ *
+ * Rows of the matrix are split by nonzeros and vectors in equal ranges once per
+ * solve. Every kernel is one pass over its vectors: a product returns a dot
+ * product of its result and reduce() runs updates together with their dot
+ * products. Partial sums are added in range order, so results do not depend on
+ * scheduling.
+ *
+ * @tparam T floating point type
+ */
+template<typename T>
+class Krylov_kernels {
+    /**
+     * @brief matrix
+     */
+    const Compressed_storage<T>& _a;
+    /**
+     * @brief ranges of rows for products
+     */
+    std::vector<int> _rows;
+    /**
+     * @brief ranges of vector elements
+     */
+    std::vector<int> _range{0};
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param a rows of square matrix
+     * @param threads number of threads
+     */
+    Krylov_kernels(const Compressed_storage<T>& a, int threads) : _a(a) {
+        int n = a.major();
+        std::vector<std::size_t> work(n);
+        for (int r = 0; r < n; ++r) {
+            work[r] = a.ptr[r + 1] - a.ptr[r];
+        }
+        _rows = partition_rows(work, useful_threads(a.nnz(), threads));
+        int parts = useful_threads(n, threads);
+        for (int t = 1; t <= parts; ++t) {
+            _range.push_back(std::size_t(n) * t / parts);
+        }
+    }
+
+    /**
+     * @brief y = A x
+     *
+     * @param x vector
+     * @param y result
+     * @param w vector to multiply y by, or nullptr
+     * @return std::array<T, 2> w . y and y . y
+     */
+    std::array<T, 2> multiply(const std::vector<T>& x, std::vector<T>& y, const std::vector<T>* w = nullptr) const {
+        std::vector<std::array<T, 2>> partial(_rows.size() - 1);
+        parallel_ranges(_rows, [&](int t, int first, int last) {
+            std::array<T, 2> dots{};
+            for (int r = first; r < last; ++r) {
+                T sum{};
+                for (std::size_t k = _a.ptr[r]; k < _a.ptr[r + 1]; ++k) {
+                    sum += _a.values[k] * x[_a.idx[k]];
+                }
+                y[r] = sum;
+                if (w != nullptr) {
+                    dots[0] += (*w)[r] * sum;
+                }
+                dots[1] += sum * sum;
+            }
+            partial[t] = dots;
+        });
+        std::array<T, 2> res{};
+        for (const auto& dots : partial) {
+            res[0] += dots[0];
+            res[1] += dots[1];
+        }
+        return res;
+    }
+
+    /**
+     * @brief Sums of f(first, last) over ranges of vector elements
+     *
+     * @tparam N number of sums
+     * @param f fused update returning its partial dot products
+     * @return std::array<T, N>
+     */
+    template<int N = 1, typename Function>
+    std::array<T, N> reduce(Function f) const {
+        std::vector<std::array<T, N>> partial(_range.size() - 1);
+        parallel_ranges(_range, [&](int t, int first, int last) { partial[t] = f(first, last); });
+        std::array<T, N> res{};
+        for (const auto& sums : partial) {
+            for (int k = 0; k < N; ++k) {
+                res[k] += sums[k];
+            }
+        }
+        return res;
+    }
+};
+
+/**
+ * @brief No preconditioning
+ */
+template<typename T>
+class Identity_preconditioner {
+public:
+    void apply(const std::vector<T>& r, std::vector<T>& z) const {
+        z = r;
+    }
+};
+
+/**
+ * @brief Jacobi preconditioner: division by the diagonal
+ */
+template<typename T>
+class Jacobi_preconditioner {
+    /**
+     * @brief inverse of the diagonal
+     */
+    std::vector<T> _inverse;
+    /**
+     * @brief ranges of elements
+     */
+    std::vector<int> _range{0};
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param a rows of square matrix with nonzero diagonal
+     * @param threads number of threads
+     */
+    Jacobi_preconditioner(const Compressed_storage<T>& a, int threads = matrix_thread_count()) :
+                          _inverse(a.major()) {
+        for (int r = 0; r < a.major(); ++r) {
+            std::size_t k = a.find(r, r);
+            if (k == a.nnz() || a.values[k] == T()) {
+                throw MatrixException("Matrix has zero on the diagonal!");
+            }
+            _inverse[r] = T(1) / a.values[k];
+        }
+        int parts = useful_threads(a.major(), threads);
+        for (int t = 1; t <= parts; ++t) {
+            _range.push_back(std::size_t(a.major()) * t / parts);
+        }
+    }
+
+    void apply(const std::vector<T>& r, std::vector<T>& z) const {
+        z.resize(r.size());
+        parallel_ranges(_range, [&](int, int first, int last) {
+            for (int i = first; i < last; ++i) {
+                z[i] = r[i] * _inverse[i];
+            }
+        });
+    }
+};
+
+/**
+ * @brief Incomplete LU factorization with the pattern of the matrix, ILU(0)
+ *
+ * Triangular solves of apply() are sequential.
+ */
+template<typename T>
+class Ilu0_preconditioner {
+    /**
+     * @brief L with unit diagonal below the diagonal and U on and above it
+     */
+    Compressed_storage<T> _factors;
+    /**
+     * @brief position of the diagonal in every row
+     */
+    std::vector<std::size_t> _diagonal;
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param a rows of square matrix with nonzero diagonal
+     */
+    explicit Ilu0_preconditioner(const Compressed_storage<T>& a) : _factors(a), _diagonal(a.major()) {
+        int n = a.major();
+        for (int r = 0; r < n; ++r) {
+            _diagonal[r] = a.find(r, r);
+            if (_diagonal[r] == a.nnz()) {
+                throw MatrixException("Matrix has zero on the diagonal!");
+            }
+        }
+        auto& values = _factors.values;
+        const auto& idx = _factors.idx;
+        const std::size_t none = a.nnz();
+        std::vector<std::size_t> position(n, none);
+        for (int i = 0; i < n; ++i) {
+            for (std::size_t k = _factors.ptr[i]; k < _factors.ptr[i + 1]; ++k) {
+                position[idx[k]] = k;
+            }
+            for (std::size_t k = _factors.ptr[i]; k < _diagonal[i]; ++k) {
+                int c = idx[k];
+                values[k] /= values[_diagonal[c]];
+                for (std::size_t t = _diagonal[c] + 1; t < _factors.ptr[c + 1]; ++t) {
+                    if (position[idx[t]] != none) {
+                        values[position[idx[t]]] -= values[k] * values[t];
+                    }
+                }
+            }
+            if (values[_diagonal[i]] == T()) {
+                throw MatrixException("Zero pivot in incomplete factorization!");
+            }
+            for (std::size_t k = _factors.ptr[i]; k < _factors.ptr[i + 1]; ++k) {
+                position[idx[k]] = none;
+            }
+        }
+    }
+
+    void apply(const std::vector<T>& r, std::vector<T>& z) const {
+        int n = _diagonal.size();
+        z.resize(n);
+        for (int i = 0; i < n; ++i) {
+            T sum = r[i];
+            for (std::size_t k = _factors.ptr[i]; k < _diagonal[i]; ++k) {
+                sum -= _factors.values[k] * z[_factors.idx[k]];
+            }
+            z[i] = sum;
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            T sum = z[i];
+            for (std::size_t k = _diagonal[i] + 1; k < _factors.ptr[i + 1]; ++k) {
+                sum -= _factors.values[k] * z[_factors.idx[k]];
+            }
+            z[i] = sum / _factors.values[_diagonal[i]];
+        }
+    }
+};
+
+/**
+ * @brief Incomplete Cholesky factorization with the pattern of the lower triangle, IC(0)
+ *
+ * Triangular solves of apply() are sequential.
+ */
+template<typename T>
+class Ichol0_preconditioner {
+    /**
+     * @brief rows of L, the diagonal is the last element of every row
+     */
+    Compressed_storage<T> _lower;
+    /**
+     * @brief rows of L^T, both sweeps of apply() run over rows
+     */
+    Compressed_storage<T> _upper;
+    /**
+     * @brief inverse of the diagonal of L
+     */
+    std::vector<T> _inverse;
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param a rows of symmetric positive definite matrix
+     */
+    explicit Ichol0_preconditioner(const Compressed_storage<T>& a) : _lower(a.major()) {
+        int n = a.major();
+        auto& ptr = _lower.ptr;
+        auto& idx = _lower.idx;
+        auto& values = _lower.values;
+        for (int i = 0; i < n; ++i) {
+            for (std::size_t k = a.ptr[i]; k < a.ptr[i + 1] && a.idx[k] <= i; ++k) {
+                _lower.push_back(a.idx[k], a.values[k]);
+            }
+            ptr[i + 1] = _lower.nnz();
+            if (ptr[i + 1] == ptr[i] || idx[ptr[i + 1] - 1] != i) {
+                throw MatrixException("Matrix has zero on the diagonal!");
+            }
+            for (std::size_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                int j = idx[k];
+                // dot product of rows i and j left of column j
+                T sum = values[k];
+                std::size_t p = ptr[i];
+                std::size_t q = ptr[j];
+                while (p < k && q + 1 < ptr[j + 1]) {
+                    if (idx[p] < idx[q]) {
+                        ++p;
+                    } else if (idx[q] < idx[p]) {
+                        ++q;
+                    } else {
+                        sum -= values[p++] * values[q++];
+                    }
+                }
+                if (j < i) {
+                    values[k] = sum / values[ptr[j + 1] - 1];
+                } else if (sum > T()) {
+                    values[k] = std::sqrt(sum);
+                } else {
+                    throw MatrixException("Matrix is not positive definite!");
+                }
+            }
+        }
+        _upper = _lower.transposed(n);
+        _inverse.resize(n);
+        for (int i = 0; i < n; ++i) {
+            _inverse[i] = T(1) / values[ptr[i + 1] - 1];
+        }
+    }
+
+    void apply(const std::vector<T>& r, std::vector<T>& z) const {
+        int n = _lower.major();
+        z.resize(n);
+        for (int i = 0; i < n; ++i) {
+            T sum = r[i];
+            for (std::size_t k = _lower.ptr[i]; k + 1 < _lower.ptr[i + 1]; ++k) {
+                sum -= _lower.values[k] * z[_lower.idx[k]];
+            }
+            z[i] = sum * _inverse[i];
+        }
+        for (int i = n - 1; i >= 0; --i) {
+            T sum = z[i];
+            for (std::size_t k = _upper.ptr[i] + 1; k < _upper.ptr[i + 1]; ++k) {
+                sum -= _upper.values[k] * z[_upper.idx[k]];
+            }
+            z[i] = sum * _inverse[i];
+        }
+    }
+};
+
+/**
+ * @brief Check dimentions, a missing initial guess is zero
+ */
+template<typename T>
+void krylov_setup(const Compressed_storage<T>& a, const std::vector<T>& b, std::vector<T>& x) {
+    if (int(b.size()) != a.major()) {
+        throw MatrixException("Dimentions are not compatible!");
+    }
+    if (x.empty()) {
+        x.assign(b.size(), T());
+    } else if (x.size() != b.size()) {
+        throw MatrixException("Dimentions are not compatible!");
+    }
+}
+
+/**
+ * @brief r = b - A x
+ *
+ * @return T squared norm of r
+ */
+template<typename T>
+T krylov_residual(const Krylov_kernels<T>& kernels, const std::vector<T>& b, const std::vector<T>& x,
+                  std::vector<T>& r) {
+    kernels.multiply(x, r);
+    return kernels.reduce([&](int first, int last) {
+        std::array<T, 1> sum{};
+        for (int i = first; i < last; ++i) {
+            r[i] = b[i] - r[i];
+            sum[0] += r[i] * r[i];
+        }
+        return sum;
+    })[0];
+}
+
+/**
+ * @brief Tracks the relative residual, the iteration count and the monitor of a solve
+ *
+ * Convergence of a recurrence is confirmed by the true residual, a method
+ * restarts from it otherwise.
+ */
+class Krylov_progress {
+    const Solver_options& _options;
+    std::chrono::steady_clock::time_point _start;
+    double _b_norm;
+public:
+    Solver_report report{};
+
+    Krylov_progress(const Solver_options& options, double b_norm) :
+                    _options(options), _start(std::chrono::steady_clock::now()), _b_norm(b_norm) {
+        report.converged = b_norm == 0;
+    }
+
+    /**
+     * @brief Is another iteration allowed
+     */
+    bool running() const {
+        return !report.converged && report.iterations < _options.max_iterations;
+    }
+
+    /**
+     * @brief Count an iteration that reached residual norm
+     *
+     * @return true if the tolerance is reached
+     */
+    bool step(double norm) {
+        ++report.iterations;
+        double residual = norm / _b_norm;
+        if (_options.monitor) {
+            _options.monitor(report.iterations, residual);
+        }
+        report.converged = residual <= _options.tolerance;
+        return report.converged;
+    }
+
+    /**
+     * @brief Confirm convergence by the true residual norm, recurrences drift away from it
+     *
+     * @return true if the tolerance is reached
+     */
+    bool confirm(double norm) {
+        report.converged = norm <= _options.tolerance * _b_norm;
+        return report.converged;
+    }
+
+    /**
+     * @brief Report with the true residual of x
+     */
+    template<typename T>
+    Solver_report finish(const Krylov_kernels<T>& kernels, const std::vector<T>& b, const std::vector<T>& x) {
+        std::vector<T> r(b.size());
+        report.residual = _b_norm == 0 ? 0 : std::sqrt(krylov_residual(kernels, b, x, r)) / _b_norm;
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+        return report;
+    }
+};
+
+/**
+ * @brief Norm of a vector
+ */
+template<typename T>
+T krylov_norm(const Krylov_kernels<T>& kernels, const std::vector<T>& v) {
+    return std::sqrt(kernels.reduce([&](int first, int last) {
+        std::array<T, 1> sum{};
+        for (int i = first; i < last; ++i) {
+            sum[0] += v[i] * v[i];
+        }
+        return sum;
+    })[0]);
+}
+
+/**
+ * @brief Norm of b, x is set to the solution zero if it vanishes
+ */
+template<typename T>
+T krylov_start(const Krylov_kernels<T>& kernels, const std::vector<T>& b, std::vector<T>& x) {
+    T b_norm = krylov_norm(kernels, b);
+    if (b_norm == T()) {
+        std::fill(x.begin(), x.end(), T());
+    }
+    return b_norm;
+}
+
+/**
+ * @brief Preconditioned conjugate gradient method for symmetric positive definite matrices
+ *
+ * @param a rows of matrix
+ * @param b right-hand side
+ * @param x initial guess or empty for zero, solution on return
+ * @param preconditioner symmetric positive definite preconditioner
+ * @param options stopping rules
+ * @return Solver_report
+ */
+template<typename T, typename Preconditioner>
+Solver_report conjugate_gradient(const Compressed_storage<T>& a, const std::vector<T>& b, std::vector<T>& x,
+                                 const Preconditioner& preconditioner, const Solver_options& options = {}) {
+    krylov_setup(a, b, x);
+    Krylov_kernels<T> kernels(a, options.threads);
+    T b_norm = krylov_start(kernels, b, x);
+    Krylov_progress progress(options, b_norm);
+    int n = b.size();
+    std::vector<T> r(n), z(n), p(n), q(n);
+    T rr = krylov_residual(kernels, b, x, r);
+    T rz{};
+    auto restart = [&] {
+        preconditioner.apply(r, z);
+        p = z;
+        rz = kernels.reduce([&](int first, int last) {
+            std::array<T, 1> sum{};
+            for (int i = first; i < last; ++i) {
+                sum[0] += r[i] * z[i];
+            }
+            return sum;
+        })[0];
+    };
+    if (!progress.confirm(std::sqrt(rr))) {
+        restart();
+    }
+    while (progress.running()) {
+        T pq = kernels.multiply(p, q, &p)[0];
+        if (pq == T()) {
+            break;
+        }
+        T alpha = rz / pq;
+        rr = kernels.reduce([&](int first, int last) {
+            std::array<T, 1> sum{};
+            for (int i = first; i < last; ++i) {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * q[i];
+                sum[0] += r[i] * r[i];
+            }
+            return sum;
+        })[0];
+        if (progress.step(std::sqrt(rr))) {
+            if (progress.confirm(std::sqrt(krylov_residual(kernels, b, x, r)))) {
+                break;
+            }
+            restart();
+            continue;
+        }
+        preconditioner.apply(r, z);
+        T rz_next = kernels.reduce([&](int first, int last) {
+            std::array<T, 1> sum{};
+            for (int i = first; i < last; ++i) {
+                sum[0] += r[i] * z[i];
+            }
+            return sum;
+        })[0];
+        T beta = rz_next / rz;
+        rz = rz_next;
+        kernels.reduce([&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                p[i] = z[i] + beta * p[i];
+            }
+            return std::array<T, 1>{};
+        });
+    }
+    return progress.finish(kernels, b, x);
+}
+
+/**
+ * @brief Right-preconditioned BiCGSTAB method for general matrices
+ *
+ * @param a rows of matrix
+ * @param b right-hand side
+ * @param x initial guess or empty for zero, solution on return
+ * @param preconditioner preconditioner
+ * @param options stopping rules, every half step counts as an iteration
+ * @return Solver_report
+ */
+template<typename T, typename Preconditioner>
+Solver_report bicgstab(const Compressed_storage<T>& a, const std::vector<T>& b, std::vector<T>& x,
+                       const Preconditioner& preconditioner, const Solver_options& options = {}) {
+    krylov_setup(a, b, x);
+    Krylov_kernels<T> kernels(a, options.threads);
+    T b_norm = krylov_start(kernels, b, x);
+    Krylov_progress progress(options, b_norm);
+    int n = b.size();
+    std::vector<T> r(n), shadow(n), p(n), v(n), p_hat(n), s(n), s_hat(n), t(n);
+    T rho = krylov_residual(kernels, b, x, r);
+    auto restart = [&] {
+        shadow = r;
+        p = r;
+        rho = kernels.reduce([&](int first, int last) {
+            std::array<T, 1> sum{};
+            for (int i = first; i < last; ++i) {
+                sum[0] += r[i] * r[i];
+            }
+            return sum;
+        })[0];
+    };
+    auto converged = [&] {
+        if (progress.confirm(std::sqrt(krylov_residual(kernels, b, x, r)))) {
+            return true;
+        }
+        restart();
+        return false;
+    };
+    if (!progress.confirm(std::sqrt(rho))) {
+        restart();
+    }
+    while (progress.running()) {
+        preconditioner.apply(p, p_hat);
+        T shadow_v = kernels.multiply(p_hat, v, &shadow)[0];
+        if (shadow_v == T()) {
+            break;
+        }
+        T alpha = rho / shadow_v;
+        T ss = kernels.reduce([&](int first, int last) {
+            std::array<T, 1> sum{};
+            for (int i = first; i < last; ++i) {
+                s[i] = r[i] - alpha * v[i];
+                sum[0] += s[i] * s[i];
+            }
+            return sum;
+        })[0];
+        if (progress.step(std::sqrt(ss))) {
+            kernels.reduce([&](int first, int last) {
+                for (int i = first; i < last; ++i) {
+                    x[i] += alpha * p_hat[i];
+                }
+                return std::array<T, 1>{};
+            });
+            if (converged()) {
+                break;
+            }
+            continue;
+        }
+        preconditioner.apply(s, s_hat);
+        auto [ts, tt] = kernels.multiply(s_hat, t, &s);
+        if (tt == T()) {
+            break;
+        }
+        T omega = ts / tt;
+        auto [r_norm2, rho_next] = kernels.template reduce<2>([&](int first, int last) {
+            std::array<T, 2> sum{};
+            for (int i = first; i < last; ++i) {
+                x[i] += alpha * p_hat[i] + omega * s_hat[i];
+                r[i] = s[i] - omega * t[i];
+                sum[0] += r[i] * r[i];
+                sum[1] += shadow[i] * r[i];
+            }
+            return sum;
+        });
+        if (progress.step(std::sqrt(r_norm2))) {
+            if (converged()) {
+                break;
+            }
+            continue;
+        }
+        if (omega == T() || rho_next == T()) {
+            break;
+        }
+        T beta = (rho_next / rho) * (alpha / omega);
+        rho = rho_next;
+        kernels.reduce([&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                p[i] = r[i] + beta * (p[i] - omega * v[i]);
+            }
+            return std::array<T, 1>{};
+        });
+    }
+    return progress.finish(kernels, b, x);
+}
+
+/**
+ * @brief Right-preconditioned restarted GMRES method for general matrices
+ *
+ * The basis is orthogonalized by modified Gram-Schmidt, where the update by
+ * one basis vector is fused with the dot product with the next one, and the
+ * Hessenberg matrix is reduced by Givens rotations.
+ *
+ * @param a rows of matrix
+ * @param b right-hand side
+ * @param x initial guess or empty for zero, solution on return
+ * @param preconditioner preconditioner
+ * @param options stopping rules, options.restart is the size of the basis
+ * @return Solver_report
+ */
+template<typename T, typename Preconditioner>
+Solver_report gmres(const Compressed_storage<T>& a, const std::vector<T>& b, std::vector<T>& x,
+                    const Preconditioner& preconditioner, const Solver_options& options = {}) {
+    krylov_setup(a, b, x);
+    if (options.restart < 1) {
+        throw MatrixException("Wrong input - restart of GMRES must be positive!");
+    }
+    Krylov_kernels<T> kernels(a, options.threads);
+    T b_norm = krylov_start(kernels, b, x);
+    Krylov_progress progress(options, b_norm);
+    int n = b.size();
+    int m = options.restart;
+    std::vector<std::vector<T>> basis(1, std::vector<T>(n));
+    std::vector<std::vector<T>> hessenberg(m, std::vector<T>(m + 1));
+    std::vector<T> cosines(m), sines(m), g(m + 1), w(n), z(n);
+    while (progress.running()) {
+        T beta = std::sqrt(krylov_residual(kernels, b, x, basis[0]));
+        if (beta <= options.tolerance * b_norm) {
+            progress.report.converged = true;
+            break;
+        }
+        kernels.reduce([&](int first, int last) {
+            for (int i = first; i < last; ++i) {
+                basis[0][i] /= beta;
+            }
+            return std::array<T, 1>{};
+        });
+        std::fill(g.begin(), g.end(), T());
+        g[0] = beta;
+        int j = 0;
+        while (j < m && progress.running()) {
+            preconditioner.apply(basis[j], z);
+            auto& h = hessenberg[j];
+            h[0] = kernels.multiply(z, w, &basis[0])[0];
+            for (int i = 0; i <= j; ++i) {
+                const std::vector<T>& v = basis[i];
+                const std::vector<T>* next = i < j ? &basis[i + 1] : &w;
+                T factor = h[i];
+                T dot = kernels.reduce([&](int first, int last) {
+                    std::array<T, 1> sum{};
+                    for (int k = first; k < last; ++k) {
+                        w[k] -= factor * v[k];
+                        sum[0] += w[k] * (*next)[k];
+                    }
+                    return sum;
+                })[0];
+                if (i < j) {
+                    h[i + 1] = dot;
+                } else {
+                    h[j + 1] = std::sqrt(dot);
+                }
+            }
+            if (h[j + 1] != T()) {
+                if (int(basis.size()) == j + 1) {
+                    basis.emplace_back(n);
+                }
+                T norm = h[j + 1];
+                auto& v = basis[j + 1];
+                kernels.reduce([&](int first, int last) {
+                    for (int k = first; k < last; ++k) {
+                        v[k] = w[k] / norm;
+                    }
+                    return std::array<T, 1>{};
+                });
+            }
+            for (int i = 0; i < j; ++i) {
+                T rotated = cosines[i] * h[i] + sines[i] * h[i + 1];
+                h[i + 1] = -sines[i] * h[i] + cosines[i] * h[i + 1];
+                h[i] = rotated;
+            }
+            T radius = std::hypot(h[j], h[j + 1]);
+            cosines[j] = h[j] / radius;
+            sines[j] = h[j + 1] / radius;
+            h[j] = radius;
+            h[j + 1] = T();
+            g[j + 1] = -sines[j] * g[j];
+            g[j] = cosines[j] * g[j];
+            ++j;
+            // a breakdown (h[j + 1] = 0) makes the residual vanish as well
+            if (progress.step(std::abs(g[j]))) {
+                break;
+            }
+        }
+        // x += M^-1 V y with H y = g
+        std::vector<T> y(j);
+        for (int i = j - 1; i >= 0; --i) {
+            T sum = g[i];
+            for (int k = i + 1; k < j; ++k) {
+                sum -= hessenberg[k][i] * y[k];
+            }
+            y[i] = sum / hessenberg[i][i];
+        }
+        kernels.reduce([&](int first, int last) {
+            for (int k = first; k < last; ++k) {
+                T sum{};
+                for (int i = 0; i < j; ++i) {
+                    sum += y[i] * basis[i][k];
+                }
+                w[k] = sum;
+            }
+            return std::array<T, 1>{};
+        });
+        preconditioner.apply(w, z);
+        kernels.reduce([&](int first, int last) {
+            for (int k = first; k < last; ++k) {
+                x[k] += z[k];
+            }
+            return std::array<T, 1>{};
+        });
+    }
+    return progress.finish(kernels, b, x);
+}
+
+/**
+ * @brief Solve a x = b by a Krylov method with a preconditioner chosen at run time
+ *
+ * @param a rows of square matrix
+ * @param b right-hand side
+ * @param x initial guess or empty for zero, solution on return
+ * @param method Krylov method
+ * @param type preconditioner
+ * @param options stopping rules
+ * @return Solver_report time includes the setup of the preconditioner
+ */
+template<typename T>
+Solver_report krylov_solve(const Compressed_storage<T>& a, const std::vector<T>& b, std::vector<T>& x,
+                           Krylov_method method, Preconditioner_type type, const Solver_options& options = {}) {
+    auto start = std::chrono::steady_clock::now();
+    auto run = [&](const auto& preconditioner) {
+        switch (method) {
+            case Krylov_method::CG:
+                return conjugate_gradient(a, b, x, preconditioner, options);
+            case Krylov_method::BICGSTAB:
+                return bicgstab(a, b, x, preconditioner, options);
+            default:
+                return gmres(a, b, x, preconditioner, options);
+        }
+    };
+    Solver_report report;
+    switch (type) {
+        case Preconditioner_type::NONE:
+            report = run(Identity_preconditioner<T>());
+            break;
+        case Preconditioner_type::JACOBI:
+            report = run(Jacobi_preconditioner<T>(a, options.threads));
+            break;
+        case Preconditioner_type::ILU0:
+            report = run(Ilu0_preconditioner<T>(a));
+            break;
+        case Preconditioner_type::ICHOL0:
+            report = run(Ichol0_preconditioner<T>(a));
+            break;
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+#endif
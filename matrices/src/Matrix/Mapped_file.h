@@ -0,0 +1,266 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../Exceptions/Exceptions.h"
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ */
+class Mapped_file {
+    /**
+     * @brief mapped bytes, nullptr for empty file
+     */
+    const char* _data = nullptr;
+    /**
+     * @brief size of file
+     */
+    std::size_t _size = 0;
+
+    void unmap() {
+        if (_data != nullptr) {
+            munmap(const_cast<char*>(_data), _size);
+        }
+        _data = nullptr;
+        _size = 0;
+    }
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param filename filename
+     */
+    explicit Mapped_file(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw FileException("Can not open file!");
+        }
+        struct stat info;
+        if (fstat(fd, &info) == -1) {
+            close(fd);
+            throw FileException("Can not open file!");
+        }
+        _size = info.st_size;
+        if (_size != 0) {
+            void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                close(fd);
+                throw FileException("Can not map file!");
+            }
+            _data = static_cast<const char*>(data);
+            madvise(data, _size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+    }
+
+    Mapped_file(const Mapped_file&) = delete;
+    Mapped_file& operator=(const Mapped_file&) = delete;
+
+    /**
+     * @brief Move constructor
+     *
+     * @param other file to move
+     */
+    Mapped_file(Mapped_file&& other) noexcept :
+                _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)) {}
+
+    /**
+     * @brief Move assignment operator
+     *
+     * @param rhs file to move
+     * @return Mapped_file&
+     */
+    Mapped_file& operator=(Mapped_file&& rhs) noexcept {
+        if (this != &rhs) {
+            unmap();
+            _data = std::exchange(rhs._data, nullptr);
+            _size = std::exchange(rhs._size, 0);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Destructor
+     *
+     */
+    ~Mapped_file() {
+        unmap();
+    }
+
+    const char* data() const {
+        return _data;
+    }
+
+    /**
+     * @brief Drop pages of [first, last) from memory, they are read again from file if touched
+     *
+     * @param first first byte
+     * @param last end byte
+     */
+    void release(std::size_t first, std::size_t last) const {
+        std::size_t page = sysconf(_SC_PAGESIZE);
+        first = (first + page - 1) / page * page;
+        last = last / page * page;
+        if (_data != nullptr && first < last) {
+            madvise(const_cast<char*>(_data) + first, last - first, MADV_DONTNEED);
+        }
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+};
+
+/**
+ * @brief Input file read at explicit offsets, reads from several threads do not interfere
+ *
+ */
+class Input_file {
+    /**
+     * @brief file descriptor
+     */
+    int _fd;
+    /**
+     * @brief size of file
+     */
+    std::size_t _size = 0;
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param filename filename
+     */
+    explicit Input_file(const std::string& filename) {
+        _fd = open(filename.c_str(), O_RDONLY);
+        if (_fd == -1) {
+            throw FileException("Can not open file!");
+        }
+        struct stat info;
+        if (fstat(_fd, &info) == -1) {
+            close(_fd);
+            throw FileException("Can not open file!");
+        }
+        _size = info.st_size;
+    }
+
+    Input_file(const Input_file&) = delete;
+    Input_file& operator=(const Input_file&) = delete;
+
+    /**
+     * @brief Destructor
+     *
+     */
+    ~Input_file() {
+        close(_fd);
+    }
+
+    /**
+     * @brief Read bytes [offset, offset + size)
+     *
+     * @param data destination
+     * @param size number of bytes
+     * @param offset position in file
+     */
+    void read(void* data, std::size_t size, std::size_t offset) const {
+        if (offset + size > _size) {
+            throw FileException("Wrong input - file is truncated!");
+        }
+        char* p = static_cast<char*>(data);
+        while (size != 0) {
+            ssize_t got = ::pread(_fd, p, size, offset);
+            if (got <= 0) {
+                throw FileException("Can not read file!");
+            }
+            p += got;
+            size -= got;
+            offset += got;
+        }
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+};
+
+/**
+ * @brief Output file written with large sequential writes
+ *
+ */
+class Output_file {
+    /**
+     * @brief file descriptor
+     */
+    int _fd;
+    /**
+     * @brief number of written bytes
+     */
+    std::size_t _offset = 0;
+public:
+    /**
+     * @brief Constructor, truncates existing file
+     *
+     * @param filename filename
+     */
+    explicit Output_file(const std::string& filename) {
+        _fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (_fd == -1) {
+            throw FileException("Can not open file!");
+        }
+    }
+
+    Output_file(const Output_file&) = delete;
+    Output_file& operator=(const Output_file&) = delete;
+
+    /**
+     * @brief Destructor
+     *
+     */
+    ~Output_file() {
+        close(_fd);
+    }
+
+    /**
+     * @brief Write bytes
+     *
+     * @param data bytes
+     * @param size number of bytes
+     */
+    void write(const void* data, std::size_t size) {
+        const char* p = static_cast<const char*>(data);
+        while (size != 0) {
+            ssize_t written = ::write(_fd, p, size);
+            if (written <= 0) {
+                throw FileException("Can not write file!");
+            }
+            p += written;
+            size -= written;
+            _offset += written;
+        }
+    }
+
+    /**
+     * @brief Write zeros up to the next multiple of alignment
+     *
+     * @param alignment alignment
+     */
+    void pad(std::size_t alignment) {
+        static const char zeros[64] = {};
+        while (_offset % alignment != 0) {
+            write(zeros, std::min(alignment - _offset % alignment, sizeof(zeros)));
+        }
+    }
+
+    std::size_t offset() const {
+        return _offset;
+    }
+};
+
+#endif
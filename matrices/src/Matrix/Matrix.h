@@ -3,13 +3,33 @@
 
 #include <utility>
 #include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
-#include <fstream>
 #include <tuple>
+#include <vector>
 #include "iostream"
 #include "../Exceptions/Exceptions.h"
 #include "../Rational_number/Rational_number.h"
+#include "Compressed_storage.h"
+#include "Shared_buffer.h"
+#include "Spgemm.h"
+#include "Parallel_kernels.h"
+#include "Dense_kernels.h"
+#include "Elementwise_kernels.h"
+#include "Semiring_kernels.h"
+#include "Exact_elimination.h"
+#include "Modular_elimination.h"
+#include "Sparse_factorization.h"
+#include "Krylov_solvers.h"
+#include "Matrix_expression.h"
+#include "Matrix_view.h"
+#include "Matrix_loader.h"
+#include "Matrix_binary.h"
+#include "Tiled_matrix.h"
+#include "Matrix_market.h"
+#include "Matrix_builder.h"
+#include "Block_matrix.h"
 
 using Slice_coords = std::tuple<int, int, int, int>;
 using Cell = std::tuple<int, int>;
@@ -226,9 +246,41 @@ public:
     }
 };
 
+/**
+ * @brief Enum for representations of matrix values
+ * 
+ */
+enum class Storage_format {
+    SPARSE,
+    DENSE,
+};
+
+/**
+ * @brief Enum for methods of exact elimination
+ * 
+ */
+enum class Exact_method {
+    BAREISS,
+    MODULAR,
+};
+
+/**
+ * @brief Share of nonzeros above which matrix switches to dense representation
+ */
+const double DENSE_THRESHOLD = 0.25;
+/**
+ * @brief Largest number of elements of a dense matrix
+ */
+const std::size_t DENSE_MAX_ELEMENTS = std::size_t(1) << 28;
+
 /**
  * @brief Class template for matrices
  * 
+ * Copies share values and get private ones on their first change, so every
+ * thread may work on its own copy. Several threads may read one matrix once
+ * writes made by access operator are merged (any read of the whole matrix
+ * does it), reads switching it between sparse and dense format are writes.
+ * 
  * @tparam T 
  */
 template<typename T>
@@ -238,9 +290,43 @@ class Matrix {
      */
     using Data = std::map<Cell, T>;
     /**
-     * @brief data of matrix
+     * @brief Storage type, rows are major lines (CSR)
      */
-    Data _data{};
+    using Storage = Compressed_storage<T>;
+    /**
+     * @brief nonzeros of matrix, shared by copies until one of them changes
+     */
+    mutable Shared_buffer<Storage> _storage{};
+    /**
+     * @brief elements created by access operator and not merged into storage yet
+     */
+    mutable Data _pending{};
+    /**
+     * @brief true if access operator could have changed values in storage
+     */
+    mutable std::atomic<bool> _dirty{false};
+    /**
+     * @brief row-major values, used instead of storage in dense format
+     */
+    Shared_buffer<std::vector<T>> _dense{};
+    /**
+     * @brief current representation
+     */
+    Storage_format _format = Storage_format::SPARSE;
+    /**
+     * @brief other representation built by const reads, with the values it was built from
+     *
+     * Keeping the source shared makes any write clone it, so a view is stale
+     * exactly when its source no longer shares the current values.
+     */
+    mutable Shared_buffer<Storage> _sparse_view{};
+    mutable Shared_buffer<std::vector<T>> _sparse_view_source{};
+    mutable Shared_buffer<std::vector<T>> _dense_view{};
+    mutable Shared_buffer<Storage> _dense_view_source{};
+    /**
+     * @brief guards flush and views, so const reads may run concurrently
+     */
+    mutable std::mutex _mutex;
     /**
      * @brief epsilon
      */
@@ -254,17 +340,310 @@ class Matrix {
      */
     std::set<Matrix_proxy<T>*> _proxies{};
 
+    bool is_zero(const T& value) const {
+        return double(value) < _eps && double(value) > -_eps;
+    }
+
     void delete_zeros() {
-        std::set<Cell> zeros;
-        for (const auto& [key, value] : _data) {
-            if (double(value) < _eps && double(value) > -_eps) {
-                zeros.insert(key);
+        if (_format == Storage_format::DENSE) {
+            for (auto& value : _dense.write()) {
+                if (is_zero(value)) {
+                    value = T();
+                }
+            }
+        } else {
+            _storage.write().remove_if([this](const T& value) { return is_zero(value); });
+        }
+    }
+
+    void require_permutation(const std::vector<int>& perm, int n) const {
+        std::vector<char> seen(n, false);
+        if (int(perm.size()) != n) {
+            throw MatrixException("Wrong input - permutation does not match dimentions!");
+        }
+        for (int v : perm) {
+            if (v < 0 || v >= n || seen[v]) {
+                throw MatrixException("Wrong input - not a permutation!");
+            }
+            seen[v] = true;
+        }
+    }
+
+    template<typename S>
+    Matrix semiring_product(const Matrix& rhs, const Storage* mask, bool complement) const {
+        if (std::get<1>(_dimentions) != std::get<0>(rhs._dimentions)) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        int columns = std::get<1>(rhs._dimentions);
+        return Matrix(Dimensions{std::get<0>(_dimentions), columns},
+                      semiring_spgemm<S>(storage(), rhs.storage(), columns, mask, complement), _eps);
+    }
+
+    void require_square() const {
+        if (std::get<0>(_dimentions) != std::get<1>(_dimentions)) {
+            throw MatrixException("Matrix is not square!");
+        }
+    }
+
+    std::size_t elements() const {
+        auto [n, m] = _dimentions;
+        return std::size_t(n) * m;
+    }
+
+    /**
+     * @brief Nonzeros of dense values
+     * 
+     * @return Storage
+     */
+    Storage sparse_values() const {
+        auto [n, m] = _dimentions;
+        Storage res(n);
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < m; ++j) {
+                const T& value = (*_dense)[std::size_t(i) * m + j];
+                if (!is_zero(value)) {
+                    res.push_back(j, value);
+                }
+            }
+            res.ptr[i + 1] = res.nnz();
+        }
+        return res;
+    }
+
+    /**
+     * @brief Row-major values of flushed storage
+     * 
+     * @return std::vector<T>
+     */
+    std::vector<T> dense_values_of_storage() const {
+        auto [n, m] = _dimentions;
+        const Storage& storage = *_storage;
+        std::vector<T> dense(elements(), T());
+        for (int i = 0; i < n; ++i) {
+            for (std::size_t k = storage.ptr[i]; k < storage.ptr[i + 1]; ++k) {
+                dense[std::size_t(i) * m + storage.idx[k]] = storage.values[k];
+            }
+        }
+        return dense;
+    }
+
+    /**
+     * @brief Sparse view of dense matrix, built once per values
+     * 
+     * @return const Storage&
+     */
+    const Storage& sparse_view() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_sparse_view_source.shares(_dense)) {
+            _sparse_view = sparse_values();
+            _sparse_view_source = _dense;
+        }
+        return *_sparse_view;
+    }
+
+    /**
+     * @brief Dense view of sparse matrix, built once per values
+     * 
+     * @return const std::vector<T>&
+     */
+    const std::vector<T>& dense_view() const {
+        flush();
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_dense_view_source.shares(_storage)) {
+            _dense_view = dense_values_of_storage();
+            _dense_view_source = _storage;
+        }
+        return *_dense_view;
+    }
+
+    /**
+     * @brief Drop views, references returned by them stay valid while the switched format uses them
+     * 
+     */
+    void drop_views() {
+        _sparse_view = Shared_buffer<Storage>();
+        _sparse_view_source = Shared_buffer<std::vector<T>>();
+        _dense_view = Shared_buffer<std::vector<T>>();
+        _dense_view_source = Shared_buffer<Storage>();
+    }
+
+    /**
+     * @brief Switch to sparse representation, takes over a current view
+     * 
+     */
+    void to_sparse() {
+        if (_format == Storage_format::SPARSE) {
+            return;
+        }
+        if (_sparse_view_source.shares(_dense)) {
+            _storage = _sparse_view;
+        } else {
+            _storage = sparse_values();
+        }
+        drop_views();
+        _dense = std::vector<T>{};
+        _format = Storage_format::SPARSE;
+    }
+
+    /**
+     * @brief Switch to dense representation, takes over a current view
+     * 
+     */
+    void to_dense() {
+        if (_format == Storage_format::DENSE) {
+            return;
+        }
+        flush();
+        if (_dense_view_source.shares(_storage)) {
+            _dense = _dense_view;
+        } else {
+            _dense = dense_values_of_storage();
+        }
+        drop_views();
+        _storage = Storage(std::get<0>(_dimentions));
+        _format = Storage_format::DENSE;
+    }
+
+    /**
+     * @brief Number of nonzeros in dense representation
+     * 
+     * @return std::size_t
+     */
+    std::size_t dense_nnz() const {
+        std::size_t count = 0;
+        for (const auto& value : *_dense) {
+            if (!is_zero(value)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Pick representation by density, dense matrices go back to sparse below half the threshold
+     * 
+     */
+    void choose_format() {
+        if (elements() == 0 || elements() > DENSE_MAX_ELEMENTS) {
+            to_sparse();
+            return;
+        }
+        if (_format == Storage_format::DENSE) {
+            if (dense_nnz() < DENSE_THRESHOLD / 2 * elements()) {
+                to_sparse();
+            }
+        } else if (nnz() > DENSE_THRESHOLD * elements()) {
+            to_dense();
+        }
+    }
+
+    /**
+     * @brief Is dense product cheaper than sparse one
+     * 
+     * @param rhs right matrix
+     * @return true
+     * @return false
+     */
+    bool prefers_dense_product(const Matrix& rhs) const {
+        auto [n, m] = _dimentions;
+        auto [rhs_n, p] = rhs._dimentions;
+        if (std::size_t(n) * p > DENSE_MAX_ELEMENTS || elements() > DENSE_MAX_ELEMENTS ||
+            rhs.elements() > DENSE_MAX_ELEMENTS || elements() == 0 || rhs.elements() == 0) {
+            return false;
+        }
+        auto density = [](const Matrix& matrix) {
+            return double(matrix.nnz()) / matrix.elements();
+        };
+        return density(*this) > DENSE_THRESHOLD && density(rhs) > DENSE_THRESHOLD;
+    }
+
+    /**
+     * @brief Merge elements created by access operator into storage and drop zeros
+     * 
+     * References returned by access operator are invalidated.
+     */
+    void flush() const {
+        if (!_dirty.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_dirty.load(std::memory_order_relaxed)) {
+            return;
+        }
+        auto is_zero = [this](const T& value) { return this->is_zero(value); };
+        if (_pending.empty()) {
+            _storage.write().remove_if(is_zero);
+            _dirty.store(false, std::memory_order_release);
+            return;
+        }
+
+        Storage& current = _storage.write();
+        Storage res(current.major());
+        res.idx.reserve(current.nnz() + _pending.size());
+        res.values.reserve(current.nnz() + _pending.size());
+        auto it = _pending.begin();
+        for (int r = 0; r < current.major(); ++r) {
+            std::size_t k = current.ptr[r];
+            std::size_t end = current.ptr[r + 1];
+            // both sequences are sorted by column and never share a cell
+            while (k < end || (it != _pending.end() && std::get<0>(it->first) == r)) {
+                bool from_pending = it != _pending.end() && std::get<0>(it->first) == r &&
+                                    (k == end || std::get<1>(it->first) < current.idx[k]);
+                if (from_pending) {
+                    if (!is_zero(it->second)) {
+                        res.push_back(std::get<1>(it->first), std::move(it->second));
+                    }
+                    ++it;
+                } else {
+                    if (!is_zero(current.values[k])) {
+                        res.push_back(current.idx[k], std::move(current.values[k]));
+                    }
+                    ++k;
+                }
             }
+            res.ptr[r + 1] = res.nnz();
         }
+        _pending.clear();
+        current = std::move(res);
+        _dirty.store(false, std::memory_order_release);
+    }
+
+    /**
+     * @brief Apply op(a, b) to cells of both matrices in place, cells are selected as in merge_row
+     * 
+     * @param rhs right matrix of equal dimentions
+     * @param op binary operation, missing elements are passed as zero
+     */
+    template<bool LEFT, bool BOTH, bool RIGHT, typename Operation>
+    void merge(const Matrix& rhs, Operation op) {
+        _storage = merge_storages<LEFT, BOTH, RIGHT>(storage(), rhs.storage(), op,
+                                                     [this](const T& value) { return is_zero(value); });
+    }
 
-        for (const auto& key : zeros) {
-            _data.erase(key);
+    /**
+     * @brief Replace every cell by op(this, rhs) in one pass
+     * 
+     * @param rhs matrix of equal dimentions
+     * @param op binary operation with op(0, 0) == 0
+     * @return Matrix&
+     */
+    template<typename Operation>
+    Matrix& update(const Matrix& rhs, Operation op) {
+        if (_dimentions != rhs._dimentions) {
+            throw MatrixException("Dimentions of matrices are not equal!");
+        }
+        if (_format == Storage_format::DENSE && rhs._format == Storage_format::DENSE) {
+            std::vector<T>& values = _dense.write();
+            const std::vector<T>& other = *rhs._dense;
+            for (std::size_t k = 0; k < values.size(); ++k) {
+                values[k] = op(values[k], other[k]);
+            }
+            delete_zeros();
+        } else {
+            merge<true, true, true>(rhs, op);
         }
+        choose_format();
+        return *this;
     }
 
 public:
@@ -287,119 +666,125 @@ public:
      * @param eps epsilon
      * @param identity if needs identity matrix
      */
-    Matrix(int n = 0, int m = 0, T value = 0, double eps = 0.0001, bool identity = false) {
+    Matrix(int n = 0, int m = 0, T value = T(), double eps = 0.0001, bool identity = false) : _storage(Storage(n)) {
         _dimentions = {n, m};
         _eps = eps;
 
         if (identity) {
-            if (value == 0) value = 1;
-            for (int i = 0; i < n; ++i) {
-                _data[{i, i}] = value;
-            }
-        } else if (!(double(value) < eps && double(value) > -eps)) {
+            if (value == T()) value = 1;
+            Storage& storage = _storage.write();
             for (int i = 0; i < n; ++i) {
-                for (int j = 0; j < m; ++j) {
-                    _data.insert({{i, j}, value});
+                if (i < m) {
+                    storage.push_back(i, value);
                 }
+                storage.ptr[i + 1] = storage.nnz();
             }
+        } else if (!is_zero(value)) {
+            _dense = std::vector<T>(elements(), value);
+            _format = Storage_format::DENSE;
         }
     }
 
     /**
-     * @brief Constructor from file
+     * @brief Constructor from file in text or Matrix Market format
      * 
      * @param filename filename
      */
     Matrix(const std::string& filename) {
-        std::ifstream in;
-        in.open(filename);
-
-        if (!in.is_open()) {
-            throw FileException("Can not open file!");
-        }
-
-        std::string line;
-        bool got_dimentions = false;
-        while (std::getline(in, line)) {
-            std::stringstream ss;
-            ss << line;
+        auto is_zero = [this](const T& value) { return this->is_zero(value); };
+        auto [dimentions, storage] = is_matrix_market(Mapped_file(filename)) ?
+                                     load_matrix_market<T>(filename, is_zero) : load_text_matrix<T>(filename, is_zero);
+        _dimentions = dimentions;
+        _storage = std::move(storage);
+        choose_format();
+    }
 
-            std::string word;
-            if (!(ss >> word) || word[0] == '#') { 
-                continue; 
-            }
-            
-            if (!got_dimentions) {
-                if (word != "matrix") { 
-                    throw FileException("Wrong input - expected matrix!");
-                }
-                ss >> word;
-                if (word != "rational") { 
-                    throw FileException("Wrong input - expected rational!");
-                }
-                int n, m;
-                if (!(ss >> n >> m)) {
-                    throw FileException("Wrong input - expected dimentions!");
-                }
-                if (ss >> word && word[0] != '#') {
-                    throw FileException("Wrong input - does not expect comment!");
-                }
-                got_dimentions = true;
-                _dimentions = {n, m};
-            } else {
-                int i = std::stoi(word), j;
-                if (!(ss >> j)) { 
-                    throw FileException("Wrong input - expected index!");
-                }
-                std::string num;
-                while (ss >> word) {
-                    num += ' ';
-                    num += word;
-                }
-                T value{num.c_str()};
+    /**
+     * @brief Constructor from dimentions
+     * 
+     * @param dimentions matrix dimentions
+     */
+    explicit Matrix(const Dimensions& dimentions) : _storage(Storage(std::get<0>(dimentions))), _dimentions(dimentions) {};
 
-                auto [n, m] = _dimentions;
-                if (i < 0 || i >= n || j < 0 || j >= m) {
-                    throw FileException("Wrong input - indices are out of range!");
-                }
+    /**
+     * @brief Constructor from map-based data
+     * 
+     * @param dimentions matrix dimentions
+     * @param data map from cell to value
+     * @param eps epsilon
+     */
+    Matrix(const Dimensions& dimentions, const Data& data, double eps = 0.0001) :
+           _storage(Storage::from_map(data, std::get<0>(dimentions))), _eps(eps), _dimentions(dimentions) {
+        delete_zeros();
+        choose_format();
+    }
 
-                if (double(value) < _eps && double(value) > -_eps) {
-                    _data.erase({i, j});
-                } else {
-                    _data[{i, j}] = value;
-                }
-            }
+    /**
+     * @brief Constructor from compressed storage
+     * 
+     * @param dimentions matrix dimentions
+     * @param storage CSR storage with sorted columns
+     * @param eps epsilon
+     */
+    Matrix(const Dimensions& dimentions, Storage storage, double eps = 0.0001) :
+           _storage(std::move(storage)), _eps(eps), _dimentions(dimentions) {
+        if (_storage->major() != std::get<0>(dimentions)) {
+            throw MatrixException("Storage does not match dimentions!");
         }
-        in.close();
         delete_zeros();
+        choose_format();
     }
 
     /**
-     * @brief Constructor from dimentions
+     * @brief Constructor from lazy expression
      * 
-     * @param dimentions matrix dimentions
+     * Nonzeros of the whole expression are computed in one pass and written
+     * straight into the new matrix, no temporary matrices are created.
+     * 
+     * @param expression expression of matrices
      */
-    explicit Matrix(const Dimensions& dimentions) : _dimentions(dimentions) {};
+    template<typename E, typename = std::enable_if_t<is_matrix_expression_v<E>>>
+    Matrix(const E& expression) : _eps(expression.eps()), _dimentions(expression.dimentions()) {
+        if (expression.dense()) {
+            _storage = Storage(std::get<0>(_dimentions));
+            _dense = evaluate_dense(expression);
+            _format = Storage_format::DENSE;
+            delete_zeros();
+        } else {
+            _storage = evaluate(expression);
+        }
+        choose_format();
+    }
 
     /**
-     * @brief Copy constructor
+     * @brief Copy constructor, O(1), values are shared until one of the matrices changes
      * 
      * @param other matrix to copy
      */
     Matrix(const Matrix& other) {
         _dimentions = other._dimentions;
-        _data = other._data;
+        _eps = other._eps;
+        other.flush();
+        _storage = other._storage;
+        _dense = other._dense;
+        _format = other._format;
     }
 
     /**
-     * @brief Assignment operator
+     * @brief Assignment operator, O(1), values are shared until one of the matrices changes
      * 
      * @param other matrix to copy
      * @return Matrix& 
      */
     Matrix& operator=(const Matrix& rhs) {
         _dimentions = rhs._dimentions;
-        _data = rhs._data;
+        _eps = rhs._eps;
+        rhs.flush();
+        _storage = rhs._storage;
+        _dense = rhs._dense;
+        _format = rhs._format;
+        _pending.clear();
+        _dirty = false;
         return *this;
     }
 
@@ -410,7 +795,12 @@ public:
      */
     Matrix(Matrix&& other) noexcept {
         _dimentions = std::move(other._dimentions);
-        _data = std::move(other._data);
+        _eps = other._eps;
+        _storage = std::move(other._storage);
+        _pending = std::move(other._pending);
+        _dirty = other._dirty.load();
+        _dense = std::move(other._dense);
+        _format = other._format;
     }
 
     /**
@@ -421,7 +811,12 @@ public:
      */
     Matrix& operator=(Matrix&& rhs) noexcept {
         _dimentions = std::move(rhs._dimentions);
-        _data = std::move(rhs._data);
+        _eps = rhs._eps;
+        _storage = std::move(rhs._storage);
+        _pending = std::move(rhs._pending);
+        _dirty = rhs._dirty.load();
+        _dense = std::move(rhs._dense);
+        _format = rhs._format;
         return *this;
     }
 
@@ -432,14 +827,7 @@ public:
      * @return Matrix&
      */
     Matrix& operator+=(const Matrix& rhs) {
-        if (_dimentions != rhs._dimentions) {
-            throw MatrixException("Dimentions of matrices are not equal!");
-        }
-        for (const auto& [key, value] : rhs._data) {
-            _data[key] += value;
-        }
-        delete_zeros();
-        return *this;
+        return update(rhs, [](const T& a, const T& b) { return a + b; });
     }
 
     /**
@@ -449,120 +837,430 @@ public:
      * @return Matrix&
      */
     Matrix& operator-=(const Matrix& rhs) {
-        *this += -rhs;
-        delete_zeros();
-        return *this;
+        return update(rhs, [](const T& a, const T& b) { return a - b; });
     }
 
     /**
-     * @brief *= operator
+     * @brief Element-wise (Hadamard) product, only cells nonzero in both matrices are visited
      * 
-     * @param rhs matrix with whom multiply
-     * @return Matrix& 
+     * @param rhs matrix of equal dimentions
+     * @return Matrix
      */
-    Matrix& operator*=(const Matrix& rhs) {
-        auto [lhs_n, lhs_m] = _dimentions;
-        auto [rhs_n, rhs_m] = rhs._dimentions;
-
-        if (lhs_m != rhs_n) {
-            throw MatrixException("Dimentions are not compatible!");
+    Matrix hadamard(const Matrix& rhs) const {
+        if (_dimentions != rhs._dimentions) {
+            throw MatrixException("Dimentions of matrices are not equal!");
         }
-
-        Matrix res{lhs_n, rhs_m};
-        for (const auto& [left_coords, left_value] : _data) {
-            auto [left_r, left_c] = left_coords;
-            for (const auto& [right_coords, right_value] : rhs._data) {
-                auto [right_r, right_c] = right_coords;
-                if (left_c == right_r) {
-                    res._data[{left_r, right_c}] += left_value * right_value; 
-                }
+        auto multiply = [](const T& a, const T& b) { return a * b; };
+        if (_format == Storage_format::DENSE && rhs._format == Storage_format::DENSE) {
+            Matrix res(*this);
+            std::vector<T>& values = res._dense.write();
+            const std::vector<T>& other = *rhs._dense;
+            for (std::size_t k = 0; k < values.size(); ++k) {
+                values[k] = multiply(values[k], other[k]);
             }
+            res.delete_zeros();
+            res.choose_format();
+            return res;
         }
-
-        res.delete_zeros();
-
-        return *this = res;
+        return Matrix(_dimentions, merge_storages<false, true, false>(storage(), rhs.storage(), multiply,
+                      [this](const T& value) { return is_zero(value); }), _eps);
     }
 
     /**
-     * @brief unary - operator
+     * @brief Elements in cells where mask is nonzero, or zero if complement is set
      * 
+     * @param mask matrix of equal dimentions, only its pattern is used
+     * @param complement keep cells where mask is zero
      * @return Matrix
      */
-    Matrix operator-() const {
-        Matrix copy = *this;
-        for (const auto& [key, value] : copy._data) {
-            copy._data[key] = -copy._data[key];
+    Matrix masked(const Matrix& mask, bool complement = false) const {
+        if (_dimentions != mask._dimentions) {
+            throw MatrixException("Dimentions of matrices are not equal!");
         }
-        copy.delete_zeros();
-        return copy;
+        auto keep = [](const T& a, const T&) { return a; };
+        auto is_zero = [this](const T& value) { return this->is_zero(value); };
+        Storage res = complement ? merge_storages<true, false, false>(storage(), mask.storage(), keep, is_zero)
+                                 : merge_storages<false, true, false>(storage(), mask.storage(), keep, is_zero);
+        return Matrix(_dimentions, std::move(res), _eps);
     }
 
     /**
-     * @brief + operator
+     * @brief Sparse product in semiring S, e.g. Min_plus or Or_and
+     * 
+     * Stored elements are the edges of a graph, results equal to S::zero() or
+     * within eps of zero are not stored.
      * 
-     * @param lhs left matrix
      * @param rhs right matrix
      * @return Matrix
      */
-    friend Matrix operator+(Matrix lhs, const Matrix& rhs) {
-        lhs += rhs;
-        lhs.delete_zeros();
-        return lhs;
+    template<typename S>
+    Matrix mxm(const Matrix& rhs) const {
+        return semiring_product<S>(rhs, nullptr, false);
     }
 
     /**
-     * @brief - operator
+     * @brief Masked sparse product C<mask> = A B in semiring S
+     * 
+     * Only cells in the pattern of mask (outside it if complement is set) are
+     * computed.
      * 
-     * @param lhs left matrix
      * @param rhs right matrix
+     * @param mask matrix of dimentions of the product, only its pattern is used
+     * @param complement compute cells outside the pattern instead
      * @return Matrix
      */
-    friend Matrix operator-(Matrix lhs, const Matrix& rhs) {
-        lhs -= rhs;
-        lhs.delete_zeros();
-        return lhs;
+    template<typename S>
+    Matrix mxm(const Matrix& rhs, const Matrix& mask, bool complement = false) const {
+        if (mask._dimentions != Dimensions{std::get<0>(_dimentions), std::get<1>(rhs._dimentions)}) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        return semiring_product<S>(rhs, &mask.storage(), complement);
     }
 
     /**
-     * @brief * operator
+     * @brief Masked w<mask> = accumulate(w, A u) in semiring S
      * 
-     * @param lhs left matrix
-     * @param rhs right matrix
+     * @param w output, empty for a vector of S::zero()
+     * @param u vector of size equal to the number of columns
+     * @param mask rows to write, the other entries of w are kept
+     * @param accumulate accumulate(old, result), by default result
+     */
+    template<typename S, typename Accumulator = No_accumulator>
+    void mxv(std::vector<T>& w, const std::vector<T>& u, const Vector_mask& mask = {},
+             Accumulator accumulate = {}) const {
+        auto [n, m] = _dimentions;
+        if (w.empty()) {
+            w.assign(n, S::zero());
+        }
+        if (int(w.size()) != n || int(u.size()) != m) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        semiring_mxv<S>(w, mask, accumulate, storage(), u);
+    }
+
+    /**
+     * @brief Masked w<mask> = accumulate(w, u^T A) in semiring S, cost follows the entries of u
+     * 
+     * @param w output, empty for a vector of S::zero()
+     * @param u vector of size equal to the number of rows
+     * @param mask columns to write, the other entries of w are kept
+     * @param accumulate accumulate(old, result), by default result
+     */
+    template<typename S, typename Accumulator = No_accumulator>
+    void vxm(std::vector<T>& w, const std::vector<T>& u, const Vector_mask& mask = {},
+             Accumulator accumulate = {}) const {
+        auto [n, m] = _dimentions;
+        if (w.empty()) {
+            w.assign(m, S::zero());
+        }
+        if (int(w.size()) != m || int(u.size()) != n) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        semiring_vxm<S>(w, mask, accumulate, u, storage(), m);
+    }
+
+    /**
+     * @brief Element-wise addition in semiring S over the union of patterns
+     * 
+     * @param rhs matrix of equal dimentions
      * @return Matrix
      */
-    friend Matrix operator*(Matrix lhs, const Matrix& rhs) {
-        lhs *= rhs;
-        lhs.delete_zeros();
-        return lhs;
+    template<typename S>
+    Matrix ewise_add(const Matrix& rhs) const {
+        if (_dimentions != rhs._dimentions) {
+            throw MatrixException("Dimentions of matrices are not equal!");
+        }
+        return Matrix(_dimentions, semiring_ewise_add<S>(storage(), rhs.storage()), _eps);
     }
 
     /**
-     * @brief Matrix * value operator
+     * @brief Element-wise multiplication in semiring S over the intersection of patterns
      * 
-     * @param lhs left matrix
-     * @param value value of type T
+     * @param rhs matrix of equal dimentions
      * @return Matrix
      */
-    friend Matrix operator*(const Matrix& lhs, T value) {
-        Matrix copy{lhs};
-        copy *= value;
-        copy.delete_zeros();
-        return copy;
+    template<typename S>
+    Matrix ewise_mult(const Matrix& rhs) const {
+        if (_dimentions != rhs._dimentions) {
+            throw MatrixException("Dimentions of matrices are not equal!");
+        }
+        return Matrix(_dimentions, semiring_ewise_mult<S>(storage(), rhs.storage()), _eps);
     }
 
     /**
-     * @brief value * Matrix operator
+     * @brief Exact determinant of square matrix of rational numbers
      * 
-     * @param value value of type T
+     * MODULAR eliminates modulo several primes on the thread pool and falls back
+     * to BAREISS if the result does not stabilize.
+     * 
+     * @param method method of elimination
+     * @return T
+     */
+    T determinant(Exact_method method = Exact_method::BAREISS) const {
+        require_square();
+        if (method == Exact_method::MODULAR) {
+            if (auto res = modular_determinant(storage())) {
+                return *res;
+            }
+        }
+        return Bareiss_elimination<T>(storage(), std::get<1>(_dimentions), Storage(), false).determinant();
+    }
+
+    /**
+     * @brief Exact rank of matrix of rational numbers
+     * 
+     * @return int
+     */
+    int rank() const {
+        return Bareiss_elimination<T>(storage(), std::get<1>(_dimentions), Storage(), false).rank();
+    }
+
+    /**
+     * @brief Exact solution x of A x = b for nonsingular square matrix of rational numbers
+     * 
+     * @param b right-hand side of size equal to the number of rows
+     * @param method method of elimination, see determinant()
+     * @return std::vector<T>
+     */
+    std::vector<T> solve(const std::vector<T>& b, Exact_method method = Exact_method::BAREISS) const {
+        require_square();
+        int n = std::get<0>(_dimentions);
+        if (int(b.size()) != n) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        if (method == Exact_method::MODULAR) {
+            if (auto res = modular_solve(storage(), b)) {
+                return std::move(*res);
+            }
+        }
+        Storage rhs(n);
+        for (int r = 0; r < n; ++r) {
+            if (!(b[r] == T())) {
+                rhs.push_back(0, b[r]);
+            }
+            rhs.ptr[r + 1] = rhs.nnz();
+        }
+        Storage x = Bareiss_elimination<T>(storage(), n, rhs, true).solution();
+        std::vector<T> res(n, T());
+        for (int r = 0; r < n; ++r) {
+            if (x.ptr[r] != x.ptr[r + 1]) {
+                res[r] = x.values[x.ptr[r]];
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief Exact inverse of nonsingular square matrix of rational numbers
+     * 
+     * @return Matrix
+     */
+    Matrix inverse() const {
+        require_square();
+        int n = std::get<0>(_dimentions);
+        Storage identity(n);
+        for (int r = 0; r < n; ++r) {
+            identity.push_back(r, T(1));
+            identity.ptr[r + 1] = identity.nnz();
+        }
+        // entries of the inverse below eps are exact values too, so only exact zeros are dropped
+        Matrix res(_dimentions);
+        res._eps = _eps;
+        res._storage = Bareiss_elimination<T>(storage(), n, identity, true).solution();
+        res._storage.write().remove_if([](const T& value) { return value == T(); });
+        res.choose_format();
+        return res;
+    }
+
+    /**
+     * @brief Sparse Cholesky factorization of symmetric positive definite matrix
+     * 
+     * The factorization is reusable: solve() of every right-hand side costs two
+     * triangular sweeps.
+     * 
+     * @return Sparse_cholesky<T>
+     */
+    Sparse_cholesky<T> cholesky() const {
+        require_square();
+        return Sparse_cholesky<T>(storage());
+    }
+
+    /**
+     * @brief Iterative solution of A x = b by a preconditioned Krylov method
+     * 
+     * CG needs a symmetric positive definite matrix and preconditioner, ICHOL0
+     * needs a symmetric positive definite matrix.
+     * 
+     * @param b right-hand side of size equal to the number of rows
+     * @param x initial guess or empty for zero, solution on return
+     * @param method Krylov method
+     * @param preconditioner preconditioner
+     * @param options tolerance, iteration limit, threads and monitor
+     * @return Solver_report iterations, residual and time
+     */
+    Solver_report iterative_solve(const std::vector<T>& b, std::vector<T>& x,
+                                  Krylov_method method = Krylov_method::CG,
+                                  Preconditioner_type preconditioner = Preconditioner_type::JACOBI,
+                                  const Solver_options& options = {}) const {
+        require_square();
+        return krylov_solve(storage(), b, x, method, preconditioner, options);
+    }
+
+    /**
+     * @brief Sparse LU factorization with partial pivoting of nonsingular square matrix
+     * 
+     * @return Sparse_lu<T>
+     */
+    Sparse_lu<T> lu() const {
+        require_square();
+        return Sparse_lu<T>(storage());
+    }
+
+    /**
+     * @brief Largest distance of a nonzero from the diagonal
+     * 
+     * @return int
+     */
+    int bandwidth() const {
+        return storage_bandwidth(storage());
+    }
+
+    /**
+     * @brief Profile: sum over rows of the distance from the first nonzero to the diagonal
+     * 
+     * @return std::size_t
+     */
+    std::size_t profile() const {
+        return storage_profile(storage());
+    }
+
+    /**
+     * @brief Symmetric ordering of the pattern of A + A^T
+     * 
+     * RCM reduces bandwidth and profile, PARTITION lays out cache-sized parts
+     * of recursive bisection one after another.
+     * 
+     * @param method ordering
+     * @return std::vector<int> old index of every new index
+     */
+    std::vector<int> ordering(Reordering method = Reordering::RCM) const {
+        require_square();
+        std::vector<std::vector<int>> adjacency = symmetric_adjacency(storage());
+        return method == Reordering::RCM ? reverse_cuthill_mckee(adjacency) : partition_ordering(adjacency);
+    }
+
+    /**
+     * @brief Permute rows and columns in place: A = P A Q^T
+     * 
+     * @param rows old index of every new row
+     * @param columns old index of every new column
+     * @return Matrix&
+     */
+    Matrix& permute(const std::vector<int>& rows, const std::vector<int>& columns) {
+        require_permutation(rows, std::get<0>(_dimentions));
+        require_permutation(columns, std::get<1>(_dimentions));
+        _storage = permute_storage(storage(), rows, columns);
+        choose_format();
+        return *this;
+    }
+
+    /**
+     * @brief Permute rows and columns of square matrix symmetrically in place: A = P A P^T
+     * 
+     * @param order old index of every new index
+     * @return Matrix&
+     */
+    Matrix& permute(const std::vector<int>& order) {
+        require_square();
+        return permute(order, order);
+    }
+
+    /**
+     * @brief Reorder square matrix symmetrically in place
+     * 
+     * A system A x = b becomes (P A P^T)(P x) = P b: entry k of the new
+     * vectors is entry permutation[k] of the old ones.
+     * 
+     * @param method ordering
+     * @return Reordering_report permutation, bandwidth and profile before and after
+     */
+    Reordering_report reorder(Reordering method = Reordering::RCM) {
+        Reordering_report res;
+        res.bandwidth_before = bandwidth();
+        res.profile_before = profile();
+        res.permutation = ordering(method);
+        permute(res.permutation);
+        res.bandwidth_after = bandwidth();
+        res.profile_after = profile();
+        return res;
+    }
+
+    /**
+     * @brief Block size of the BSR layout with the least SpMV memory traffic
+     * 
+     * @return int one of BLOCK_SIZES, 1 if blocking does not pay off
+     */
+    int block_size() const {
+        return detect_block_size(storage(), std::get<1>(_dimentions));
+    }
+
+    /**
+     * @brief *= operator
+     * 
+     * @param rhs matrix with whom multiply
+     * @return Matrix& 
+     */
+    Matrix& operator*=(const Matrix& rhs) {
+        auto [lhs_n, lhs_m] = _dimentions;
+        auto [rhs_n, rhs_m] = rhs._dimentions;
+
+        if (lhs_m != rhs_n) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+
+        if (prefers_dense_product(rhs)) {
+            to_dense();
+            const std::vector<T>& right = rhs.dense_values();
+            std::vector<T> res(std::size_t(lhs_n) * rhs_m, T());
+            dense_gemm(_dense->data(), right.data(), res.data(), lhs_n, lhs_m, rhs_m);
+            _dimentions = {lhs_n, rhs_m};
+            _dense = std::move(res);
+            _storage = Storage(lhs_n);
+            delete_zeros();
+        } else {
+            Storage res = parallel_spgemm(storage(), rhs.storage(), rhs_m,
+                                          [this](const T& value) { return is_zero(value); });
+            _dimentions = {lhs_n, rhs_m};
+            _storage = std::move(res);
+        }
+        choose_format();
+        return *this;
+    }
+
+    /**
+     * @brief * operator
+     * 
+     * @param lhs left matrix
      * @param rhs right matrix
      * @return Matrix
      */
-    friend Matrix operator*(T value, const Matrix& lhs) {
-        Matrix copy{lhs};
-        copy *= value;
-        copy.delete_zeros();
-        return copy;
+    friend Matrix operator*(Matrix lhs, const Matrix& rhs) {
+        lhs *= rhs;
+        return lhs;
+    }
+
+    /**
+     * @brief Matrix * vector operator
+     * 
+     * @param lhs left matrix
+     * @param x vector of size equal to the number of columns
+     * @return std::vector<T>
+     */
+    friend std::vector<T> operator*(const Matrix& lhs, const std::vector<T>& x) {
+        if (int(x.size()) != std::get<1>(lhs._dimentions)) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        return parallel_spmv(lhs.storage(), x);
     }
 
     /**
@@ -572,8 +1270,9 @@ public:
      * @return Matrix&
      */
     Matrix& operator*=(T value) {
-        for (const auto& [key, other] : _data) {
-            _data[key] *= value;
+        flush();
+        for (auto& other : _format == Storage_format::DENSE ? _dense.write() : _storage.write().values) {
+            other *= value;
         }
         delete_zeros();
         return *this;
@@ -588,9 +1287,20 @@ public:
         auto [n, m] = _dimentions;
         Dimensions d = {m, n};
         Matrix transpose{d};
-        for (const auto& [key, value] : _data) {
-            auto [r1, c1] = key;
-            transpose._data[{c1, r1}] = value;
+        transpose._eps = _eps;
+        if (_format == Storage_format::DENSE) {
+            const std::vector<T>& values = *_dense;
+            std::vector<T> transposed(elements());
+            for (int i = 0; i < n; ++i) {
+                for (int j = 0; j < m; ++j) {
+                    transposed[std::size_t(j) * n + i] = values[std::size_t(i) * m + j];
+                }
+            }
+            transpose._dense = std::move(transposed);
+            transpose._storage = Storage(m);
+            transpose._format = Storage_format::DENSE;
+        } else {
+            transpose._storage = storage().transposed(m);
         }
         return transpose;
     }
@@ -604,7 +1314,21 @@ public:
      * @return false 
      */
     friend bool operator==(const Matrix& lhs, const Matrix& rhs) {
-        return lhs._dimentions == rhs._dimentions && lhs._data == rhs._data;
+        if (lhs._dimentions != rhs._dimentions) {
+            return false;
+        }
+        if (lhs._format == Storage_format::DENSE && rhs._format == Storage_format::DENSE) {
+            const std::vector<T>& a = *lhs._dense;
+            const std::vector<T>& b = *rhs._dense;
+            for (std::size_t k = 0; k < a.size(); ++k) {
+                bool both_zero = lhs.is_zero(a[k]) && rhs.is_zero(b[k]);
+                if (!both_zero && !(a[k] == b[k])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return lhs.storage() == rhs.storage();
     }
 
     /**
@@ -629,17 +1353,113 @@ public:
     }
 
     /**
-     * @brief Get data from matrix
+     * @brief Get data from matrix in map-based format
      * 
      * @return Data
      */
     Data get_data() const {
-        return _data;
+        return storage().to_map();
+    }
+
+    /**
+     * @brief Get compressed storage of matrix, switches to sparse format
+     * 
+     * @return const Storage& 
+     */
+    const Storage& storage() {
+        to_sparse();
+        flush();
+        return *_storage;
+    }
+
+    /**
+     * @brief Get compressed storage of matrix, a dense matrix keeps its format and builds a view
+     * 
+     * Safe to call from several threads at once.
+     * 
+     * @return const Storage& 
+     */
+    const Storage& storage() const {
+        if (_format == Storage_format::DENSE) {
+            return sparse_view();
+        }
+        flush();
+        return *_storage;
+    }
+
+    /**
+     * @brief Get row-major dense values of matrix, switches to dense format
+     * 
+     * @return const std::vector<T>& 
+     */
+    const std::vector<T>& dense_values() {
+        to_dense();
+        return *_dense;
+    }
+
+    /**
+     * @brief Get row-major dense values of matrix, a sparse matrix keeps its format and builds a view
+     * 
+     * Safe to call from several threads at once.
+     * 
+     * @return const std::vector<T>& 
+     */
+    const std::vector<T>& dense_values() const {
+        if (_format == Storage_format::DENSE) {
+            return *_dense;
+        }
+        return dense_view();
+    }
+
+    /**
+     * @brief Is matrix stored densely
+     * 
+     * @return true
+     * @return false
+     */
+    bool is_dense() const {
+        return _format == Storage_format::DENSE;
+    }
+
+    /**
+     * @brief Do matrices share values, copies share them until one of them changes
+     * 
+     * @param other matrix
+     * @return true
+     * @return false
+     */
+    bool shares_values(const Matrix& other) const {
+        return _format == other._format && (_format == Storage_format::DENSE ? _dense.shares(other._dense)
+                                                                             : _storage.shares(other._storage));
+    }
+
+    /**
+     * @brief Number of nonzeros
+     * 
+     * @return std::size_t
+     */
+    std::size_t nnz() const {
+        if (_format == Storage_format::DENSE) {
+            return dense_nnz();
+        }
+        return storage().nnz();
+    }
+
+    /**
+     * @brief Get epsilon
+     * 
+     * @return double
+     */
+    double get_eps() const {
+        return _eps;
     }
 
     /**
      * @brief Access operator
      * 
+     * Returned reference stays valid until the next operation that reads the whole matrix
+     * or copies it.
+     * 
      * @param i first index
      * @param j second index
      * @return T& 
@@ -649,7 +1469,39 @@ public:
         if (i < 0 || j < 0 || i >= n || j >= m) {
             throw MatrixException("Indices of slice are wrong!");
         }
-        return _data[{i, j}];
+        drop_views();
+        if (_format == Storage_format::DENSE) {
+            return _dense.write()[std::size_t(i) * m + j];
+        }
+        _dirty = true;
+        std::size_t pos = _storage->find(i, j);
+        if (pos != _storage->nnz()) {
+            return _storage.write().values[pos];
+        }
+        return _pending[{i, j}];
+    }
+
+    /**
+     * @brief Read-only access, never creates elements
+     * 
+     * @param i first index
+     * @param j second index
+     * @return T 
+     */
+    T at(int i, int j) const {
+        auto [n, m] = _dimentions;
+        if (i < 0 || j < 0 || i >= n || j >= m) {
+            throw MatrixException("Indices of slice are wrong!");
+        }
+        if (_format == Storage_format::DENSE) {
+            return (*_dense)[std::size_t(i) * m + j];
+        }
+        std::size_t pos = _storage->find(i, j);
+        if (pos != _storage->nnz()) {
+            return _storage->values[pos];
+        }
+        auto it = _pending.find({i, j});
+        return it == _pending.end() ? T() : it->second;
     }
 
     /**
@@ -667,6 +1519,41 @@ public:
         return Matrix_proxy<T>(this, coords);
     }
 
+    /**
+     * @brief Read-only view of slice, nothing is copied or registered
+     * 
+     * @param coords coords of slice, -1 means the edge of matrix
+     * @return Matrix_view<T> 
+     */
+    Matrix_view<T> view(const Matrix_coords& coords) const {
+        auto [r1, c1, r2, c2] = coords.get_coords();
+        auto [n, m] = _dimentions;
+        return Matrix_view<T>(*this, r1 == -1 ? 0 : r1, c1 == -1 ? 0 : c1,
+                              r2 == -1 ? n - 1 : r2, c2 == -1 ? m - 1 : c2);
+    }
+
+    /**
+     * @brief Read-only view of row
+     * 
+     * @param matrix_row row
+     * @return Matrix_view<T> 
+     */
+    Matrix_view<T> view(Matrix_row_coord matrix_row) const {
+        int row = matrix_row.get_coords();
+        return Matrix_view<T>(*this, row, 0, row, std::get<1>(_dimentions) - 1);
+    }
+
+    /**
+     * @brief Read-only view of column
+     * 
+     * @param matrix_column column
+     * @return Matrix_view<T> 
+     */
+    Matrix_view<T> view(Matrix_column_coord matrix_column) const {
+        int column = matrix_column.get_coords();
+        return Matrix_view<T>(*this, 0, column, std::get<0>(_dimentions) - 1, column);
+    }
+
     /**
      * @brief Add proxy
      * 
@@ -685,6 +1572,60 @@ public:
         _proxies.erase(proxy);
     }
 
+    /**
+     * @brief Save matrix in text format
+     * 
+     * @param filename filename
+     */
+    void save(const std::string& filename) const {
+        const Storage& s = storage();
+        write_text_matrix<T>(filename, _dimentions, s.ptr.data(), s.idx.data(),
+                             [&s](std::size_t k) -> const T& { return s.values[k]; });
+    }
+
+    /**
+     * @brief Save matrix in binary format
+     * 
+     * @param filename filename
+     */
+    void save_binary(const std::string& filename) const {
+        write_binary_matrix(filename, _dimentions, storage());
+    }
+
+    /**
+     * @brief Save matrix in tiled format for out-of-core operations
+     * 
+     * @param filename filename
+     * @param tile_size side of tiles
+     */
+    void save_tiled(const std::string& filename, int tile_size = TILE_SIZE) const {
+        write_tiled_matrix(filename, _dimentions, storage(), tile_size);
+    }
+
+    /**
+     * @brief Load matrix saved in binary format
+     * 
+     * Binary_matrix_view reads the file in place without loading it.
+     * 
+     * @param filename filename
+     * @param eps epsilon
+     * @return Matrix
+     */
+    static Matrix load_binary(const std::string& filename, double eps = 0.0001) {
+        Binary_matrix_view<T> view(filename);
+        return Matrix(view.dimentions(), view.to_storage(), eps);
+    }
+
+    /**
+     * @brief Save matrix in Matrix Market coordinate format
+     * 
+     * @param filename filename
+     * @param symmetric write lower triangle of symmetric matrix
+     */
+    void save_matrix_market(const std::string& filename, bool symmetric = false) const {
+        write_matrix_market(filename, _dimentions, storage(), symmetric);
+    }
+
     /**
      * @brief Overload of ostream
      * 
@@ -704,13 +1645,15 @@ public:
     std::string to_string() const {
         std::ostringstream ss;
         auto [n, m] = _dimentions;
+        const Storage& s = storage();
         ss << "matrix " << "rational " << n << " " << m << "\n";
-        for (const auto& [key, value] : _data) {
-            auto [r1, c1] = key;
-            ss << r1 << " " << c1 << " " << value << std::endl;
+        for (int r = 0; r < s.major(); ++r) {
+            for (std::size_t k = s.ptr[r]; k < s.ptr[r + 1]; ++k) {
+                ss << r << " " << s.idx[k] << " " << s.values[k] << '\n';
+            }
         }
         return ss.str();
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,387 @@
+#ifndef MATRIX_BINARY_H
+#define MATRIX_BINARY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Mapped_file.h"
+#include "Matrix_loader.h"
+#include "../Exceptions/Exceptions.h"
+#include "../Rational_number/Rational_number.h"
+
+/**
+ * @brief Current version of the binary format
+ */
+const std::uint32_t BINARY_MATRIX_VERSION = 1;
+/**
+ * @brief Alignment of header and every array in the binary format
+ */
+const std::size_t BINARY_MATRIX_ALIGNMENT = 64;
+/**
+ * @brief Written in native byte order, detects files from machines with other order
+ */
+const std::uint32_t BINARY_MATRIX_BYTE_ORDER = 0x01020304;
+
+/**
+ * @brief Header of the binary format
+ *
+ * The header is followed by arrays, each starting at a multiple of
+ * BINARY_MATRIX_ALIGNMENT: row offsets (uint64, rows + 1), column indices
+ * (int32, nnz) and one array of nnz components per value part, e.g.
+ * numerators and denominators of rational numbers.
+ */
+struct Binary_matrix_header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t value_kind;
+    std::uint32_t component_size;
+    std::int64_t rows;
+    std::int64_t columns;
+    std::uint64_t nnz;
+    std::uint64_t reserved[2];
+};
+
+static_assert(sizeof(Binary_matrix_header) == BINARY_MATRIX_ALIGNMENT, "header must fill one aligned block");
+
+/**
+ * @brief Magic bytes of the binary format
+ */
+const char BINARY_MATRIX_MAGIC[8] = {'M', 'A', 'T', 'R', 'X', 'B', 'I', 'N'};
+
+/**
+ * @brief How values of T are split into component arrays, arithmetic types are stored as they are
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Binary_value_traits {
+    static_assert(std::is_arithmetic_v<T>, "type has no binary representation");
+    using Component = T;
+    static const int components = 1;
+    static const std::uint32_t kind = std::is_floating_point_v<T> ? 2 : 1;
+
+    static Component component(const T& value, int) {
+        return value;
+    }
+
+    static T make(const Component* const* arrays, std::size_t k) {
+        return arrays[0][k];
+    }
+};
+
+/**
+ * @brief Rational numbers are stored as arrays of numerators and denominators
+ *
+ * @tparam U
+ */
+template<typename U>
+struct Binary_value_traits<Rational_number<U>> {
+    using Component = U;
+    static const int components = 2;
+    static const std::uint32_t kind = 3;
+
+    static Component component(const Rational_number<U>& value, int part) {
+        return part == 0 ? value.numerator() : value.denominator();
+    }
+
+    static Rational_number<U> make(const Component* const* arrays, std::size_t k) {
+        return Rational_number<U>(arrays[0][k], arrays[1][k]);
+    }
+};
+
+/**
+ * @brief Round offset up to the alignment of the format
+ *
+ * @param offset offset
+ * @return std::size_t
+ */
+inline std::size_t binary_align(std::size_t offset) {
+    return (offset + BINARY_MATRIX_ALIGNMENT - 1) / BINARY_MATRIX_ALIGNMENT * BINARY_MATRIX_ALIGNMENT;
+}
+
+/**
+ * @brief Write matrix in the binary format
+ *
+ * Index arrays are written directly, value components are gathered into
+ * large buffers, so the file is written sequentially in big blocks.
+ *
+ * @param filename filename
+ * @param dimentions dimentions
+ * @param storage CSR storage
+ */
+template<typename T>
+void write_binary_matrix(const std::string& filename, std::tuple<int, int> dimentions,
+                         const Compressed_storage<T>& storage) {
+    using Traits = Binary_value_traits<T>;
+    using Component = typename Traits::Component;
+    static_assert(sizeof(std::size_t) == sizeof(std::uint64_t), "row offsets are written as uint64");
+
+    Binary_matrix_header header{};
+    std::memcpy(header.magic, BINARY_MATRIX_MAGIC, sizeof(header.magic));
+    header.version = BINARY_MATRIX_VERSION;
+    header.byte_order = BINARY_MATRIX_BYTE_ORDER;
+    header.value_kind = Traits::kind;
+    header.component_size = sizeof(Component);
+    header.rows = std::get<0>(dimentions);
+    header.columns = std::get<1>(dimentions);
+    header.nnz = storage.nnz();
+
+    Output_file file(filename);
+    file.write(&header, sizeof(header));
+    file.write(storage.ptr.data(), storage.ptr.size() * sizeof(std::uint64_t));
+    file.pad(BINARY_MATRIX_ALIGNMENT);
+    file.write(storage.idx.data(), storage.nnz() * sizeof(int));
+    file.pad(BINARY_MATRIX_ALIGNMENT);
+
+    for (int part = 0; part < Traits::components; ++part) {
+        if constexpr (std::is_same_v<T, Component>) {
+            file.write(storage.values.data(), storage.nnz() * sizeof(Component));
+        } else {
+            const std::size_t chunk = 1 << 18;
+            std::vector<Component> buffer(std::min(chunk, storage.nnz()));
+            for (std::size_t first = 0; first < storage.nnz(); first += chunk) {
+                std::size_t last = std::min(storage.nnz(), first + chunk);
+                for (std::size_t k = first; k < last; ++k) {
+                    buffer[k - first] = Traits::component(storage.values[k], part);
+                }
+                file.write(buffer.data(), (last - first) * sizeof(Component));
+            }
+        }
+        file.pad(BINARY_MATRIX_ALIGNMENT);
+    }
+}
+
+/**
+ * @brief Read-only view of a matrix in the binary format
+ *
+ * The file is memory-mapped and arrays are used in place, nothing is copied
+ * when the view is opened. Opening checks the sizes of sections and the row
+ * offsets in O(rows); column indices are only checked by validate(), which
+ * to_storage() and binary_to_text() call while they read all of them anyway.
+ *
+ * @tparam T
+ */
+template<typename T>
+class Binary_matrix_view {
+    using Traits = Binary_value_traits<T>;
+    using Component = typename Traits::Component;
+    /**
+     * @brief mapped file
+     */
+    Mapped_file _file;
+    /**
+     * @brief header
+     */
+    Binary_matrix_header _header{};
+    /**
+     * @brief row offsets
+     */
+    const std::size_t* _ptr = nullptr;
+    /**
+     * @brief column indices
+     */
+    const int* _idx = nullptr;
+    /**
+     * @brief value components
+     */
+    const Component* _components[Traits::components] = {};
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param filename filename
+     */
+    explicit Binary_matrix_view(const std::string& filename) : _file(filename) {
+        if (_file.size() < sizeof(Binary_matrix_header)) {
+            throw FileException("Wrong input - not a binary matrix!");
+        }
+        std::memcpy(&_header, _file.data(), sizeof(_header));
+        if (std::memcmp(_header.magic, BINARY_MATRIX_MAGIC, sizeof(_header.magic)) != 0) {
+            throw FileException("Wrong input - not a binary matrix!");
+        }
+        if (_header.version != BINARY_MATRIX_VERSION) {
+            throw FileException("Wrong input - unsupported binary matrix version!");
+        }
+        if (_header.byte_order != BINARY_MATRIX_BYTE_ORDER) {
+            throw FileException("Wrong input - binary matrix has other byte order!");
+        }
+        if (_header.value_kind != Traits::kind || _header.component_size != sizeof(Component)) {
+            throw FileException("Wrong input - binary matrix has other value type!");
+        }
+        if (_header.rows < 0 || _header.columns < 0 || _header.rows > INT32_MAX || _header.columns > INT32_MAX) {
+            throw FileException("Wrong input - expected dimentions!");
+        }
+
+        // sections follow the header in order, sizes are checked against the file before they are multiplied
+        std::size_t offset = sizeof(Binary_matrix_header);
+        auto section = [&](std::uint64_t count, std::size_t size) {
+            std::size_t begin = offset;
+            if (begin > _file.size() || count > (_file.size() - begin) / size) {
+                throw FileException("Wrong input - binary matrix is truncated!");
+            }
+            offset = binary_align(begin + count * size);
+            return begin;
+        };
+        std::size_t ptr_offset = section(_header.rows + 1, sizeof(std::uint64_t));
+        std::size_t idx_offset = section(_header.nnz, sizeof(int));
+        std::size_t component_offsets[Traits::components];
+        for (int part = 0; part < Traits::components; ++part) {
+            component_offsets[part] = section(_header.nnz, sizeof(Component));
+        }
+        if (offset > _file.size()) {
+            throw FileException("Wrong input - binary matrix is truncated!");
+        }
+
+        _ptr = reinterpret_cast<const std::size_t*>(_file.data() + ptr_offset);
+        _idx = reinterpret_cast<const int*>(_file.data() + idx_offset);
+        for (int part = 0; part < Traits::components; ++part) {
+            _components[part] = reinterpret_cast<const Component*>(_file.data() + component_offsets[part]);
+        }
+        if (_ptr[0] != 0 || _ptr[_header.rows] != _header.nnz) {
+            throw FileException("Wrong input - binary matrix is corrupted!");
+        }
+        // rows index the arrays directly, so offsets of a corrupted file must not reach them
+        for (std::int64_t i = 0; i < _header.rows; ++i) {
+            if (_ptr[i] > _ptr[i + 1]) {
+                throw FileException("Wrong input - binary matrix is corrupted!");
+            }
+        }
+    }
+
+    /**
+     * @brief Check that column indices are inside the matrix and increase within rows, reads all of them
+     *
+     */
+    void validate() const {
+        for (std::int64_t i = 0; i < _header.rows; ++i) {
+            for (std::size_t k = _ptr[i]; k < _ptr[i + 1]; ++k) {
+                if (_idx[k] < 0 || _idx[k] >= _header.columns || (k > _ptr[i] && _idx[k - 1] >= _idx[k])) {
+                    throw FileException("Wrong input - binary matrix is corrupted!");
+                }
+            }
+        }
+    }
+
+    std::tuple<int, int> dimentions() const {
+        return {int(_header.rows), int(_header.columns)};
+    }
+
+    std::size_t nnz() const {
+        return _header.nnz;
+    }
+
+    /**
+     * @brief Row offsets, rows + 1 elements
+     *
+     * @return const std::size_t*
+     */
+    const std::size_t* ptr() const {
+        return _ptr;
+    }
+
+    /**
+     * @brief Column indices, sorted inside every row
+     *
+     * @return const int*
+     */
+    const int* idx() const {
+        return _idx;
+    }
+
+    /**
+     * @brief Array of one value component
+     *
+     * @param part component number
+     * @return const Component*
+     */
+    const Component* component(int part) const {
+        return _components[part];
+    }
+
+    /**
+     * @brief Value of k-th nonzero
+     *
+     * @param k position
+     * @return T
+     */
+    T value(std::size_t k) const {
+        return Traits::make(_components, k);
+    }
+
+    /**
+     * @brief Element of matrix, binary search in the row
+     *
+     * Reads only inside row i, so it is safe on a view that was not validated.
+     *
+     * @param i row
+     * @param j column
+     * @return T
+     */
+    T at(int i, int j) const {
+        auto [n, m] = dimentions();
+        if (i < 0 || j < 0 || i >= n || j >= m) {
+            throw MatrixException("Indices of slice are wrong!");
+        }
+        const int* begin = _idx + _ptr[i];
+        const int* end = _idx + _ptr[i + 1];
+        const int* it = std::lower_bound(begin, end, j);
+        if (it == end || *it != j) {
+            return T();
+        }
+        return value(it - _idx);
+    }
+
+    /**
+     * @brief Copy into compressed storage
+     *
+     * @return Compressed_storage<T>
+     */
+    Compressed_storage<T> to_storage() const {
+        validate();
+        Compressed_storage<T> res(_header.rows);
+        std::memcpy(res.ptr.data(), _ptr, res.ptr.size() * sizeof(std::size_t));
+        res.idx.assign(_idx, _idx + nnz());
+        res.values.resize(nnz());
+        for (std::size_t k = 0; k < nnz(); ++k) {
+            res.values[k] = value(k);
+        }
+        return res;
+    }
+};
+
+/**
+ * @brief Convert matrix from text format to binary format
+ *
+ * @param text_filename text file
+ * @param binary_filename binary file
+ * @param eps values with absolute value below eps are dropped
+ */
+template<typename T>
+void text_to_binary(const std::string& text_filename, const std::string& binary_filename, double eps = 0.0001) {
+    auto [dimentions, storage] = load_text_matrix<T>(text_filename, [eps](const T& value) {
+        return double(value) < eps && double(value) > -eps;
+    });
+    write_binary_matrix(binary_filename, dimentions, storage);
+}
+
+/**
+ * @brief Convert matrix from binary format to text format without loading it
+ *
+ * @param binary_filename binary file
+ * @param text_filename text file
+ */
+template<typename T>
+void binary_to_text(const std::string& binary_filename, const std::string& text_filename) {
+    Binary_matrix_view<T> view(binary_filename);
+    view.validate();
+    write_text_matrix<T>(text_filename, view.dimentions(), view.ptr(), view.idx(),
+                         [&view](std::size_t k) { return view.value(k); });
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef MATRIX_BUILDER_H
+#define MATRIX_BUILDER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+#include "Parallel_kernels.h"
+#include "Triplet_assembly.h"
+#include "../Exceptions/Exceptions.h"
+
+template<typename T>
+class Matrix;
+
+/**
+ * @brief Assembles a matrix from (i, j, value) triplets
+ *
+ * Triplets are appended to flat buffers, one per slot, so several threads can
+ * fill the builder without locking as long as each uses its own slot. build()
+ * sums duplicates, drops zeros and creates storage in one pass.
+ *
+ * @tparam T
+ */
+template<typename T>
+class Matrix_builder {
+    /**
+     * @brief matrix dimentions
+     */
+    std::tuple<int, int> _dimentions;
+    /**
+     * @brief epsilon
+     */
+    double _eps;
+    /**
+     * @brief triplets of every slot
+     */
+    Triplet_parts<T> _parts;
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param n first dimention
+     * @param m second dimention
+     * @param slots number of slots, one per filling thread
+     * @param eps epsilon
+     */
+    Matrix_builder(int n, int m, int slots = 1, double eps = 0.0001) :
+                   _dimentions(n, m), _eps(eps), _parts(std::max(1, slots)) {}
+
+    /**
+     * @brief Number of slots
+     *
+     * @return int
+     */
+    int slots() const {
+        return _parts.size();
+    }
+
+    /**
+     * @brief Reserve place in slot
+     *
+     * @param slot slot
+     * @param size number of triplets
+     */
+    void reserve(int slot, std::size_t size) {
+        _parts[slot].reserve(size);
+    }
+
+    /**
+     * @brief Add value to element (i, j) through slot
+     *
+     * @param slot slot, owned by the calling thread
+     * @param i first index
+     * @param j second index
+     * @param value value
+     */
+    void add(int slot, int i, int j, const T& value) {
+        auto [n, m] = _dimentions;
+        if (i < 0 || j < 0 || i >= n || j >= m) {
+            throw MatrixException("Indices of slice are wrong!");
+        }
+        _parts[slot].push_back({i, j, value});
+    }
+
+    /**
+     * @brief Add value to element (i, j) through the first slot
+     *
+     * @param i first index
+     * @param j second index
+     * @param value value
+     */
+    void add(int i, int j, const T& value) {
+        add(0, i, j, value);
+    }
+
+    /**
+     * @brief Number of added triplets
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const auto& part : _parts) {
+            total += part.size();
+        }
+        return total;
+    }
+
+    /**
+     * @brief Create matrix, the builder is emptied
+     *
+     * @param threads number of threads
+     * @return Matrix<T>
+     */
+    Matrix<T> build(int threads = matrix_thread_count()) {
+        double eps = _eps;
+        auto is_zero = [eps](const T& value) { return double(value) < eps && double(value) > -eps; };
+        auto storage = triplets_to_storage(_parts, std::get<0>(_dimentions), is_zero, Sum_duplicates{}, threads);
+        return Matrix<T>(_dimentions, std::move(storage), _eps);
+    }
+};
+
+#endif
@@ -0,0 +1,614 @@
+#ifndef MATRIX_EXPRESSION_H
+#define MATRIX_EXPRESSION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Parallel_kernels.h"
+#include "Spgemm.h"
+#include "../Exceptions/Exceptions.h"
+
+template<typename T>
+class Matrix;
+
+/**
+ * @brief Base of lazy matrix expressions
+ *
+ * An expression knows its dimentions and gives, for every row, a cursor over
+ * its nonzeros in column order. Assigning an expression to a Matrix walks these
+ * cursors once per row and writes the result straight into the destination.
+ */
+struct Matrix_expression_base {};
+
+/**
+ * @brief Cursor over nonzeros of one row of compressed storage
+ *
+ * @tparam T
+ */
+template<typename T>
+class Storage_cursor {
+    /**
+     * @brief storage
+     */
+    const Compressed_storage<T>* _storage;
+    /**
+     * @brief current position
+     */
+    std::size_t _k;
+    /**
+     * @brief end of row
+     */
+    std::size_t _end;
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param storage storage
+     * @param r row
+     */
+    Storage_cursor(const Compressed_storage<T>& storage, int r) :
+                   _storage(&storage), _k(storage.ptr[r]), _end(storage.ptr[r + 1]) {}
+
+    bool valid() const {
+        return _k < _end;
+    }
+
+    int column() const {
+        return _storage->idx[_k];
+    }
+
+    T value() const {
+        return _storage->values[_k];
+    }
+
+    void next() {
+        ++_k;
+    }
+};
+
+/**
+ * @brief Leaf of expression, holds a matrix by reference (M = const Matrix<T>&)
+ * or by value for temporaries (M = Matrix<T>)
+ *
+ * @tparam T
+ * @tparam M
+ */
+template<typename T, typename M>
+class Matrix_leaf : public Matrix_expression_base {
+    /**
+     * @brief matrix
+     */
+    M _matrix;
+public:
+    using value_type = T;
+
+    explicit Matrix_leaf(M matrix) : _matrix(std::forward<M>(matrix)) {}
+
+    std::tuple<int, int> dimentions() const {
+        return _matrix.get_dimentions();
+    }
+
+    double eps() const {
+        return _matrix.get_eps();
+    }
+
+    Storage_cursor<T> row(int r) const {
+        return Storage_cursor<T>(_matrix.storage(), r);
+    }
+
+    bool dense() const {
+        return _matrix.is_dense();
+    }
+
+    T at(std::size_t k) const {
+        return _matrix.dense_values()[k];
+    }
+};
+
+/**
+ * @brief Cursor of element-wise binary operation, merges two sorted rows
+ */
+template<typename T, typename L, typename R, typename Operation>
+class Binary_cursor {
+    L _left;
+    R _right;
+    Operation _op;
+public:
+    Binary_cursor(L left, R right, Operation op) : _left(left), _right(right), _op(op) {}
+
+    bool valid() const {
+        return _left.valid() || _right.valid();
+    }
+
+    int column() const {
+        if (!_left.valid()) {
+            return _right.column();
+        }
+        if (!_right.valid()) {
+            return _left.column();
+        }
+        return std::min(_left.column(), _right.column());
+    }
+
+    T value() const {
+        int c = column();
+        bool in_left = _left.valid() && _left.column() == c;
+        bool in_right = _right.valid() && _right.column() == c;
+        return _op(in_left ? _left.value() : T(), in_right ? _right.value() : T());
+    }
+
+    void next() {
+        int c = column();
+        if (_left.valid() && _left.column() == c) {
+            _left.next();
+        }
+        if (_right.valid() && _right.column() == c) {
+            _right.next();
+        }
+    }
+};
+
+/**
+ * @brief Cursor of element-wise unary operation
+ */
+template<typename T, typename E, typename Operation>
+class Unary_cursor {
+    E _cursor;
+    Operation _op;
+public:
+    Unary_cursor(E cursor, Operation op) : _cursor(cursor), _op(op) {}
+
+    bool valid() const {
+        return _cursor.valid();
+    }
+
+    int column() const {
+        return _cursor.column();
+    }
+
+    T value() const {
+        return _op(_cursor.value());
+    }
+
+    void next() {
+        _cursor.next();
+    }
+};
+
+/**
+ * @brief Sum operation
+ */
+struct Plus_op {
+    template<typename T>
+    T operator()(const T& a, const T& b) const {
+        return a + b;
+    }
+};
+
+/**
+ * @brief Difference operation
+ */
+struct Minus_op {
+    template<typename T>
+    T operator()(const T& a, const T& b) const {
+        return a - b;
+    }
+};
+
+/**
+ * @brief Negation operation
+ */
+struct Negate_op {
+    template<typename T>
+    T operator()(const T& a) const {
+        return -a;
+    }
+};
+
+/**
+ * @brief Multiplication by scalar
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Scale_op {
+    T value;
+
+    T operator()(const T& a) const {
+        return a * value;
+    }
+};
+
+/**
+ * @brief Element-wise binary expression
+ */
+template<typename L, typename R, typename Operation>
+class Matrix_binary : public Matrix_expression_base {
+    L _left;
+    R _right;
+    Operation _op;
+public:
+    using value_type = typename L::value_type;
+
+    Matrix_binary(L left, R right, Operation op = Operation{}) :
+                  _left(std::move(left)), _right(std::move(right)), _op(op) {
+        if (_left.dimentions() != _right.dimentions()) {
+            throw MatrixException("Dimentions of matrices are not equal!");
+        }
+    }
+
+    std::tuple<int, int> dimentions() const {
+        return _left.dimentions();
+    }
+
+    double eps() const {
+        return _left.eps();
+    }
+
+    auto row(int r) const {
+        auto left = _left.row(r);
+        auto right = _right.row(r);
+        return Binary_cursor<value_type, decltype(left), decltype(right), Operation>(left, right, _op);
+    }
+
+    bool dense() const {
+        return _left.dense() && _right.dense();
+    }
+
+    value_type at(std::size_t k) const {
+        return _op(_left.at(k), _right.at(k));
+    }
+};
+
+/**
+ * @brief Element-wise unary expression
+ */
+template<typename E, typename Operation>
+class Matrix_unary : public Matrix_expression_base {
+    E _expression;
+    Operation _op;
+public:
+    using value_type = typename E::value_type;
+
+    Matrix_unary(E expression, Operation op) : _expression(std::move(expression)), _op(op) {}
+
+    std::tuple<int, int> dimentions() const {
+        return _expression.dimentions();
+    }
+
+    double eps() const {
+        return _expression.eps();
+    }
+
+    auto row(int r) const {
+        auto cursor = _expression.row(r);
+        return Unary_cursor<value_type, decltype(cursor), Operation>(cursor, _op);
+    }
+
+    bool dense() const {
+        return _expression.dense();
+    }
+
+    value_type at(std::size_t k) const {
+        return _op(_expression.at(k));
+    }
+};
+
+/**
+ * @brief Write nonzeros of expression into compressed storage in one pass
+ *
+ * @param expression expression
+ * @return Compressed_storage
+ */
+template<typename E>
+Compressed_storage<typename E::value_type> evaluate(const E& expression) {
+    using T = typename E::value_type;
+    auto [n, m] = expression.dimentions();
+    double eps = expression.eps();
+    Compressed_storage<T> res(n);
+    for (int r = 0; r < n; ++r) {
+        for (auto cursor = expression.row(r); cursor.valid(); cursor.next()) {
+            T value = cursor.value();
+            if (!(double(value) < eps && double(value) > -eps)) {
+                res.push_back(cursor.column(), std::move(value));
+            }
+        }
+        res.ptr[r + 1] = res.nnz();
+    }
+    return res;
+}
+
+/**
+ * @brief Write expression over dense operands into row-major values in one pass
+ *
+ * @param expression expression with dense() == true
+ * @return std::vector
+ */
+template<typename E>
+std::vector<typename E::value_type> evaluate_dense(const E& expression) {
+    auto [n, m] = expression.dimentions();
+    std::vector<typename E::value_type> res(std::size_t(n) * m);
+    for (std::size_t k = 0; k < res.size(); ++k) {
+        res[k] = expression.at(k);
+    }
+    return res;
+}
+
+/**
+ * @brief Transposed expression
+ *
+ * Rows of the result are columns of the operand, so the operand is evaluated
+ * and reordered once (counting sort) when the node is built.
+ */
+template<typename E>
+class Matrix_transpose : public Matrix_expression_base {
+    using T = typename E::value_type;
+    Compressed_storage<T> _storage;
+    std::tuple<int, int> _dimentions;
+    double _eps;
+public:
+    using value_type = T;
+
+    explicit Matrix_transpose(const E& expression) :
+                              _storage(evaluate(expression).transposed(std::get<1>(expression.dimentions()))),
+                              _eps(expression.eps()) {
+        auto [n, m] = expression.dimentions();
+        _dimentions = {m, n};
+    }
+
+    std::tuple<int, int> dimentions() const {
+        return _dimentions;
+    }
+
+    double eps() const {
+        return _eps;
+    }
+
+    Storage_cursor<T> row(int r) const {
+        return Storage_cursor<T>(_storage, r);
+    }
+
+    bool dense() const {
+        return false;
+    }
+
+    T at(std::size_t) const {
+        return T();
+    }
+};
+
+/**
+ * @brief Is X a matrix or a matrix expression
+ */
+template<typename X>
+struct is_matrix_operand : std::is_base_of<Matrix_expression_base, X> {};
+
+template<typename T>
+struct is_matrix_operand<Matrix<T>> : std::true_type {};
+
+template<typename X>
+constexpr bool is_matrix_operand_v = is_matrix_operand<std::decay_t<X>>::value;
+
+template<typename X>
+constexpr bool is_matrix_expression_v = std::is_base_of_v<Matrix_expression_base, std::decay_t<X>>;
+
+/**
+ * @brief Wrap lvalue matrix into leaf holding a reference
+ */
+template<typename T>
+Matrix_leaf<T, const Matrix<T>&> as_expression(const Matrix<T>& matrix) {
+    return Matrix_leaf<T, const Matrix<T>&>(matrix);
+}
+
+/**
+ * @brief Wrap temporary matrix into leaf owning it
+ */
+template<typename T>
+Matrix_leaf<T, Matrix<T>> as_expression(Matrix<T>&& matrix) {
+    return Matrix_leaf<T, Matrix<T>>(std::move(matrix));
+}
+
+/**
+ * @brief Expressions are passed as they are
+ */
+template<typename E, typename = std::enable_if_t<is_matrix_expression_v<E>>>
+std::decay_t<E> as_expression(E&& expression) {
+    return std::forward<E>(expression);
+}
+
+template<typename X>
+using expression_t = decltype(as_expression(std::declval<X>()));
+
+template<typename X>
+using operand_value_t = typename expression_t<X>::value_type;
+
+/**
+ * @brief Lazy + operator
+ *
+ * @param lhs left operand
+ * @param rhs right operand
+ * @return Matrix_binary
+ */
+template<typename L, typename R, typename = std::enable_if_t<is_matrix_operand_v<L> && is_matrix_operand_v<R>>>
+auto operator+(L&& lhs, R&& rhs) {
+    return Matrix_binary<expression_t<L>, expression_t<R>, Plus_op>(as_expression(std::forward<L>(lhs)),
+                                                                    as_expression(std::forward<R>(rhs)));
+}
+
+/**
+ * @brief Lazy - operator
+ *
+ * @param lhs left operand
+ * @param rhs right operand
+ * @return Matrix_binary
+ */
+template<typename L, typename R, typename = std::enable_if_t<is_matrix_operand_v<L> && is_matrix_operand_v<R>>>
+auto operator-(L&& lhs, R&& rhs) {
+    return Matrix_binary<expression_t<L>, expression_t<R>, Minus_op>(as_expression(std::forward<L>(lhs)),
+                                                                     as_expression(std::forward<R>(rhs)));
+}
+
+/**
+ * @brief Lazy operand * value operator
+ *
+ * @param lhs operand
+ * @param value value
+ * @return Matrix_unary
+ */
+template<typename X, typename = std::enable_if_t<is_matrix_operand_v<X>>>
+auto operator*(X&& lhs, const operand_value_t<X>& value) {
+    using T = operand_value_t<X>;
+    return Matrix_unary<expression_t<X>, Scale_op<T>>(as_expression(std::forward<X>(lhs)), Scale_op<T>{value});
+}
+
+/**
+ * @brief Lazy value * operand operator
+ *
+ * @param value value
+ * @param rhs operand
+ * @return Matrix_unary
+ */
+template<typename X, typename = std::enable_if_t<is_matrix_operand_v<X>>>
+auto operator*(const operand_value_t<X>& value, X&& rhs) {
+    return std::forward<X>(rhs) * value;
+}
+
+/**
+ * @brief Lazy unary - operator
+ *
+ * @param operand operand
+ * @return Matrix_unary
+ */
+template<typename X, typename = std::enable_if_t<is_matrix_operand_v<X>>>
+auto operator-(X&& operand) {
+    return Matrix_unary<expression_t<X>, Negate_op>(as_expression(std::forward<X>(operand)), Negate_op{});
+}
+
+/**
+ * @brief Transpose of expression, Matrix has its own member that keeps dense format
+ *
+ * @param expression expression
+ * @return Matrix_transpose
+ */
+template<typename E, typename = std::enable_if_t<is_matrix_expression_v<E>>>
+auto operator~(const E& expression) {
+    return Matrix_transpose<E>(expression);
+}
+
+/**
+ * @brief Product of expressions, Gustavson's algorithm over row cursors
+ *
+ * Rows of both operands are read through their cursors, so views and lazy sums
+ * are multiplied without being copied first. Threads own ranges of rows split by
+ * nonzeros of the left operand and their rows are joined in order.
+ *
+ * @param lhs left expression
+ * @param rhs right expression
+ * @param threads number of threads
+ * @return Compressed_storage
+ */
+template<typename L, typename R>
+Compressed_storage<typename L::value_type> expression_product(const L& lhs, const R& rhs, int threads) {
+    using T = typename L::value_type;
+    int n = std::get<0>(lhs.dimentions());
+    auto [k, m] = rhs.dimentions();
+    double eps = lhs.eps();
+    auto is_zero = [eps](const T& value) { return double(value) < eps && double(value) > -eps; };
+    // the first cursors flush pending writes of the matrices, threads only read them
+    if (k > 0) {
+        rhs.row(0);
+    }
+    std::vector<std::size_t> work(n, 0);
+    std::size_t total = 0;
+    for (int r = 0; r < n; ++r) {
+        for (auto cursor = lhs.row(r); cursor.valid(); cursor.next()) {
+            ++work[r];
+        }
+        total += work[r];
+    }
+    std::vector<int> bounds = partition_rows(work, useful_threads(total, threads));
+    std::vector<Compressed_storage<T>> parts(bounds.size() - 1);
+    parallel_ranges(bounds, [&](int t, int first, int last) {
+        Sparse_accumulator<T> accumulator(m);
+        Compressed_storage<T>& part = parts[t];
+        part = Compressed_storage<T>(last - first);
+        for (int r = first; r < last; ++r) {
+            accumulator.reset();
+            for (auto a = lhs.row(r); a.valid(); a.next()) {
+                T value = a.value();
+                for (auto b = rhs.row(a.column()); b.valid(); b.next()) {
+                    accumulator.add(b.column(), value * b.value());
+                }
+            }
+            std::size_t begin = part.nnz();
+            part.idx.resize(begin + accumulator.size());
+            part.values.resize(begin + accumulator.size());
+            std::size_t end = begin + accumulator.gather(part.idx.data() + begin, part.values.data() + begin, is_zero);
+            part.idx.resize(end);
+            part.values.resize(end);
+            part.ptr[r - first + 1] = end;
+        }
+    });
+
+    Compressed_storage<T> res(n);
+    for (std::size_t t = 0; t < parts.size(); ++t) {
+        std::size_t offset = res.nnz();
+        res.idx.insert(res.idx.end(), parts[t].idx.begin(), parts[t].idx.end());
+        res.values.insert(res.values.end(), std::make_move_iterator(parts[t].values.begin()),
+                          std::make_move_iterator(parts[t].values.end()));
+        for (int r = bounds[t]; r < bounds[t + 1]; ++r) {
+            res.ptr[r + 1] = offset + parts[t].ptr[r - bounds[t] + 1];
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief * operator for expressions and views, Matrix * Matrix is a member of Matrix
+ *
+ * @param lhs left operand
+ * @param rhs right operand
+ * @return Matrix
+ */
+template<typename L, typename R, typename = std::enable_if_t<is_matrix_operand_v<L> && is_matrix_operand_v<R> &&
+                                                             (is_matrix_expression_v<L> || is_matrix_expression_v<R>)>>
+auto operator*(const L& lhs, const R& rhs) {
+    using T = operand_value_t<const L&>;
+    auto left = as_expression(lhs);
+    auto right = as_expression(rhs);
+    auto [n, k] = left.dimentions();
+    auto [rows, m] = right.dimentions();
+    if (k != rows) {
+        throw MatrixException("Dimentions are not compatible!");
+    }
+    if (left.dense() && right.dense()) {
+        return Matrix<T>(lhs) * Matrix<T>(rhs);
+    }
+    return Matrix<T>(std::tuple<int, int>{n, m}, expression_product(left, right, matrix_thread_count()), left.eps());
+}
+
+/**
+ * @brief == operator for expressions
+ */
+template<typename L, typename R, typename = std::enable_if_t<is_matrix_operand_v<L> && is_matrix_operand_v<R> &&
+                                                             (is_matrix_expression_v<L> || is_matrix_expression_v<R>)>>
+bool operator==(const L& lhs, const R& rhs) {
+    using T = operand_value_t<const L&>;
+    return Matrix<T>(lhs) == Matrix<T>(rhs);
+}
+
+/**
+ * @brief != operator for expressions
+ */
+template<typename L, typename R, typename = std::enable_if_t<is_matrix_operand_v<L> && is_matrix_operand_v<R> &&
+                                                             (is_matrix_expression_v<L> || is_matrix_expression_v<R>)>>
+bool operator!=(const L& lhs, const R& rhs) {
+    return !(lhs == rhs);
+}
+
+#endif
@@ -0,0 +1,434 @@
+#ifndef MATRIX_LOADER_H
+#define MATRIX_LOADER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <exception>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Mapped_file.h"
+#include "Parallel_kernels.h"
+#include "Triplet_assembly.h"
+#include "../Exceptions/Exceptions.h"
+#include "../Rational_number/Rational_number.h"
+
+/**
+ * @brief Is character a separator inside a line
+ *
+ * @param c character
+ * @return true
+ * @return false
+ */
+inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * @brief Skip separators
+ *
+ * @param p position
+ * @param end end of line
+ * @return const char* first non-separator or end
+ */
+inline const char* skip_blanks(const char* p, const char* end) {
+    while (p != end && is_blank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * @brief End of word starting at p
+ *
+ * @param p position
+ * @param end end of line
+ * @return const char*
+ */
+inline const char* word_end(const char* p, const char* end) {
+    while (p != end && !is_blank(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+/**
+ * @brief Parse whole word as int
+ *
+ * @param first begin of word
+ * @param last end of word
+ * @param value result
+ * @return true if the whole word is an int
+ */
+inline bool parse_int(const char* first, const char* last, int& value) {
+    if (first != last && *first == '+') {
+        ++first;
+    }
+    auto [ptr, error] = std::from_chars(first, last, value);
+    return error == std::errc() && ptr == last && first != last;
+}
+
+/**
+ * @brief Parser of matrix values from the text format, the value is the rest of a line
+ *
+ * Arithmetic types are read with std::from_chars, other types are constructed
+ * from the words of the value as before.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Value_parser {
+    static T parse(const char* first, const char* last) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            first = skip_blanks(first, last);
+            const char* end = word_end(first, last);
+            T value{0};
+            if (first == last) {
+                return value;
+            }
+            auto [ptr, error] = std::from_chars(first, end, value);
+            if (error != std::errc() || ptr != end || skip_blanks(end, last) != last) {
+                throw FileException("Wrong input - expected value!");
+            }
+            return value;
+        } else {
+            std::string num;
+            for (first = skip_blanks(first, last); first != last; first = skip_blanks(first, last)) {
+                const char* end = word_end(first, last);
+                num += ' ';
+                num.append(first, end);
+                first = end;
+            }
+            return T{num.c_str()};
+        }
+    }
+};
+
+/**
+ * @brief Parser of rational numbers without temporary strings, accepts what Rational_number(const char*) does
+ *
+ * @tparam U
+ */
+template<typename U>
+struct Value_parser<Rational_number<U>> {
+    static Rational_number<U> parse(const char* first, const char* last) {
+        U numerator = 0;
+        bool is_negative = false;
+        const char* p = first;
+        for (; p != last && *p != '/'; ++p) {
+            if (*p == '<' || *p == '>' || is_blank(*p)) {
+                continue;
+            }
+            if (*p == '-') {
+                is_negative = true;
+            } else if (*p < '0' || *p > '9') {
+                throw RationalNumberException("Not a rational number!");
+            } else {
+                numerator = numerator * 10 + (*p - '0');
+            }
+        }
+        if (is_negative) {
+            numerator *= -1;
+        }
+        if (p == last) {
+            return Rational_number<U>(numerator, 1);
+        }
+
+        U denominator = 0;
+        for (++p; p != last; ++p) {
+            if (*p == '>' || is_blank(*p)) {
+                continue;
+            }
+            if (*p < '0' || *p > '9') {
+                throw RationalNumberException("Not a rational number!");
+            }
+            denominator = denominator * 10 + (*p - '0');
+        }
+        return Rational_number<U>(numerator, denominator);
+    }
+};
+
+/**
+ * @brief Parse lines of elements in [first, last)
+ *
+ * @param first begin of a line
+ * @param last end of text
+ * @param n first dimention
+ * @param m second dimention
+ * @param triplets output, elements in file order
+ */
+template<typename T>
+void parse_entries(const char* first, const char* last, int n, int m, std::vector<Matrix_triplet<T>>& triplets) {
+    while (first != last) {
+        const char* line_end = std::find(first, last, '\n');
+        const char* p = skip_blanks(first, line_end);
+        first = line_end == last ? last : line_end + 1;
+        if (p == line_end || *p == '#') {
+            continue;
+        }
+
+        int i, j;
+        const char* end = word_end(p, line_end);
+        if (!parse_int(p, end, i)) {
+            throw FileException("Wrong input - expected index!");
+        }
+        p = skip_blanks(end, line_end);
+        end = word_end(p, line_end);
+        if (!parse_int(p, end, j)) {
+            throw FileException("Wrong input - expected index!");
+        }
+        T value = Value_parser<T>::parse(end, line_end);
+
+        if (i < 0 || i >= n || j < 0 || j >= m) {
+            throw FileException("Wrong input - indices are out of range!");
+        }
+        triplets.push_back({i, j, std::move(value)});
+    }
+}
+
+/**
+ * @brief Parse header "matrix rational n m" skipping comments
+ *
+ * @param p position, moved to the line after header
+ * @param last end of text
+ * @param dimentions output dimentions
+ * @return true if header was found
+ */
+inline bool parse_header(const char*& p, const char* last, std::tuple<int, int>& dimentions) {
+    while (p != last) {
+        const char* line_end = std::find(p, last, '\n');
+        const char* word = skip_blanks(p, line_end);
+        p = line_end == last ? last : line_end + 1;
+        if (word == line_end || *word == '#') {
+            continue;
+        }
+
+        const char* end = word_end(word, line_end);
+        if (std::string(word, end) != "matrix") {
+            throw FileException("Wrong input - expected matrix!");
+        }
+        word = skip_blanks(end, line_end);
+        end = word_end(word, line_end);
+        if (std::string(word, end) != "rational") {
+            throw FileException("Wrong input - expected rational!");
+        }
+        int n, m;
+        word = skip_blanks(end, line_end);
+        end = word_end(word, line_end);
+        bool parsed = parse_int(word, end, n);
+        word = skip_blanks(end, line_end);
+        end = word_end(word, line_end);
+        if (!parsed || !parse_int(word, end, m) || n < 0 || m < 0) {
+            throw FileException("Wrong input - expected dimentions!");
+        }
+        word = skip_blanks(end, line_end);
+        if (word != line_end && *word != '#') {
+            throw FileException("Wrong input - does not expect comment!");
+        }
+        dimentions = {n, m};
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Split text into ranges of whole lines of close size
+ *
+ * @param first begin of text
+ * @param last end of text
+ * @param parts number of ranges
+ * @return std::vector<const char*> boundaries
+ */
+inline std::vector<const char*> split_lines(const char* first, const char* last, int parts) {
+    std::vector<const char*> bounds{first};
+    for (int t = 1; t < parts; ++t) {
+        const char* p = std::max(bounds.back(), first + (last - first) / parts * t);
+        p = std::find(p, last, '\n');
+        bounds.push_back(p == last ? last : p + 1);
+    }
+    bounds.push_back(last);
+    return bounds;
+}
+
+/**
+ * @brief Run parse on chunks of whole lines, one thread per chunk
+ *
+ * An exception of the first failed chunk is rethrown, so errors are reported
+ * as by sequential reading.
+ *
+ * @param first begin of a line
+ * @param last end of text
+ * @param threads number of threads
+ * @param parse parse(t, first, last) parses chunk t
+ * @return int number of chunks
+ */
+template<typename Parse>
+int parallel_lines(const char* first, const char* last, int threads, Parse parse) {
+    int count = useful_threads(last - first, threads);
+    std::vector<const char*> chunks = split_lines(first, last, count);
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<int> bounds(count + 1);
+    for (int t = 0; t <= count; ++t) {
+        bounds[t] = t;
+    }
+    parallel_ranges(bounds, [&](int t, int, int) {
+        try {
+            parse(t, chunks[t], chunks[t + 1]);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    });
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Parse text in chunks of whole lines, one thread per chunk
+ *
+ * Elements of every chunk are appended to parts in text order, errors are
+ * reported as by sequential reading.
+ *
+ * @param first begin of a line
+ * @param last end of text
+ * @param threads number of threads
+ * @param parse parse(first, last, triplets) parses a range of lines
+ * @param parts output
+ */
+template<typename T, typename Parse>
+void parallel_parse(const char* first, const char* last, int threads, Parse parse, Triplet_parts<T>& parts) {
+    std::size_t offset = parts.size();
+    parts.resize(offset + useful_threads(last - first, threads));
+    parallel_lines(first, last, threads, [&](int t, const char* chunk_first, const char* chunk_last) {
+        parts[offset + t].reserve((chunk_last - chunk_first) / 8);
+        parse(chunk_first, chunk_last, parts[offset + t]);
+    });
+}
+
+/**
+ * @brief Load matrix in text format, "matrix rational n m" followed by lines "i j value"
+ *
+ * The file is memory-mapped and split into chunks of lines parsed in parallel,
+ * then elements are bucketed by row and sorted inside rows. Errors are reported
+ * for the first wrong line as by line-by-line reading.
+ *
+ * @param filename filename
+ * @param is_zero predicate for dropped values
+ * @param threads number of threads
+ * @return std::tuple<std::tuple<int, int>, Compressed_storage<T>> dimentions and storage
+ */
+template<typename T, typename Predicate>
+std::tuple<std::tuple<int, int>, Compressed_storage<T>> load_text_matrix(const std::string& filename,
+                                                                          Predicate is_zero,
+                                                                          int threads = matrix_thread_count()) {
+    Mapped_file file(filename);
+    const char* p = file.data();
+    const char* last = file.data() + file.size();
+    std::tuple<int, int> dimentions{0, 0};
+    if (!parse_header(p, last, dimentions)) {
+        return {dimentions, Compressed_storage<T>(0)};
+    }
+    auto [n, m] = dimentions;
+
+    Triplet_parts<T> parts;
+    parallel_parse<T>(p, last, threads, [n = n, m = m](const char* first, const char* last, auto& out) {
+        parse_entries(first, last, n, m, out);
+    }, parts);
+    return {dimentions, triplets_to_storage(parts, n, is_zero, Keep_last{}, threads)};
+}
+
+/**
+ * @brief Formatter of matrix values for the text format
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Value_formatter {
+    static void append(std::string& out, const T& value) {
+        if constexpr (std::is_arithmetic_v<T>) {
+            char buffer[64];
+            auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            out.append(buffer, end);
+        } else {
+            std::ostringstream ss;
+            ss << value;
+            out += ss.str();
+        }
+    }
+};
+
+/**
+ * @brief Formatter of rational numbers, writes <numerator/denominator>
+ *
+ * @tparam U
+ */
+template<typename U>
+struct Value_formatter<Rational_number<U>> {
+    static void append(std::string& out, const Rational_number<U>& value) {
+        char buffer[64];
+        buffer[0] = '<';
+        // 30 characters fit any 64-bit integer
+        char* end = std::to_chars(buffer + 1, buffer + 31, value.numerator()).ptr;
+        *end++ = '/';
+        end = std::to_chars(end, end + 30, value.denominator()).ptr;
+        *end++ = '>';
+        out.append(buffer, end);
+    }
+};
+
+/**
+ * @brief Append int to string
+ *
+ * @param out string
+ * @param value value
+ */
+inline void append_int(std::string& out, int value) {
+    char buffer[16];
+    out.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+/**
+ * @brief Write matrix in text format from compressed rows
+ *
+ * @param filename filename
+ * @param dimentions dimentions
+ * @param ptr row offsets
+ * @param idx column indices
+ * @param value_at value_at(k) is the value of k-th nonzero
+ */
+template<typename T, typename Value_at>
+void write_text_matrix(const std::string& filename, std::tuple<int, int> dimentions, const std::size_t* ptr,
+                       const int* idx, Value_at value_at) {
+    const std::size_t buffer_size = 1 << 20;
+    Output_file file(filename);
+    auto [n, m] = dimentions;
+    std::string out = "matrix rational ";
+    append_int(out, n);
+    out += ' ';
+    append_int(out, m);
+    out += '\n';
+    for (int r = 0; r < n; ++r) {
+        for (std::size_t k = ptr[r]; k < ptr[r + 1]; ++k) {
+            append_int(out, r);
+            out += ' ';
+            append_int(out, idx[k]);
+            out += ' ';
+            Value_formatter<T>::append(out, value_at(k));
+            out += '\n';
+            if (out.size() >= buffer_size) {
+                file.write(out.data(), out.size());
+                out.clear();
+            }
+        }
+    }
+    file.write(out.data(), out.size());
+}
+
+#endif
@@ -0,0 +1,491 @@
+#ifndef MATRIX_MARKET_H
+#define MATRIX_MARKET_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Mapped_file.h"
+#include "Matrix_loader.h"
+#include "Parallel_kernels.h"
+#include "Triplet_assembly.h"
+#include "../Exceptions/Exceptions.h"
+#include "../Rational_number/Rational_number.h"
+
+/**
+ * @brief Banner of Matrix Market files
+ */
+const char MARKET_BANNER[] = "%%MatrixMarket";
+/**
+ * @brief Bytes of file parsed at once, parsed pages are dropped from memory
+ */
+const std::size_t MARKET_WINDOW = std::size_t(1) << 26;
+
+/**
+ * @brief Field of Matrix Market coordinate format
+ *
+ */
+enum class Market_field {
+    REAL,
+    INTEGER,
+    PATTERN,
+};
+
+/**
+ * @brief Symmetry of Matrix Market coordinate format
+ *
+ */
+enum class Market_symmetry {
+    GENERAL,
+    SYMMETRIC,
+    SKEW_SYMMETRIC,
+};
+
+/**
+ * @brief Header and size line of Matrix Market file
+ *
+ */
+struct Market_header {
+    Market_field field = Market_field::REAL;
+    Market_symmetry symmetry = Market_symmetry::GENERAL;
+    int rows = 0;
+    int columns = 0;
+    std::size_t entries = 0;
+};
+
+/**
+ * @brief Parser of Matrix Market values
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Market_value_parser {
+    static T parse(const char* first, const char* last) {
+        static_assert(std::is_arithmetic_v<T>, "type can not be read from Matrix Market file");
+        T value{};
+        auto [ptr, error] = std::from_chars(first, last, value);
+        if (error != std::errc() || ptr != last) {
+            throw FileException("Wrong input - expected value!");
+        }
+        return value;
+    }
+};
+
+/**
+ * @brief Exact parser of decimal numbers into rational numbers
+ *
+ * @tparam U
+ */
+template<typename U>
+struct Market_value_parser<Rational_number<U>> {
+    static void append_digit(U& value, char digit) {
+        if (__builtin_mul_overflow(value, U(10), &value) || __builtin_add_overflow(value, U(digit - '0'), &value)) {
+            throw FileException("Wrong input - value does not fit into rational number!");
+        }
+    }
+
+    static U power_of_ten(int exponent) {
+        U res = 1;
+        for (int k = 0; k < exponent; ++k) {
+            if (__builtin_mul_overflow(res, U(10), &res)) {
+                throw FileException("Wrong input - value does not fit into rational number!");
+            }
+        }
+        return res;
+    }
+
+    static Rational_number<U> parse(const char* first, const char* last) {
+        const char* p = first;
+        bool is_negative = p != last && *p == '-';
+        if (p != last && (*p == '-' || *p == '+')) {
+            ++p;
+        }
+        U mantissa = 0;
+        int exponent = 0;
+        bool has_digits = false;
+        for (; p != last && std::isdigit(*p); ++p, has_digits = true) {
+            append_digit(mantissa, *p);
+        }
+        if (p != last && *p == '.') {
+            for (++p; p != last && std::isdigit(*p); ++p, has_digits = true) {
+                append_digit(mantissa, *p);
+                --exponent;
+            }
+        }
+        if (p != last && (*p == 'e' || *p == 'E')) {
+            int power;
+            ++p;
+            if (p != last && *p == '+') {
+                ++p;
+            }
+            auto [ptr, error] = std::from_chars(p, last, power);
+            if (error != std::errc()) {
+                throw FileException("Wrong input - expected value!");
+            }
+            exponent += power;
+            p = ptr;
+        }
+        if (!has_digits || p != last) {
+            throw FileException("Wrong input - expected value!");
+        }
+        if (is_negative) {
+            mantissa = -mantissa;
+        }
+        if (mantissa == 0) {
+            return Rational_number<U>();
+        }
+        if (exponent >= 0) {
+            U scale = power_of_ten(exponent);
+            if (__builtin_mul_overflow(mantissa, scale, &mantissa)) {
+                throw FileException("Wrong input - value does not fit into rational number!");
+            }
+            return Rational_number<U>(mantissa);
+        }
+        Rational_number<U> value(mantissa, power_of_ten(-exponent));
+        value.make_canonical();
+        return value;
+    }
+};
+
+/**
+ * @brief Lowercase word
+ *
+ * @param first begin
+ * @param last end
+ * @return std::string
+ */
+inline std::string lowercase(const char* first, const char* last) {
+    std::string word(first, last);
+    for (char& c : word) {
+        c = std::tolower(c);
+    }
+    return word;
+}
+
+/**
+ * @brief Does file start with Matrix Market banner
+ *
+ * @param file mapped file
+ * @return true
+ * @return false
+ */
+inline bool is_matrix_market(const Mapped_file& file) {
+    std::size_t length = sizeof(MARKET_BANNER) - 1;
+    return file.size() >= length && std::memcmp(file.data(), MARKET_BANNER, length) == 0;
+}
+
+/**
+ * @brief Parse banner, comments and size line
+ *
+ * @param p position, moved to the first entry line
+ * @param last end of text
+ * @return Market_header
+ */
+inline Market_header parse_market_header(const char*& p, const char* last) {
+    Market_header header;
+    const char* line_end = std::find(p, last, '\n');
+    std::vector<std::string> words;
+    for (const char* word = skip_blanks(p, line_end); word != line_end; word = skip_blanks(word, line_end)) {
+        const char* end = word_end(word, line_end);
+        words.push_back(lowercase(word, end));
+        word = end;
+    }
+    if (words.size() != 5 || words[0] != "%%matrixmarket" || words[1] != "matrix") {
+        throw FileException("Wrong input - expected Matrix Market banner!");
+    }
+    if (words[2] != "coordinate") {
+        throw FileException("Wrong input - only coordinate Matrix Market format is supported!");
+    }
+    if (words[3] == "real" || words[3] == "double") {
+        header.field = Market_field::REAL;
+    } else if (words[3] == "integer") {
+        header.field = Market_field::INTEGER;
+    } else if (words[3] == "pattern") {
+        header.field = Market_field::PATTERN;
+    } else {
+        throw FileException("Wrong input - unsupported Matrix Market field!");
+    }
+    if (words[4] == "general") {
+        header.symmetry = Market_symmetry::GENERAL;
+    } else if (words[4] == "symmetric" || words[4] == "hermitian") {
+        header.symmetry = Market_symmetry::SYMMETRIC;
+    } else if (words[4] == "skew-symmetric") {
+        header.symmetry = Market_symmetry::SKEW_SYMMETRIC;
+    } else {
+        throw FileException("Wrong input - unsupported Matrix Market symmetry!");
+    }
+
+    p = line_end == last ? last : line_end + 1;
+    while (p != last) {
+        line_end = std::find(p, last, '\n');
+        const char* word = skip_blanks(p, line_end);
+        p = line_end == last ? last : line_end + 1;
+        if (word == line_end || *word == '%') {
+            continue;
+        }
+        long long entries = 0;
+        const char* end = word_end(word, line_end);
+        bool parsed = parse_int(word, end, header.rows);
+        word = skip_blanks(end, line_end);
+        end = word_end(word, line_end);
+        parsed = parsed && parse_int(word, end, header.columns);
+        word = skip_blanks(end, line_end);
+        end = word_end(word, line_end);
+        parsed = parsed && std::from_chars(word, end, entries).ptr == end && word != end;
+        if (!parsed || header.rows < 0 || header.columns < 0 || entries < 0 ||
+            skip_blanks(end, line_end) != line_end) {
+            throw FileException("Wrong input - expected dimentions!");
+        }
+        header.entries = entries;
+        return header;
+    }
+    throw FileException("Wrong input - expected dimentions!");
+}
+
+/**
+ * @brief Parse entry lines "i j [value]" with 1-based indices, symmetric entries are mirrored
+ *
+ * Without VALUES value words are only checked to be present and T(1) is emitted.
+ *
+ * @param first begin of a line
+ * @param last end of text
+ * @param header header
+ * @param emit emit(i, j, value) receives 0-based entries
+ * @return std::size_t number of entry lines
+ */
+template<typename T, bool VALUES = true, typename Emit>
+std::size_t parse_market_entries(const char* first, const char* last, const Market_header& header, Emit emit) {
+    std::size_t lines = 0;
+    while (first != last) {
+        const char* line_end = std::find(first, last, '\n');
+        const char* p = skip_blanks(first, line_end);
+        first = line_end == last ? last : line_end + 1;
+        if (p == line_end || *p == '%') {
+            continue;
+        }
+
+        int i, j;
+        const char* end = word_end(p, line_end);
+        bool parsed = parse_int(p, end, i);
+        p = skip_blanks(end, line_end);
+        end = word_end(p, line_end);
+        if (!parsed || !parse_int(p, end, j)) {
+            throw FileException("Wrong input - expected index!");
+        }
+        if (i < 1 || i > header.rows || j < 1 || j > header.columns) {
+            throw FileException("Wrong input - indices are out of range!");
+        }
+        T value = T(1);
+        p = skip_blanks(end, line_end);
+        if (header.field != Market_field::PATTERN) {
+            end = word_end(p, line_end);
+            if constexpr (VALUES) {
+                value = Market_value_parser<T>::parse(p, end);
+            } else if (p == end) {
+                throw FileException("Wrong input - expected value!");
+            }
+            p = skip_blanks(end, line_end);
+        }
+        if (p != line_end) {
+            throw FileException("Wrong input - does not expect comment!");
+        }
+
+        ++lines;
+        if (header.symmetry != Market_symmetry::GENERAL && i != j) {
+            T mirrored = header.symmetry == Market_symmetry::SKEW_SYMMETRIC ? -value : value;
+            emit(j - 1, i - 1, std::move(mirrored));
+        }
+        emit(i - 1, j - 1, std::move(value));
+    }
+    return lines;
+}
+
+/**
+ * @brief Run parse on every window of MARKET_WINDOW bytes and release its pages
+ *
+ * @param file mapped file
+ * @param first begin of the first entry line
+ * @param threads number of threads
+ * @param parse parse(first, last) parses a range of lines
+ */
+template<typename Parse>
+void parse_market_windows(Mapped_file& file, const char* first, int threads, Parse parse) {
+    const char* last = file.data() + file.size();
+    while (first != last) {
+        const char* window_end = last;
+        if (std::size_t(last - first) > MARKET_WINDOW) {
+            window_end = std::find(first + MARKET_WINDOW, last, '\n');
+            window_end = window_end == last ? last : window_end + 1;
+        }
+        parallel_lines(first, window_end, threads,
+                       [&parse](int, const char* chunk_first, const char* chunk_last) { parse(chunk_first, chunk_last); });
+        file.release(first - file.data(), window_end - file.data());
+        first = window_end;
+    }
+}
+
+/**
+ * @brief Load matrix in Matrix Market coordinate format (real, integer or pattern)
+ *
+ * The file is read twice in windows of MARKET_WINDOW bytes, every window in
+ * chunks on several threads, and pages of parsed windows are released. The
+ * first pass checks lines and counts entries of rows, the second one parses
+ * values into their rows, so besides one window only the result with entries
+ * of repeated cells and a counter per row are kept in memory. Errors of values
+ * are reported after errors of indices. Entries of one cell are summed.
+ *
+ * @param filename filename
+ * @param is_zero predicate for dropped values
+ * @param threads number of threads
+ * @return std::tuple<std::tuple<int, int>, Compressed_storage<T>> dimentions and storage
+ */
+template<typename T, typename Predicate>
+std::tuple<std::tuple<int, int>, Compressed_storage<T>> load_matrix_market(const std::string& filename,
+                                                                            Predicate is_zero,
+                                                                            int threads = matrix_thread_count()) {
+    Mapped_file file(filename);
+    const char* p = file.data();
+    Market_header header = parse_market_header(p, file.data() + file.size());
+
+    std::unique_ptr<std::atomic<std::size_t>[]> cursors(new std::atomic<std::size_t>[header.rows]());
+    std::atomic<std::size_t> lines{0};
+    parse_market_windows(file, p, threads, [&header, &cursors, &lines](const char* first, const char* last) {
+        lines += parse_market_entries<T, false>(first, last, header, [&cursors](int i, int, T&&) {
+            cursors[i].fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+    if (lines != header.entries) {
+        throw FileException("Wrong input - wrong number of entries!");
+    }
+
+    Compressed_storage<T> res(header.rows);
+    for (int r = 0; r < header.rows; ++r) {
+        res.ptr[r + 1] = res.ptr[r] + cursors[r].load(std::memory_order_relaxed);
+        cursors[r].store(res.ptr[r], std::memory_order_relaxed);
+    }
+    res.idx.resize(res.ptr[header.rows]);
+    res.values.resize(res.ptr[header.rows]);
+    parse_market_windows(file, p, threads, [&header, &cursors, &res](const char* first, const char* last) {
+        parse_market_entries<T>(first, last, header, [&cursors, &res](int i, int j, T&& value) {
+            std::size_t k = cursors[i].fetch_add(1, std::memory_order_relaxed);
+            res.idx[k] = j;
+            res.values[k] = std::move(value);
+        });
+    });
+    cursors.reset();
+
+    std::vector<std::size_t> counts(header.rows);
+    for (int r = 0; r < header.rows; ++r) {
+        counts[r] = res.ptr[r + 1] - res.ptr[r];
+    }
+    int parts = useful_threads(res.idx.size(), threads);
+    parallel_ranges(partition_rows(counts, parts), [&](int, int first_row, int last_row) {
+        std::vector<std::pair<int, T>> row;
+        combine_rows(res, first_row, last_row, is_zero, Sum_duplicates{}, counts, row);
+    });
+    spgemm_compact(res, counts);
+
+    std::tuple<int, int> dimentions{header.rows, header.columns};
+    return {dimentions, std::move(res)};
+}
+
+/**
+ * @brief Is every value an integer
+ *
+ * @param values values
+ * @return true
+ * @return false
+ */
+template<typename T>
+bool market_integer_values(const std::vector<T>& values) {
+    if constexpr (std::is_integral_v<T>) {
+        return true;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        return false;
+    } else {
+        return std::all_of(values.begin(), values.end(), [](const T& value) { return value.denominator() == 1; });
+    }
+}
+
+/**
+ * @brief Append value in Matrix Market format
+ *
+ * @param out string
+ * @param value value
+ * @param integer write as integer
+ */
+template<typename T>
+void append_market_value(std::string& out, const T& value, bool integer) {
+    char buffer[64];
+    char* end;
+    if constexpr (std::is_arithmetic_v<T>) {
+        end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    } else if (integer) {
+        end = std::to_chars(buffer, buffer + sizeof(buffer), value.numerator()).ptr;
+    } else {
+        end = std::to_chars(buffer, buffer + sizeof(buffer), double(value)).ptr;
+    }
+    out.append(buffer, end);
+}
+
+/**
+ * @brief Write matrix in Matrix Market coordinate format
+ *
+ * Integer values use the integer field, others the real one (rational numbers
+ * with other denominators are rounded to double). A symmetric matrix can be
+ * written as its lower triangle.
+ *
+ * @param filename filename
+ * @param dimentions dimentions
+ * @param storage CSR storage
+ * @param symmetric write lower triangle with symmetric header
+ */
+template<typename T>
+void write_matrix_market(const std::string& filename, std::tuple<int, int> dimentions,
+                         const Compressed_storage<T>& storage, bool symmetric = false) {
+    auto [n, m] = dimentions;
+    if (symmetric && (n != m || !(storage.transposed(m) == storage))) {
+        throw MatrixException("Matrix is not symmetric!");
+    }
+    bool integer = market_integer_values(storage.values);
+    std::size_t entries = 0;
+    for (int r = 0; r < n; ++r) {
+        for (std::size_t k = storage.ptr[r]; k < storage.ptr[r + 1]; ++k) {
+            entries += !symmetric || storage.idx[k] <= r;
+        }
+    }
+
+    const std::size_t buffer_size = 1 << 20;
+    Output_file file(filename);
+    std::string out = std::string(MARKET_BANNER) + " matrix coordinate " + (integer ? "integer " : "real ") +
+                      (symmetric ? "symmetric\n" : "general\n");
+    out += std::to_string(n) + " " + std::to_string(m) + " " + std::to_string(entries) + "\n";
+    for (int r = 0; r < n; ++r) {
+        for (std::size_t k = storage.ptr[r]; k < storage.ptr[r + 1]; ++k) {
+            if (symmetric && storage.idx[k] > r) {
+                break;
+            }
+            append_int(out, r + 1);
+            out += ' ';
+            append_int(out, storage.idx[k] + 1);
+            out += ' ';
+            append_market_value(out, storage.values[k], integer);
+            out += '\n';
+            if (out.size() >= buffer_size) {
+                file.write(out.data(), out.size());
+                out.clear();
+            }
+        }
+    }
+    file.write(out.data(), out.size());
+}
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef MATRIX_VIEW_H
+#define MATRIX_VIEW_H
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include "Compressed_storage.h"
+#include "Matrix_expression.h"
+#include "../Exceptions/Exceptions.h"
+
+template<typename T>
+class Matrix;
+
+/**
+ * @brief Cursor over nonzeros of one row of a view, columns are shifted to the view
+ *
+ * Over compressed storage it walks the range of the row found by binary search,
+ * over dense values it walks the cells of the row and skips zeros.
+ *
+ * @tparam T
+ */
+template<typename T>
+class View_cursor {
+    /**
+     * @brief columns of compressed row, nullptr for dense row
+     */
+    const int* _idx;
+    /**
+     * @brief values of row
+     */
+    const T* _values;
+    /**
+     * @brief current position
+     */
+    std::size_t _k;
+    /**
+     * @brief end of range
+     */
+    std::size_t _end;
+    /**
+     * @brief first column of view
+     */
+    int _offset;
+    /**
+     * @brief epsilon for dense rows
+     */
+    double _eps;
+
+    bool is_zero(const T& value) const {
+        return double(value) < _eps && double(value) > -_eps;
+    }
+
+    void skip_zeros() {
+        while (_idx == nullptr && _k < _end && is_zero(_values[_k])) {
+            ++_k;
+        }
+    }
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param idx columns of compressed row, nullptr for dense row
+     * @param values values of row
+     * @param first first position
+     * @param last end position
+     * @param offset first column of view
+     * @param eps epsilon
+     */
+    View_cursor(const int* idx, const T* values, std::size_t first, std::size_t last, int offset, double eps) :
+                _idx(idx), _values(values), _k(first), _end(last), _offset(offset), _eps(eps) {
+        skip_zeros();
+    }
+
+    bool valid() const {
+        return _k < _end;
+    }
+
+    int column() const {
+        return (_idx == nullptr ? int(_k) : _idx[_k]) - _offset;
+    }
+
+    T value() const {
+        return _values[_k];
+    }
+
+    void next() {
+        ++_k;
+        skip_zeros();
+    }
+};
+
+/**
+ * @brief Read-only rectangular slice of a matrix, rows and columns are slices of width one
+ *
+ * A view keeps only a pointer to the matrix and the corners of the slice and
+ * copies nothing. It is an expression, so it takes part in +, -, * and ~ like
+ * a matrix. Unlike Matrix_proxy it is not registered in the matrix, the matrix
+ * must outlive the view and must not be modified while the view is in use.
+ *
+ * @tparam T
+ */
+template<typename T>
+class Matrix_view : public Matrix_expression_base {
+    /**
+     * @brief viewed matrix
+     */
+    const Matrix<T>* _matrix;
+    /**
+     * @brief first row
+     */
+    int _r1;
+    /**
+     * @brief first column
+     */
+    int _c1;
+    /**
+     * @brief last row
+     */
+    int _r2;
+    /**
+     * @brief last column
+     */
+    int _c2;
+public:
+    using value_type = T;
+
+    /**
+     * @brief Constructor
+     *
+     * @param matrix viewed matrix
+     * @param r1 first row
+     * @param c1 first column
+     * @param r2 last row
+     * @param c2 last column
+     */
+    Matrix_view(const Matrix<T>& matrix, int r1, int c1, int r2, int c2) :
+                _matrix(&matrix), _r1(r1), _c1(c1), _r2(r2), _c2(c2) {
+        auto [n, m] = matrix.get_dimentions();
+        if (r1 < 0 || c1 < 0 || r1 > r2 || c1 > c2 || r2 >= n || c2 >= m) {
+            throw MatrixException("Indices of slice are wrong!");
+        }
+    }
+
+    /**
+     * @brief Get dimentions of view
+     *
+     * @return std::tuple<int, int>
+     */
+    std::tuple<int, int> dimentions() const {
+        return {_r2 - _r1 + 1, _c2 - _c1 + 1};
+    }
+
+    double eps() const {
+        return _matrix->get_eps();
+    }
+
+    /**
+     * @brief Cursor over nonzeros of row r of the view
+     *
+     * @param r row of view
+     * @return View_cursor<T>
+     */
+    View_cursor<T> row(int r) const {
+        int m = std::get<1>(_matrix->get_dimentions());
+        if (_matrix->is_dense()) {
+            const T* values = _matrix->dense_values().data() + std::size_t(_r1 + r) * m;
+            return View_cursor<T>(nullptr, values, _c1, _c2 + 1, _c1, eps());
+        }
+        const auto& storage = _matrix->storage();
+        const int* begin = storage.idx.data() + storage.ptr[_r1 + r];
+        const int* end = storage.idx.data() + storage.ptr[_r1 + r + 1];
+        if (_c1 > 0) {
+            begin = std::lower_bound(begin, end, _c1);
+        }
+        if (_c2 < m - 1) {
+            end = std::lower_bound(begin, end, _c2 + 1);
+        }
+        return View_cursor<T>(storage.idx.data(), storage.values.data(), begin - storage.idx.data(),
+                              end - storage.idx.data(), _c1, eps());
+    }
+
+    bool dense() const {
+        return _matrix->is_dense();
+    }
+
+    /**
+     * @brief Element k of the view in row-major order, the matrix is dense
+     *
+     * @param k position
+     * @return T
+     */
+    T at(std::size_t k) const {
+        std::size_t width = _c2 - _c1 + 1;
+        std::size_t m = std::get<1>(_matrix->get_dimentions());
+        return _matrix->dense_values()[(_r1 + k / width) * m + _c1 + k % width];
+    }
+
+    /**
+     * @brief Read-only access
+     *
+     * @param i row of view
+     * @param j column of view
+     * @return T
+     */
+    T at(int i, int j) const {
+        auto [n, m] = dimentions();
+        if (i < 0 || j < 0 || i >= n || j >= m) {
+            throw MatrixException("Indices of slice are wrong!");
+        }
+        return _matrix->at(_r1 + i, _c1 + j);
+    }
+
+    /**
+     * @brief Number of nonzeros in view
+     *
+     * @return std::size_t
+     */
+    std::size_t nnz() const {
+        std::size_t res = 0;
+        for (int r = 0; r <= _r2 - _r1; ++r) {
+            for (auto cursor = row(r); cursor.valid(); cursor.next()) {
+                ++res;
+            }
+        }
+        return res;
+    }
+};
+
+#endif
@@ -0,0 +1,515 @@
+#ifndef MODULAR_ELIMINATION_H
+#define MODULAR_ELIMINATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Exact_elimination.h"
+#include "Parallel_kernels.h"
+
+/**
+ * @brief Arithmetic modulo an odd 64-bit prime in Montgomery form
+ *
+ * A value a is stored as a * 2^64 mod p, so a product needs two
+ * multiplications and no division.
+ */
+class Montgomery_field {
+    using Wide = unsigned __int128;
+
+    /**
+     * @brief modulus
+     */
+    std::uint64_t _p;
+    /**
+     * @brief -p^-1 mod 2^64
+     */
+    std::uint64_t _inverse;
+    /**
+     * @brief 2^128 mod p
+     */
+    std::uint64_t _r2;
+
+    std::uint64_t reduce(Wide t) const {
+        std::uint64_t m = std::uint64_t(t) * _inverse;
+        std::uint64_t res = (t + Wide(m) * _p) >> 64;
+        return res >= _p ? res - _p : res;
+    }
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param p odd modulus below 2^62
+     */
+    explicit Montgomery_field(std::uint64_t p) : _p(p) {
+        std::uint64_t inverse = p;
+        for (int k = 0; k < 6; ++k) {
+            inverse *= 2 - p * inverse;
+        }
+        _inverse = -inverse;
+        std::uint64_t r = (Wide(1) << 64) % p;
+        _r2 = Wide(r) * r % p;
+    }
+
+    std::uint64_t modulus() const {
+        return _p;
+    }
+
+    /**
+     * @brief Montgomery form of a signed integer
+     */
+    std::uint64_t from(__int128 a) const {
+        __int128 residue = a % __int128(_p);
+        if (residue < 0) {
+            residue += _p;
+        }
+        return reduce(Wide(std::uint64_t(residue)) * _r2);
+    }
+
+    /**
+     * @brief Residue in [0, p) of a value in Montgomery form
+     */
+    std::uint64_t to(std::uint64_t a) const {
+        return reduce(a);
+    }
+
+    std::uint64_t add(std::uint64_t a, std::uint64_t b) const {
+        std::uint64_t res = a + b;
+        return res >= _p ? res - _p : res;
+    }
+
+    std::uint64_t sub(std::uint64_t a, std::uint64_t b) const {
+        return a >= b ? a - b : a + _p - b;
+    }
+
+    std::uint64_t mul(std::uint64_t a, std::uint64_t b) const {
+        return reduce(Wide(a) * b);
+    }
+
+    /**
+     * @brief Inverse of a nonzero value by Fermat's little theorem
+     */
+    std::uint64_t inverse(std::uint64_t a) const {
+        std::uint64_t res = from(1);
+        for (std::uint64_t e = _p - 2; e > 0; e >>= 1) {
+            if (e & 1) {
+                res = mul(res, a);
+            }
+            a = mul(a, a);
+        }
+        return res;
+    }
+};
+
+/**
+ * @brief Deterministic primality test for 64-bit numbers (Miller-Rabin)
+ *
+ * @param n number
+ * @return true
+ * @return false
+ */
+inline bool is_prime(std::uint64_t n) {
+    if (n < 2 || n % 2 == 0) {
+        return n == 2;
+    }
+    Montgomery_field field(n);
+    std::uint64_t d = n - 1;
+    int s = 0;
+    for (; d % 2 == 0; d /= 2) {
+        ++s;
+    }
+    std::uint64_t one = field.from(1);
+    std::uint64_t minus_one = field.from(-1);
+    for (std::uint64_t base : {2, 325, 9375, 28178, 450775, 9780504, 1795265022}) {
+        std::uint64_t x = field.from(base % n);
+        if (x == 0) {
+            continue;
+        }
+        std::uint64_t power = one;
+        for (std::uint64_t e = d; e > 0; e >>= 1) {
+            if (e & 1) {
+                power = field.mul(power, x);
+            }
+            x = field.mul(x, x);
+        }
+        bool composite = power != one && power != minus_one;
+        for (int k = 1; k < s && composite; ++k) {
+            power = field.mul(power, power);
+            composite = power != minus_one;
+        }
+        if (composite) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief k-th prime below 2^62 counting down
+ *
+ * @param k index
+ * @return std::uint64_t
+ */
+inline std::uint64_t modular_prime(int k) {
+    static std::mutex guard;
+    static std::vector<std::uint64_t> primes;
+    std::lock_guard<std::mutex> lock(guard);
+    std::uint64_t candidate = primes.empty() ? (std::uint64_t(1) << 62) - 1 : primes.back() - 2;
+    for (; int(primes.size()) <= k; candidate -= 2) {
+        if (is_prime(candidate)) {
+            primes.push_back(candidate);
+        }
+    }
+    return primes[k];
+}
+
+/**
+ * @brief Image of a rational problem modulo a prime
+ */
+struct Modular_image {
+    /**
+     * @brief prime
+     */
+    std::uint64_t prime = 0;
+    /**
+     * @brief residues of the result
+     */
+    std::vector<std::uint64_t> residues{};
+    /**
+     * @brief prime divides a denominator, the image is skipped
+     */
+    bool unlucky = false;
+    /**
+     * @brief matrix is singular modulo the prime
+     */
+    bool singular = false;
+};
+
+/**
+ * @brief Gaussian elimination of a rational matrix modulo a prime
+ *
+ * Rows are sparse with values in Montgomery form and pivots are chosen as in
+ * Bareiss_elimination. Unlike the fraction-free elimination only rows with a
+ * nonzero in the pivot column are touched.
+ *
+ * @tparam T Rational_number
+ */
+template<typename T>
+class Modular_elimination : public Sparse_pivoting<std::uint64_t> {
+    using Base = Sparse_pivoting<std::uint64_t>;
+
+    /**
+     * @brief field
+     */
+    Montgomery_field _field;
+    /**
+     * @brief product of pivots
+     */
+    std::uint64_t _product;
+    /**
+     * @brief prime divides a denominator
+     */
+    bool _unlucky = false;
+
+    std::uint64_t residue(const T& value) {
+        std::uint64_t denominator = _field.from(value.denominator());
+        if (denominator == 0) {
+            _unlucky = true;
+            return 0;
+        }
+        return _field.mul(_field.from(value.numerator()), _field.inverse(denominator));
+    }
+
+    /**
+     * @brief row -= factor * pivot
+     */
+    void subtract(Row& row, const Row& pivot, std::uint64_t factor) {
+        Row res;
+        res.reserve(row.size() + pivot.size());
+        auto i = row.begin();
+        auto j = pivot.begin();
+        while (i != row.end() || j != pivot.end()) {
+            if (j == pivot.end() || (i != row.end() && i->column < j->column)) {
+                res.push_back(*i++);
+            } else if (i == row.end() || j->column < i->column) {
+                res.push_back({j->column, _field.sub(0, _field.mul(factor, j->value))});
+                ++j;
+            } else {
+                std::uint64_t value = _field.sub(i->value, _field.mul(factor, j->value));
+                if (value != 0) {
+                    res.push_back({i->column, value});
+                }
+                ++i;
+                ++j;
+            }
+        }
+        row = std::move(res);
+    }
+public:
+    /**
+     * @brief Eliminate [a | b] modulo prime
+     *
+     * @param a rows of the matrix
+     * @param columns number of columns of the matrix
+     * @param b right-hand side, empty or of size equal to the number of rows
+     * @param prime prime
+     */
+    Modular_elimination(const Compressed_storage<T>& a, int columns, const std::vector<T>& b, std::uint64_t prime) :
+                        Base(a.major(), columns), _field(prime), _product(_field.from(1)) {
+        for (int r = 0; r < a.major(); ++r) {
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                std::uint64_t value = residue(a.values[k]);
+                if (value != 0) {
+                    _rows[r].push_back({a.idx[k], value});
+                }
+            }
+            if (!b.empty()) {
+                std::uint64_t value = residue(b[r]);
+                if (value != 0) {
+                    _rows[r].push_back({columns, value});
+                }
+            }
+            count(_rows[r], 1);
+        }
+        if (_unlucky) {
+            return;
+        }
+        int c;
+        for (int r = next_pivot(c); r != -1; r = next_pivot(c)) {
+            const Row& pivot = _rows[r];
+            std::uint64_t p = find(pivot, c);
+            std::uint64_t inverse = _field.inverse(p);
+            _product = _field.mul(_product, p);
+            for (int i = 0; i < int(_rows.size()); ++i) {
+                std::uint64_t a_ic = remaining(i) ? find(_rows[i], c) : 0;
+                if (a_ic != 0) {
+                    count(_rows[i], -1);
+                    subtract(_rows[i], pivot, _field.mul(a_ic, inverse));
+                    count(_rows[i], 1);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Image of the determinant of the square matrix
+     *
+     * @return Modular_image
+     */
+    Modular_image determinant() const {
+        Modular_image res{_field.modulus(), {0}, _unlucky, false};
+        if (full_rank()) {
+            std::uint64_t value = _field.to(_product);
+            res.residues[0] = pivot_sign() == 1 || value == 0 ? value : _field.modulus() - value;
+        }
+        return res;
+    }
+
+    /**
+     * @brief Image of the solution by back substitution in reverse order of pivots
+     *
+     * @return Modular_image
+     */
+    Modular_image solution() const {
+        Modular_image res{_field.modulus(), {}, _unlucky, !full_rank()};
+        if (res.unlucky || res.singular) {
+            return res;
+        }
+        std::vector<std::uint64_t> x(_columns, 0);
+        for (auto it = _pivot_rows.rbegin(); it != _pivot_rows.rend(); ++it) {
+            const Row& row = _rows[*it];
+            int c = _pivot_column[*it];
+            std::uint64_t sum = find(row, _columns);
+            std::uint64_t p = 0;
+            for (const Entry& entry : row) {
+                if (entry.column == c) {
+                    p = entry.value;
+                } else if (entry.column < _columns) {
+                    sum = _field.sub(sum, _field.mul(entry.value, x[entry.column]));
+                }
+            }
+            x[c] = _field.mul(sum, _field.inverse(p));
+        }
+        for (std::uint64_t& value : x) {
+            value = _field.to(value);
+        }
+        res.residues = std::move(x);
+        return res;
+    }
+};
+
+/**
+ * @brief Rational number n / d with n = residue mod modulus, |n| and d below sqrt(modulus / 2)
+ *
+ * @param residue residue
+ * @param modulus modulus below 2^126
+ * @param res reconstructed number
+ * @return true if the number exists and fits T
+ */
+template<typename T>
+bool rational_reconstruction(unsigned __int128 residue, unsigned __int128 modulus, T& res) {
+    using I = rational_integer_t<T>;
+    // largest bound with 2 * bound^2 < modulus
+    __int128 bound = 0;
+    for (__int128 step = __int128(1) << 61; step > 0; step /= 2) {
+        if ((bound + step) * (bound + step) * 2 < __int128(modulus)) {
+            bound += step;
+        }
+    }
+    __int128 r0 = modulus, r1 = residue, t0 = 0, t1 = 1;
+    while (r1 > bound) {
+        __int128 q = r0 / r1;
+        __int128 r = r0 - q * r1;
+        __int128 t = t0 - q * t1;
+        r0 = r1;
+        r1 = r;
+        t0 = t1;
+        t1 = t;
+    }
+    __int128 numerator = t1 < 0 ? -r1 : r1;
+    __int128 denominator = t1 < 0 ? -t1 : t1;
+    __int128 a = numerator < 0 ? -numerator : numerator, b = denominator;
+    while (b != 0) {
+        __int128 r = a % b;
+        a = b;
+        b = r;
+    }
+    if (denominator == 0 || denominator > bound || a != 1 ||
+        numerator > std::numeric_limits<I>::max() || numerator < std::numeric_limits<I>::min() ||
+        denominator > std::numeric_limits<I>::max()) {
+        return false;
+    }
+    res = T(I(numerator), I(denominator));
+    return true;
+}
+
+/**
+ * @brief Does rational number agree with residue modulo prime
+ */
+template<typename T>
+bool agrees(const T& value, std::uint64_t residue, std::uint64_t prime) {
+    Montgomery_field field(prime);
+    std::uint64_t numerator = field.from(value.numerator());
+    std::uint64_t denominator = field.from(value.denominator());
+    return denominator != 0 && numerator == field.mul(denominator, field.from(residue));
+}
+
+/**
+ * @brief Most primes whose product fits the 128-bit reconstruction
+ */
+const int MODULAR_PRIMES = 2;
+/**
+ * @brief Most primes tried before giving up
+ */
+const int MODULAR_ATTEMPTS = 16;
+
+/**
+ * @brief Exact rational result from its images modulo several primes (multi-modular method)
+ *
+ * Images are computed in batches, one prime per thread. After every batch the
+ * result is reconstructed by CRT and rational reconstruction from the first one
+ * and then two images and accepted once it agrees with every other image
+ * (early termination by stabilization). At most MODULAR_PRIMES + 1 images are
+ * used, so a batch is capped there and further threads stay idle, as every
+ * elimination is sequential.
+ *
+ * @param image image(prime) gives the residues of the result modulo prime
+ * @param threads number of threads
+ * @return std::optional<std::vector<T>> nothing if the result did not stabilize
+ * within the 128-bit modulus or the matrix is singular modulo a prime
+ */
+template<typename T, typename Image>
+std::optional<std::vector<T>> multimodular(Image image, int threads = matrix_thread_count()) {
+    using Wide = unsigned __int128;
+    std::vector<Modular_image> images;
+    int batch = std::clamp(threads, 2, MODULAR_PRIMES + 1);
+    for (int next = 0; next < MODULAR_ATTEMPTS; next += batch) {
+        std::vector<int> bounds(batch + 1);
+        std::iota(bounds.begin(), bounds.end(), 0);
+        std::vector<Modular_image> fresh(batch);
+        for (int t = 0; t < batch; ++t) {
+            modular_prime(next + t);
+        }
+        parallel_ranges(bounds, [&](int t, int, int) { fresh[t] = image(modular_prime(next + t)); });
+        for (auto& other : fresh) {
+            if (other.singular) {
+                return std::nullopt;
+            }
+            if (!other.unlucky) {
+                images.push_back(std::move(other));
+            }
+        }
+        for (int used = 1; used <= MODULAR_PRIMES && used < int(images.size()); ++used) {
+            Wide modulus = images[0].prime;
+            const Modular_image* second = used == 2 ? &images[1] : nullptr;
+            std::uint64_t inverse = second == nullptr ? 0 :
+                                    Montgomery_field(second->prime).inverse(Montgomery_field(second->prime).from(
+                                        images[0].prime));
+            std::vector<T> res(images[0].residues.size());
+            bool stable = true;
+            for (std::size_t k = 0; k < res.size() && stable; ++k) {
+                Wide residue = images[0].residues[k];
+                if (second != nullptr) {
+                    // Garner: x = r1 + p1 * ((r2 - r1) / p1 mod p2)
+                    Montgomery_field other(second->prime);
+                    std::uint64_t step = other.mul(other.sub(other.from(second->residues[k]),
+                                                             other.from(images[0].residues[k])), inverse);
+                    residue += Wide(images[0].prime) * other.to(step);
+                }
+                stable = rational_reconstruction(residue, second == nullptr ? modulus : modulus * second->prime,
+                                                 res[k]);
+                for (int t = used; t < int(images.size()) && stable; ++t) {
+                    stable = agrees(res[k], images[t].residues[k], images[t].prime);
+                }
+            }
+            if (stable) {
+                return res;
+            }
+        }
+        if (int(images.size()) > MODULAR_PRIMES) {
+            return std::nullopt;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief Exact determinant by the multi-modular method
+ *
+ * @param a rows of square matrix
+ * @param threads number of threads
+ * @return std::optional<T> nothing if the method could not finish
+ */
+template<typename T>
+std::optional<T> modular_determinant(const Compressed_storage<T>& a, int threads = matrix_thread_count()) {
+    auto res = multimodular<T>([&a](std::uint64_t prime) {
+        return Modular_elimination<T>(a, a.major(), {}, prime).determinant();
+    }, threads);
+    if (!res) {
+        return std::nullopt;
+    }
+    return (*res)[0];
+}
+
+/**
+ * @brief Exact solution of a x = b by the multi-modular method
+ *
+ * @param a rows of square matrix
+ * @param b right-hand side
+ * @param threads number of threads
+ * @return std::optional<std::vector<T>> nothing if the method could not finish
+ */
+template<typename T>
+std::optional<std::vector<T>> modular_solve(const Compressed_storage<T>& a, const std::vector<T>& b,
+                                            int threads = matrix_thread_count()) {
+    return multimodular<T>([&a, &b](std::uint64_t prime) {
+        return Modular_elimination<T>(a, a.major(), b, prime).solution();
+    }, threads);
+}
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef PARALLEL_KERNELS_H
+#define PARALLEL_KERNELS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Spgemm.h"
+#include "Thread_pool.h"
+#include "../Exceptions/Exceptions.h"
+
+/**
+ * @brief Global thread count setting, atomic because kernels read it from any thread
+ *
+ * @return std::atomic<int>&
+ */
+inline std::atomic<int>& matrix_thread_setting() {
+    static std::atomic<int> threads{int(std::max(1u, std::thread::hardware_concurrency()))};
+    return threads;
+}
+
+/**
+ * @brief Global thread count used by Matrix kernels
+ *
+ * @return int
+ */
+inline int matrix_thread_count() {
+    return matrix_thread_setting().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set the number of threads used by Matrix kernels
+ *
+ * @param threads number of threads, 1 disables threading
+ */
+inline void set_matrix_threads(int threads) {
+    matrix_thread_setting().store(std::max(1, threads), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Smallest amount of work (multiplications) worth a separate thread
+ */
+const std::size_t PARALLEL_GRAIN = 1 << 16;
+
+/**
+ * @brief Split rows into contiguous ranges with close amounts of work
+ *
+ * Every row costs one unit besides its work, so empty rows are spread as well.
+ * The split depends only on the work, so results do not depend on scheduling.
+ *
+ * @param work work of every row
+ * @param parts number of ranges
+ * @return std::vector<int> boundaries, range t is [bounds[t], bounds[t + 1])
+ */
+inline std::vector<int> partition_rows(const std::vector<std::size_t>& work, int parts) {
+    int rows = work.size();
+    std::vector<std::size_t> prefix(rows + 1, 0);
+    for (int r = 0; r < rows; ++r) {
+        prefix[r + 1] = prefix[r] + work[r] + 1;
+    }
+    std::vector<int> bounds{0};
+    for (int t = 1; t < parts; ++t) {
+        std::size_t target = prefix[rows] / parts * t;
+        int row = std::lower_bound(prefix.begin(), prefix.end(), target) - prefix.begin();
+        bounds.push_back(std::clamp(row, bounds.back(), rows));
+    }
+    bounds.push_back(rows);
+    return bounds;
+}
+
+/**
+ * @brief Run f(part, first, last) for every range on the shared pool, the caller runs range 0
+ *
+ * @param bounds range boundaries
+ * @param f function
+ */
+template<typename Function>
+void parallel_ranges(const std::vector<int>& bounds, Function f) {
+    Thread_pool::shared().run(bounds.size() - 1, [&f, &bounds](int t) { f(t, bounds[t], bounds[t + 1]); });
+}
+
+/**
+ * @brief Number of threads worth using for given total work
+ *
+ * @param total total work
+ * @param threads thread limit
+ * @return int
+ */
+inline int useful_threads(std::size_t total, int threads) {
+    return std::max<std::size_t>(1, std::min<std::size_t>(threads, total / PARALLEL_GRAIN));
+}
+
+/**
+ * @brief Multithreaded sparse matrix product a * b
+ *
+ * Rows are split by multiplication count, every thread owns its accumulator and
+ * writes its rows at offsets from the symbolic phase, so the output is identical
+ * to the sequential one.
+ *
+ * @param a left storage (CSR)
+ * @param b right storage (CSR)
+ * @param columns number of columns of b
+ * @param is_zero predicate for dropped values
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<typename T, typename Predicate>
+Compressed_storage<T> parallel_spgemm(const Compressed_storage<T>& a, const Compressed_storage<T>& b, int columns,
+                                      Predicate is_zero, int threads = matrix_thread_count()) {
+    std::vector<std::size_t> flops = spgemm_flops(a, b);
+    std::size_t total = 0;
+    for (std::size_t f : flops) {
+        total += f;
+    }
+    threads = useful_threads(total, threads);
+    if (threads == 1) {
+        return spgemm(a, b, columns, is_zero);
+    }
+
+    int rows = a.major();
+    std::vector<int> bounds = partition_rows(flops, threads);
+    std::vector<std::size_t> counts(rows);
+    parallel_ranges(bounds, [&](int, int first, int last) {
+        Sparse_accumulator<T> accumulator(columns);
+        spgemm_symbolic(a, b, first, last, accumulator, counts);
+    });
+
+    Compressed_storage<T> res(rows);
+    res.ptr = counts_to_offsets(counts);
+    res.idx.resize(res.ptr[rows]);
+    res.values.resize(res.ptr[rows]);
+
+    std::atomic<bool> dropped{false};
+    parallel_ranges(bounds, [&](int, int first, int last) {
+        Sparse_accumulator<T> accumulator(columns);
+        spgemm_numeric(a, b, first, last, accumulator, res, counts, is_zero);
+        for (int r = first; r < last; ++r) {
+            if (counts[r] != res.ptr[r + 1] - res.ptr[r]) {
+                dropped = true;
+            }
+        }
+    });
+    if (dropped) {
+        spgemm_compact(res, counts);
+    }
+    return res;
+}
+
+/**
+ * @brief Multithreaded sparse matrix by vector product a * x
+ *
+ * Every output element is summed by one thread in column order, so the result
+ * does not depend on the thread count.
+ *
+ * @param a storage (CSR)
+ * @param x vector of size equal to the number of columns
+ * @param threads number of threads
+ * @return std::vector<T>
+ */
+template<typename T>
+std::vector<T> parallel_spmv(const Compressed_storage<T>& a, const std::vector<T>& x,
+                             int threads = matrix_thread_count()) {
+    int rows = a.major();
+    std::vector<T> y(rows, T());
+    threads = useful_threads(a.nnz(), threads);
+    std::vector<std::size_t> work(rows);
+    for (int r = 0; r < rows; ++r) {
+        work[r] = a.ptr[r + 1] - a.ptr[r];
+    }
+    parallel_ranges(partition_rows(work, threads), [&](int, int first, int last) {
+        for (int r = first; r < last; ++r) {
+            T sum{};
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                sum += a.values[k] * x[a.idx[k]];
+            }
+            y[r] = sum;
+        }
+    });
+    return y;
+}
+
+#endif
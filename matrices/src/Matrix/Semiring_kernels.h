@@ -0,0 +1,428 @@
+#ifndef SEMIRING_KERNELS_H
+#define SEMIRING_KERNELS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Elementwise_kernels.h"
+#include "Parallel_kernels.h"
+#include "Spgemm.h"
+
+/**
+ * @brief Arithmetic semiring (+, *), the one of Matrix operators
+ *
+ * A semiring gives zero() (identity of add, annihilator of multiply), add,
+ * multiply and terminal(v): no further add can change v, so a reduction may stop.
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Plus_times {
+    static T zero() { return T(); }
+    static T add(const T& a, const T& b) { return a + b; }
+    static T multiply(const T& a, const T& b) { return a * b; }
+    static bool terminal(const T&) { return false; }
+};
+
+/**
+ * @brief Tropical semiring (min, +): shortest paths, zero is infinity
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Min_plus {
+    static T zero() {
+        return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    }
+    static T add(const T& a, const T& b) { return std::min(a, b); }
+    static T multiply(const T& a, const T& b) { return a + b; }
+    static bool terminal(const T&) { return false; }
+};
+
+/**
+ * @brief Semiring (max, min): widest (bottleneck) paths, zero is minus infinity
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Max_min {
+    static T zero() {
+        return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+                                                    : std::numeric_limits<T>::lowest();
+    }
+    static T add(const T& a, const T& b) { return std::max(a, b); }
+    static T multiply(const T& a, const T& b) { return std::min(a, b); }
+    static bool terminal(const T& value) {
+        return value == (std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                              : std::numeric_limits<T>::max());
+    }
+};
+
+/**
+ * @brief Boolean semiring (or, and) over T: reachability and BFS, nonzero is true
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Or_and {
+    static T zero() { return T(); }
+    static T add(const T& a, const T& b) { return a != T() || b != T() ? T(1) : T(); }
+    static T multiply(const T& a, const T& b) { return a != T() && b != T() ? T(1) : T(); }
+    static bool terminal(const T& value) { return value != T(); }
+};
+
+/**
+ * @brief Accumulator that replaces the old value by the result
+ */
+struct No_accumulator {
+    template<typename T>
+    T operator()(const T&, const T& result) const {
+        return result;
+    }
+};
+
+/**
+ * @brief Accumulator that adds the result to the old value in semiring S, e.g. min for Min_plus
+ *
+ * @tparam S semiring
+ */
+template<typename S>
+struct Semiring_accumulator {
+    template<typename T>
+    T operator()(const T& old, const T& result) const {
+        return S::add(old, result);
+    }
+};
+
+/**
+ * @brief Mask of vector entries written by a kernel
+ *
+ * With no values every entry is written, otherwise entries with a nonzero
+ * value, or with a zero one if complement is set.
+ */
+struct Vector_mask {
+    const std::vector<char>* values = nullptr;
+    bool complement = false;
+
+    bool allows(int i) const {
+        return values == nullptr || ((*values)[i] != 0) != complement;
+    }
+};
+
+/**
+ * @brief Masked w<mask> = accumulate(w, A u) in semiring S (pull)
+ *
+ * Rows are split between threads, entries of u equal to S::zero() are skipped
+ * and a row stops at a terminal value, so a complemented mask of visited
+ * vertices with Or_and is the bottom-up step of BFS.
+ *
+ * @param w output of size equal to the number of rows, entries outside the mask are kept
+ * @param mask rows to write
+ * @param accumulate accumulate(old, result)
+ * @param a storage (CSR)
+ * @param u vector of size equal to the number of columns
+ * @param threads number of threads
+ */
+template<typename S, typename T, typename Accumulator>
+void semiring_mxv(std::vector<T>& w, const Vector_mask& mask, Accumulator accumulate, const Compressed_storage<T>& a,
+                  const std::vector<T>& u, int threads = matrix_thread_count()) {
+    int rows = a.major();
+    std::vector<std::size_t> work(rows, 0);
+    std::size_t total = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (mask.allows(r)) {
+            work[r] = a.ptr[r + 1] - a.ptr[r];
+            total += work[r];
+        }
+    }
+    const T zero = S::zero();
+    parallel_ranges(partition_rows(work, useful_threads(total, threads)), [&](int, int first, int last) {
+        for (int r = first; r < last; ++r) {
+            if (!mask.allows(r)) {
+                continue;
+            }
+            T sum = zero;
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                const T& value = u[a.idx[k]];
+                if (value == zero) {
+                    continue;
+                }
+                sum = S::add(sum, S::multiply(a.values[k], value));
+                if (S::terminal(sum)) {
+                    break;
+                }
+            }
+            w[r] = accumulate(w[r], sum);
+        }
+    });
+}
+
+/**
+ * @brief Masked w<mask> = accumulate(w, u^T A) in semiring S (push)
+ *
+ * Only rows of A at entries of u different from S::zero() are read, so a
+ * small frontier costs its own edges rather than the whole matrix. Scattering
+ * is sequential, semiring_mxv on the transposed storage is the threaded
+ * alternative. w may be u.
+ *
+ * @param w output of size equal to the number of columns, entries outside the mask are kept
+ * @param mask columns to write
+ * @param accumulate accumulate(old, result)
+ * @param u vector of size equal to the number of rows
+ * @param a storage (CSR)
+ * @param columns number of columns
+ */
+template<typename S, typename T, typename Accumulator>
+void semiring_vxm(std::vector<T>& w, const Vector_mask& mask, Accumulator accumulate, const std::vector<T>& u,
+                  const Compressed_storage<T>& a, int columns) {
+    const T zero = S::zero();
+    std::vector<T> res(columns, zero);
+    for (int r = 0; r < a.major(); ++r) {
+        if (u[r] == zero) {
+            continue;
+        }
+        for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+            int c = a.idx[k];
+            if (mask.allows(c)) {
+                res[c] = S::add(res[c], S::multiply(u[r], a.values[k]));
+            }
+        }
+    }
+    for (int c = 0; c < columns; ++c) {
+        if (mask.allows(c)) {
+            w[c] = accumulate(w[c], res[c]);
+        }
+    }
+}
+
+/**
+ * @brief Masked product C<M> = A B by dot products of rows of A and columns of B
+ *
+ * Row i of a is scattered once, then every cell of the mask walks column j of
+ * b, so the cost follows the mask rather than the multiplications of the
+ * product. The result has the pattern of the mask without cells equal to
+ * S::zero().
+ *
+ * @param a left storage (CSR)
+ * @param columns_of_b columns of b (rows of its transposed storage)
+ * @param inner number of columns of a
+ * @param mask pattern of computed cells
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<typename S, typename T, typename M>
+Compressed_storage<T> semiring_masked_dot(const Compressed_storage<T>& a, const Compressed_storage<T>& columns_of_b,
+                                          int inner, const Compressed_storage<M>& mask,
+                                          int threads = matrix_thread_count()) {
+    int rows = a.major();
+    std::vector<std::size_t> work(rows, 0);
+    std::size_t total = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (mask.ptr[r] != mask.ptr[r + 1]) {
+            work[r] = a.ptr[r + 1] - a.ptr[r];
+        }
+        for (std::size_t k = mask.ptr[r]; k < mask.ptr[r + 1]; ++k) {
+            work[r] += columns_of_b.ptr[mask.idx[k] + 1] - columns_of_b.ptr[mask.idx[k]];
+        }
+        total += work[r];
+    }
+    Compressed_storage<T> res(rows);
+    res.ptr = mask.ptr;
+    res.idx = mask.idx;
+    res.values.resize(mask.nnz());
+    std::vector<std::size_t> counts(rows);
+    const T zero = S::zero();
+    std::atomic<bool> dropped{false};
+    parallel_ranges(partition_rows(work, useful_threads(total, threads)), [&](int, int first, int last) {
+        // values of the current row of a by column, valid where marker equals the row
+        std::vector<T> scattered(inner);
+        std::vector<int> marker(inner, -1);
+        for (int r = first; r < last; ++r) {
+            if (mask.ptr[r] == mask.ptr[r + 1]) {
+                counts[r] = 0;
+                continue;
+            }
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                marker[a.idx[k]] = r;
+                scattered[a.idx[k]] = a.values[k];
+            }
+            std::size_t out = res.ptr[r];
+            for (std::size_t k = mask.ptr[r]; k < mask.ptr[r + 1]; ++k) {
+                int c = mask.idx[k];
+                T sum = zero;
+                for (std::size_t t = columns_of_b.ptr[c]; t < columns_of_b.ptr[c + 1] && !S::terminal(sum); ++t) {
+                    int i = columns_of_b.idx[t];
+                    if (marker[i] == r) {
+                        sum = S::add(sum, S::multiply(scattered[i], columns_of_b.values[t]));
+                    }
+                }
+                if (!(sum == zero)) {
+                    res.idx[out] = c;
+                    res.values[out++] = std::move(sum);
+                }
+            }
+            counts[r] = out - res.ptr[r];
+            if (out != res.ptr[r + 1]) {
+                dropped = true;
+            }
+        }
+    });
+    if (dropped) {
+        spgemm_compact(res, counts);
+    }
+    return res;
+}
+
+/**
+ * @brief Masked sparse product C<M> = A B in semiring S
+ *
+ * Gustavson's algorithm as parallel_spgemm with the addition of S. Cells
+ * outside the mask are never accumulated and rows with an empty mask are
+ * skipped. A mask much sparser than the multiplications, e.g. C<L> = L L
+ * counting triangles, is computed by semiring_masked_dot instead. Results
+ * equal to S::zero() are dropped.
+ *
+ * @param a left storage (CSR)
+ * @param b right storage (CSR)
+ * @param columns number of columns of b
+ * @param mask pattern of allowed cells, nullptr for all
+ * @param complement allow cells outside the mask pattern instead
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<typename S, typename T, typename M>
+Compressed_storage<T> semiring_spgemm(const Compressed_storage<T>& a, const Compressed_storage<T>& b, int columns,
+                                      const Compressed_storage<M>* mask, bool complement,
+                                      int threads = matrix_thread_count()) {
+    int rows = a.major();
+    std::vector<std::size_t> flops = spgemm_flops(a, b);
+    std::size_t total = 0;
+    for (int r = 0; r < rows; ++r) {
+        if (mask != nullptr && !complement && mask->ptr[r] == mask->ptr[r + 1]) {
+            flops[r] = 0;
+        }
+        total += flops[r];
+    }
+    if (mask != nullptr && !complement) {
+        // transposing b, scattering rows of a and walking a column of b for every cell of the mask
+        std::vector<std::size_t> column_counts(columns, 0);
+        for (int c : b.idx) {
+            ++column_counts[c];
+        }
+        std::size_t dot = b.nnz();
+        for (int r = 0; r < rows; ++r) {
+            if (mask->ptr[r] != mask->ptr[r + 1]) {
+                dot += a.ptr[r + 1] - a.ptr[r];
+            }
+            for (std::size_t k = mask->ptr[r]; k < mask->ptr[r + 1]; ++k) {
+                dot += column_counts[mask->idx[k]];
+            }
+        }
+        if (dot < total) {
+            return semiring_masked_dot<S>(a, b.transposed(columns), b.major(), *mask, threads);
+        }
+    }
+    std::vector<int> bounds = partition_rows(flops, useful_threads(total, threads));
+    int parts = bounds.size() - 1;
+    std::vector<std::vector<int>> marks(parts);
+
+    // touch(column, product) for every allowed product of row r
+    auto visit_row = [&](int t, int r, auto touch) {
+        if (mask != nullptr && !complement && mask->ptr[r] == mask->ptr[r + 1]) {
+            return;
+        }
+        std::vector<int>& marked = marks[t];
+        if (mask != nullptr) {
+            for (std::size_t k = mask->ptr[r]; k < mask->ptr[r + 1]; ++k) {
+                marked[mask->idx[k]] = r;
+            }
+        }
+        for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+            int c = a.idx[k];
+            for (std::size_t s = b.ptr[c]; s < b.ptr[c + 1]; ++s) {
+                int column = b.idx[s];
+                if (mask == nullptr || (marked[column] == r) != complement) {
+                    touch(column, a.values[k], b.values[s]);
+                }
+            }
+        }
+    };
+
+    std::vector<std::size_t> counts(rows);
+    parallel_ranges(bounds, [&](int t, int first, int last) {
+        marks[t].assign(mask != nullptr ? columns : 0, -1);
+        Sparse_accumulator<T> accumulator(columns);
+        for (int r = first; r < last; ++r) {
+            accumulator.reset();
+            visit_row(t, r, [&](int column, const T&, const T&) { accumulator.touch(column); });
+            counts[r] = accumulator.size();
+        }
+    });
+
+    Compressed_storage<T> res(rows);
+    res.ptr = counts_to_offsets(counts);
+    res.idx.resize(res.ptr[rows]);
+    res.values.resize(res.ptr[rows]);
+
+    const T zero = S::zero();
+    auto add = [](const T& x, const T& y) { return S::add(x, y); };
+    std::atomic<bool> dropped{false};
+    parallel_ranges(bounds, [&](int t, int first, int last) {
+        std::fill(marks[t].begin(), marks[t].end(), -1);
+        Sparse_accumulator<T> accumulator(columns);
+        for (int r = first; r < last; ++r) {
+            accumulator.reset();
+            visit_row(t, r, [&](int column, const T& left, const T& right) {
+                accumulator.add(column, S::multiply(left, right), add);
+            });
+            counts[r] = accumulator.gather(res.idx.data() + res.ptr[r], res.values.data() + res.ptr[r],
+                                           [&zero](const T& value) { return value == zero; });
+            if (counts[r] != res.ptr[r + 1] - res.ptr[r]) {
+                dropped = true;
+            }
+        }
+    });
+    if (dropped) {
+        spgemm_compact(res, counts);
+    }
+    return res;
+}
+
+/**
+ * @brief Element-wise addition in semiring S over the union of patterns
+ *
+ * @param a left storage
+ * @param b right storage of equal shape
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<typename S, typename T>
+Compressed_storage<T> semiring_ewise_add(const Compressed_storage<T>& a, const Compressed_storage<T>& b,
+                                         int threads = matrix_thread_count()) {
+    const T zero = S::zero();
+    return merge_present<true, true, true>(a, b, [](const T* left, const T* right) {
+        return left != nullptr && right != nullptr ? S::add(*left, *right) : left != nullptr ? *left : *right;
+    }, [&zero](const T& value) { return value == zero; }, threads);
+}
+
+/**
+ * @brief Element-wise multiplication in semiring S over the intersection of patterns
+ *
+ * @param a left storage
+ * @param b right storage of equal shape
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<typename S, typename T>
+Compressed_storage<T> semiring_ewise_mult(const Compressed_storage<T>& a, const Compressed_storage<T>& b,
+                                          int threads = matrix_thread_count()) {
+    const T zero = S::zero();
+    return merge_present<false, true, false>(a, b, [](const T* left, const T* right) {
+        return S::multiply(*left, *right);
+    }, [&zero](const T& value) { return value == zero; }, threads);
+}
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef SHARED_BUFFER_H
+#define SHARED_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @brief Copy-on-write value shared through an atomic reference count
+ *
+ * Copies share one value and cost O(1). write() gives a private value, cloning
+ * the shared one first if another buffer still references it, so a copy never
+ * sees changes of the others. Counting is atomic, so buffers sharing a value
+ * may be copied, read and destroyed from different threads. An empty buffer
+ * (default constructed or moved from) reads as V() and allocates on write.
+ *
+ * @tparam V
+ */
+template<typename V>
+class Shared_buffer {
+    /**
+     * @brief Shared value with its reference count
+     */
+    struct Node {
+        std::atomic<std::size_t> references;
+        V value;
+
+        explicit Node(V init) : references(1), value(std::move(init)) {}
+    };
+
+    /**
+     * @brief shared node, nullptr for empty buffer
+     */
+    Node* _node = nullptr;
+
+    void release() {
+        if (_node != nullptr && _node->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete _node;
+        }
+        _node = nullptr;
+    }
+
+    static const V& empty() {
+        static const V value{};
+        return value;
+    }
+public:
+    Shared_buffer() = default;
+
+    /**
+     * @brief Constructor
+     *
+     * @param value initial value
+     */
+    explicit Shared_buffer(V value) : _node(new Node(std::move(value))) {}
+
+    Shared_buffer(const Shared_buffer& other) : _node(other._node) {
+        if (_node != nullptr) {
+            _node->references.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    Shared_buffer(Shared_buffer&& other) noexcept : _node(std::exchange(other._node, nullptr)) {}
+
+    Shared_buffer& operator=(Shared_buffer other) noexcept {
+        std::swap(_node, other._node);
+        return *this;
+    }
+
+    /**
+     * @brief Replace value, reuses the node if it is not shared
+     *
+     * @param value new value
+     * @return Shared_buffer&
+     */
+    Shared_buffer& operator=(V value) {
+        if (unique()) {
+            _node->value = std::move(value);
+        } else {
+            release();
+            _node = new Node(std::move(value));
+        }
+        return *this;
+    }
+
+    ~Shared_buffer() {
+        release();
+    }
+
+    const V& operator*() const {
+        return _node == nullptr ? empty() : _node->value;
+    }
+
+    const V* operator->() const {
+        return &**this;
+    }
+
+    /**
+     * @brief Value for modification, cloned first if it is shared
+     *
+     * @return V&
+     */
+    V& write() {
+        if (_node == nullptr) {
+            _node = new Node(V{});
+        } else if (!unique()) {
+            Node* copy = new Node(_node->value);
+            release();
+            _node = copy;
+        }
+        return _node->value;
+    }
+
+    /**
+     * @brief Is value referenced by this buffer only
+     *
+     * @return true
+     * @return false
+     */
+    bool unique() const {
+        return _node != nullptr && _node->references.load(std::memory_order_acquire) == 1;
+    }
+
+    /**
+     * @brief Is value shared with other
+     *
+     * @param other buffer
+     * @return true
+     * @return false
+     */
+    bool shares(const Shared_buffer& other) const {
+        return _node != nullptr && _node == other._node;
+    }
+};
+
+#endif
@@ -0,0 +1,642 @@
+#ifndef SPARSE_FACTORIZATION_H
+#define SPARSE_FACTORIZATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Dense_kernels.h"
+#include "Sparse_ordering.h"
+#include "../Exceptions/Exceptions.h"
+
+/**
+ * @brief Sparse Cholesky factorization P A P^T = L L^T of a symmetric positive definite matrix
+ *
+ * The symbolic analysis orders the matrix by minimum degree, postorders its
+ * elimination tree and groups columns with equal structure into supernodes.
+ * The numeric factorization is multifrontal: every supernode is a dense front
+ * factored by dense kernels, its Schur complement is added to the front of the
+ * parent. The analysis is kept, so factorize() of a matrix with the same
+ * pattern and every solve() cost only the numeric work.
+ *
+ * Only the pattern and values of the lower triangle after ordering are read,
+ * symmetry of the matrix is not checked.
+ *
+ * @tparam T floating point type
+ */
+template<typename T>
+class Sparse_cholesky {
+    /**
+     * @brief dimention
+     */
+    int _n;
+    /**
+     * @brief number of nonzeros of the analysed matrix
+     */
+    std::size_t _source_nnz;
+    /**
+     * @brief order of elimination, _perm[k] is the row of A eliminated at step k
+     */
+    std::vector<int> _perm;
+    /**
+     * @brief lower triangle of P A P^T by columns, _source holds positions in values of A
+     */
+    std::vector<std::size_t> _lower_ptr;
+    std::vector<int> _lower_idx;
+    std::vector<std::size_t> _source;
+    /**
+     * @brief first column of every supernode, size is the number of supernodes + 1
+     */
+    std::vector<int> _super;
+    /**
+     * @brief rows of every supernode, its own columns first
+     */
+    std::vector<std::size_t> _row_ptr;
+    std::vector<int> _rows;
+    /**
+     * @brief parent of every supernode, -1 for roots
+     */
+    std::vector<int> _super_parent;
+    /**
+     * @brief dense row-major rows x columns block of L of every supernode
+     */
+    std::vector<std::size_t> _value_ptr;
+    std::vector<T> _values;
+
+    int width(int s) const {
+        return _super[s + 1] - _super[s];
+    }
+
+    int height(int s) const {
+        return _row_ptr[s + 1] - _row_ptr[s];
+    }
+
+    /**
+     * @brief Strictly lower rows of P A P^T for order perm
+     */
+    static std::vector<std::vector<int>> lower_rows(const Compressed_storage<T>& a, const std::vector<int>& perm) {
+        std::vector<int> inverse = inverse_permutation(perm);
+        std::vector<std::vector<int>> res(a.major());
+        for (int r = 0; r < a.major(); ++r) {
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                int i = inverse[r];
+                int j = inverse[a.idx[k]];
+                if (j < i) {
+                    res[i].push_back(j);
+                }
+            }
+        }
+        return res;
+    }
+
+    void analyze(const Compressed_storage<T>& a) {
+        _perm = symmetric_ordering(a);
+        std::vector<std::vector<int>> rows = lower_rows(a, _perm);
+        std::vector<int> parent = elimination_tree(rows);
+
+        // nonzeros of column j of L, row k of L is the reach of row k of A in the tree
+        std::vector<int> counts(_n, 1);
+        std::vector<int> mark(_n, -1);
+        std::vector<int> children(_n, 0);
+        for (int k = 0; k < _n; ++k) {
+            mark[k] = k;
+            for (int j : rows[k]) {
+                for (; mark[j] != k; j = parent[j]) {
+                    mark[j] = k;
+                    ++counts[j];
+                }
+            }
+            if (parent[k] != -1) {
+                ++children[parent[k]];
+            }
+        }
+
+        // fundamental supernodes: a chain of single children with nested structures
+        _super.assign(1, 0);
+        for (int j = 1; j < _n; ++j) {
+            if (parent[j - 1] != j || children[j] != 1 || counts[j - 1] != counts[j] + 1) {
+                _super.push_back(j);
+            }
+        }
+        _super.push_back(_n);
+        int supernodes = _super.size() - 1;
+        std::vector<int> super_of(_n);
+        for (int s = 0; s < supernodes; ++s) {
+            std::fill(super_of.begin() + _super[s], super_of.begin() + _super[s + 1], s);
+        }
+        _super_parent.assign(supernodes, -1);
+        for (int s = 0; s < supernodes; ++s) {
+            int p = parent[_super[s + 1] - 1];
+            _super_parent[s] = p == -1 ? -1 : super_of[p];
+        }
+
+        // lower triangle by columns with positions of values in A
+        std::vector<int> inverse = inverse_permutation(_perm);
+        _lower_ptr.assign(_n + 1, 0);
+        for (int r = 0; r < _n; ++r) {
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                if (inverse[r] >= inverse[a.idx[k]]) {
+                    ++_lower_ptr[inverse[a.idx[k]] + 1];
+                }
+            }
+        }
+        std::partial_sum(_lower_ptr.begin(), _lower_ptr.end(), _lower_ptr.begin());
+        _lower_idx.resize(_lower_ptr[_n]);
+        _source.resize(_lower_ptr[_n]);
+        std::vector<std::size_t> next(_lower_ptr.begin(), _lower_ptr.end() - 1);
+        for (int r = 0; r < _n; ++r) {
+            for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+                int i = inverse[r];
+                int j = inverse[a.idx[k]];
+                if (i >= j) {
+                    _lower_idx[next[j]] = i;
+                    _source[next[j]++] = k;
+                }
+            }
+        }
+
+        // rows of a supernode: its columns, rows of A below them and rows of children below them
+        std::vector<std::vector<int>> structure(supernodes);
+        mark.assign(_n, -1);
+        for (int s = 0; s < supernodes; ++s) {
+            int last = _super[s + 1];
+            auto& rows_of = structure[s];
+            for (int j = _super[s]; j < last; ++j) {
+                mark[j] = s;
+                rows_of.push_back(j);
+            }
+            auto add = [&](int i) {
+                if (i >= last && mark[i] != s) {
+                    mark[i] = s;
+                    rows_of.push_back(i);
+                }
+            };
+            for (int j = _super[s]; j < last; ++j) {
+                for (std::size_t k = _lower_ptr[j]; k < _lower_ptr[j + 1]; ++k) {
+                    add(_lower_idx[k]);
+                }
+            }
+            std::sort(rows_of.begin() + width(s), rows_of.end());
+        }
+        // children come before parents, so their structures are complete when merged
+        _row_ptr.assign(1, 0);
+        _rows.clear();
+        for (int s = 0; s < supernodes; ++s) {
+            int p = _super_parent[s];
+            if (p != -1) {
+                auto& target = structure[p];
+                std::vector<int> merged;
+                for (std::size_t k = width(s); k < structure[s].size(); ++k) {
+                    if (structure[s][k] >= _super[p + 1]) {
+                        merged.push_back(structure[s][k]);
+                    }
+                }
+                std::vector<int> below(target.begin() + width(p), target.end());
+                std::vector<int> united;
+                std::set_union(below.begin(), below.end(), merged.begin(), merged.end(), std::back_inserter(united));
+                target.resize(width(p));
+                target.insert(target.end(), united.begin(), united.end());
+            }
+            _rows.insert(_rows.end(), structure[s].begin(), structure[s].end());
+            _row_ptr.push_back(_rows.size());
+            std::vector<int>().swap(structure[s]);
+        }
+        _value_ptr.assign(1, 0);
+        for (int s = 0; s < supernodes; ++s) {
+            _value_ptr.push_back(_value_ptr.back() + std::size_t(height(s)) * width(s));
+        }
+    }
+public:
+    /**
+     * @brief Analyse and factorize
+     *
+     * @param a rows of symmetric positive definite matrix
+     */
+    explicit Sparse_cholesky(const Compressed_storage<T>& a) : _n(a.major()), _source_nnz(a.nnz()) {
+        analyze(a);
+        factorize(a);
+    }
+
+    /**
+     * @brief Factorize new values of the analysed matrix
+     *
+     * @param a rows of matrix with the pattern of the analysed one
+     */
+    void factorize(const Compressed_storage<T>& a) {
+        if (a.major() != _n || a.nnz() != _source_nnz) {
+            throw MatrixException("Wrong input - pattern differs from the analysed matrix!");
+        }
+        int supernodes = _super.size() - 1;
+        _values.assign(_value_ptr.back(), T());
+        std::vector<std::vector<T>> updates(supernodes);
+        std::vector<int> position(_n, -1);
+        std::vector<int> first_child(supernodes, -1);
+        std::vector<int> next_child(supernodes, -1);
+        for (int s = supernodes - 1; s >= 0; --s) {
+            if (_super_parent[s] != -1) {
+                next_child[s] = first_child[_super_parent[s]];
+                first_child[_super_parent[s]] = s;
+            }
+        }
+        for (int s = 0; s < supernodes; ++s) {
+            int k = width(s);
+            int m = height(s);
+            int r = m - k;
+            const int* rows = _rows.data() + _row_ptr[s];
+            for (int t = 0; t < m; ++t) {
+                position[rows[t]] = t;
+            }
+            // front: the panel of L is m x k, the Schur complement r x r, both row-major
+            T* panel = _values.data() + _value_ptr[s];
+            std::vector<T> schur(std::size_t(r) * r, T());
+            auto front = [&](int i, int j) -> T& {
+                return j < k ? panel[std::size_t(i) * k + j] : schur[std::size_t(i - k) * r + (j - k)];
+            };
+            for (int j = _super[s]; j < _super[s + 1]; ++j) {
+                for (std::size_t t = _lower_ptr[j]; t < _lower_ptr[j + 1]; ++t) {
+                    front(position[_lower_idx[t]], j - _super[s]) += a.values[_source[t]];
+                }
+            }
+            for (int c = first_child[s]; c != -1; c = next_child[c]) {
+                // extend-add of the lower triangle of the child's Schur complement
+                int kc = width(c);
+                int rc = height(c) - kc;
+                const int* child_rows = _rows.data() + _row_ptr[c] + kc;
+                const T* update = updates[c].data();
+                for (int i = 0; i < rc; ++i) {
+                    int pi = position[child_rows[i]];
+                    for (int j = 0; j <= i; ++j) {
+                        front(pi, position[child_rows[j]]) += update[std::size_t(i) * rc + j];
+                    }
+                }
+                std::vector<T>().swap(updates[c]);
+            }
+
+            // dense Cholesky of the k x k block and triangular solve of the rows below it
+            for (int i = 0; i < m; ++i) {
+                T* row = panel + std::size_t(i) * k;
+                for (int j = 0; j <= std::min(i, k - 1); ++j) {
+                    const T* pivot = panel + std::size_t(j) * k;
+                    T sum = row[j];
+                    for (int t = 0; t < j; ++t) {
+                        sum -= row[t] * pivot[t];
+                    }
+                    if (i == j) {
+                        if (!(sum > T())) {
+                            throw MatrixException("Matrix is not positive definite!");
+                        }
+                        row[j] = std::sqrt(sum);
+                    } else {
+                        row[j] = sum / pivot[j];
+                    }
+                }
+            }
+            // Schur complement S -= L21 L21^T by the blocked dense product
+            if (r > 0) {
+                std::vector<T> left(std::size_t(r) * k);
+                std::vector<T> right(std::size_t(k) * r);
+                for (int i = 0; i < r; ++i) {
+                    for (int j = 0; j < k; ++j) {
+                        T value = panel[std::size_t(k + i) * k + j];
+                        left[std::size_t(i) * k + j] = -value;
+                        right[std::size_t(j) * r + i] = value;
+                    }
+                }
+                if (useful_threads(std::size_t(r) * r * k, matrix_thread_count()) > 1) {
+                    dense_gemm(left.data(), right.data(), schur.data(), r, k, r);
+                } else {
+                    // only the lower triangle is read by the parent, half of the product suffices
+                    for (int i = 0; i < r; ++i) {
+                        T* out = schur.data() + std::size_t(i) * r;
+                        for (int t = 0; t < k; ++t) {
+                            T factor = left[std::size_t(i) * k + t];
+                            const T* column = right.data() + std::size_t(t) * r;
+                            for (int j = 0; j <= i; ++j) {
+                                out[j] += factor * column[j];
+                            }
+                        }
+                    }
+                }
+                updates[s] = std::move(schur);
+            }
+        }
+    }
+
+    /**
+     * @brief Solution x of A x = b by two triangular sweeps
+     *
+     * @param b right-hand side
+     * @return std::vector<T>
+     */
+    std::vector<T> solve(const std::vector<T>& b) const {
+        if (int(b.size()) != _n) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        std::vector<T> x(_n);
+        for (int k = 0; k < _n; ++k) {
+            x[k] = b[_perm[k]];
+        }
+        int supernodes = _super.size() - 1;
+        for (int s = 0; s < supernodes; ++s) {
+            int k = width(s);
+            int m = height(s);
+            const int* rows = _rows.data() + _row_ptr[s];
+            const T* panel = _values.data() + _value_ptr[s];
+            T* own = x.data() + _super[s];
+            for (int i = 0; i < k; ++i) {
+                T sum = own[i];
+                for (int t = 0; t < i; ++t) {
+                    sum -= panel[std::size_t(i) * k + t] * own[t];
+                }
+                own[i] = sum / panel[std::size_t(i) * k + i];
+            }
+            for (int i = k; i < m; ++i) {
+                T sum = T();
+                for (int t = 0; t < k; ++t) {
+                    sum += panel[std::size_t(i) * k + t] * own[t];
+                }
+                x[rows[i]] -= sum;
+            }
+        }
+        for (int s = supernodes - 1; s >= 0; --s) {
+            int k = width(s);
+            int m = height(s);
+            const int* rows = _rows.data() + _row_ptr[s];
+            const T* panel = _values.data() + _value_ptr[s];
+            T* own = x.data() + _super[s];
+            for (int i = k; i < m; ++i) {
+                T value = x[rows[i]];
+                for (int t = 0; t < k; ++t) {
+                    own[t] -= panel[std::size_t(i) * k + t] * value;
+                }
+            }
+            for (int i = k - 1; i >= 0; --i) {
+                own[i] /= panel[std::size_t(i) * k + i];
+                for (int t = 0; t < i; ++t) {
+                    own[t] -= panel[std::size_t(i) * k + t] * own[i];
+                }
+            }
+        }
+        std::vector<T> res(_n);
+        for (int k = 0; k < _n; ++k) {
+            res[_perm[k]] = x[k];
+        }
+        return res;
+    }
+
+    /**
+     * @brief Number of nonzeros of L
+     *
+     * @return std::size_t
+     */
+    std::size_t nnz() const {
+        std::size_t res = 0;
+        for (int s = 0; s + 1 < int(_super.size()); ++s) {
+            res += std::size_t(height(s)) * width(s) - std::size_t(width(s)) * (width(s) - 1) / 2;
+        }
+        return res;
+    }
+
+    /**
+     * @brief Number of supernodes
+     *
+     * @return int
+     */
+    int supernodes() const {
+        return _super.size() - 1;
+    }
+};
+
+/**
+ * @brief Diagonal pivot of a matrix with symmetric pattern is kept if it is at least this share of the largest one
+ */
+const double PIVOT_TOLERANCE = 0.1;
+
+/**
+ * @brief Sparse LU factorization P A Q = L U with partial pivoting
+ *
+ * The symbolic analysis orders the columns by minimum degree of A^T A and
+ * postorders the column elimination tree (COLAMD strategy). A matrix with
+ * symmetric pattern and nonzero diagonal is ordered as in Sparse_cholesky and keeps
+ * diagonal pivots within PIVOT_TOLERANCE, which preserves the much smaller
+ * fill of that order. The numeric factorization is left-looking
+ * (Gilbert-Peierls): column k of L and U is a sparse triangular solve with the
+ * columns already computed, restricted to the rows reachable from the column
+ * of A, and the pivot is its largest remaining entry.
+ *
+ * @tparam T floating point type
+ */
+template<typename T>
+class Sparse_lu {
+    /**
+     * @brief dimention
+     */
+    int _n;
+    /**
+     * @brief symmetric order, diagonal pivots are preferred
+     */
+    bool _symmetric;
+    /**
+     * @brief order of columns, _columns[k] is the column of A eliminated at step k
+     */
+    std::vector<int> _columns;
+    /**
+     * @brief step at which every row of A is the pivot
+     */
+    std::vector<int> _pivots;
+    /**
+     * @brief columns of L with unit diagonal first and of U with diagonal last, rows are steps
+     */
+    Compressed_storage<T> _lower;
+    Compressed_storage<T> _upper;
+
+    /**
+     * @brief Pattern is symmetric and the diagonal has no zeros
+     */
+    static bool symmetric_strategy(const Compressed_storage<T>& a) {
+        for (int r = 0; r < a.major(); ++r) {
+            std::size_t k = a.find(r, r);
+            if (k == a.nnz() || a.values[k] == T()) {
+                return false;
+            }
+        }
+        return symmetric_pattern(a);
+    }
+
+    /**
+     * @brief Rows reachable from column c of A through columns of L, in topological order
+     */
+    void reach(const Compressed_storage<T>& columns, int c, int step, std::vector<int>& mark,
+               std::vector<std::pair<int, std::size_t>>& stack, std::vector<int>& res) const {
+        res.clear();
+        for (std::size_t t = columns.ptr[c]; t < columns.ptr[c + 1]; ++t) {
+            if (mark[columns.idx[t]] == step) {
+                continue;
+            }
+            stack.push_back({columns.idx[t], 0});
+            mark[columns.idx[t]] = step;
+            while (!stack.empty()) {
+                auto& [row, next] = stack.back();
+                int pivot = _pivots[row];
+                std::size_t end = pivot == -1 ? 0 : _lower.ptr[pivot + 1];
+                if (pivot != -1 && next == 0) {
+                    next = _lower.ptr[pivot] + 1;
+                }
+                while (next < end && mark[_lower.idx[next]] == step) {
+                    ++next;
+                }
+                if (next < end) {
+                    int child = _lower.idx[next++];
+                    mark[child] = step;
+                    stack.push_back({child, 0});
+                } else {
+                    res.push_back(row);
+                    stack.pop_back();
+                }
+            }
+        }
+        std::reverse(res.begin(), res.end());
+    }
+public:
+    /**
+     * @brief Analyse and factorize
+     *
+     * @param a rows of nonsingular square matrix
+     */
+    explicit Sparse_lu(const Compressed_storage<T>& a) :
+                       _n(a.major()), _symmetric(symmetric_strategy(a)),
+                       _columns(_symmetric ? symmetric_ordering(a) : column_ordering(a, a.major())) {
+        factorize(a);
+    }
+
+    /**
+     * @brief Factorize new values with the analysed order of columns
+     *
+     * @param a rows of square matrix of the same dimention
+     */
+    void factorize(const Compressed_storage<T>& a) {
+        if (a.major() != _n) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        Compressed_storage<T> columns = a.transposed(_n);
+        _pivots.assign(_n, -1);
+        _lower = Compressed_storage<T>(_n);
+        _upper = Compressed_storage<T>(_n);
+        _lower.idx.reserve(a.nnz() * 2);
+        _upper.idx.reserve(a.nnz() * 2);
+        std::vector<T> x(_n, T());
+        std::vector<int> mark(_n, -1);
+        std::vector<std::pair<int, std::size_t>> stack;
+        std::vector<int> pattern;
+        for (int k = 0; k < _n; ++k) {
+            int c = _columns[k];
+            reach(columns, c, k, mark, stack, pattern);
+            for (std::size_t t = columns.ptr[c]; t < columns.ptr[c + 1]; ++t) {
+                x[columns.idx[t]] = columns.values[t];
+            }
+            for (int j : pattern) {
+                int pivot = _pivots[j];
+                if (pivot == -1) {
+                    continue;
+                }
+                T value = x[j];
+                for (std::size_t t = _lower.ptr[pivot] + 1; t < _lower.ptr[pivot + 1]; ++t) {
+                    x[_lower.idx[t]] -= _lower.values[t] * value;
+                }
+            }
+            int best = -1;
+            for (int j : pattern) {
+                if (_pivots[j] == -1) {
+                    if (best == -1 || std::abs(x[j]) > std::abs(x[best])) {
+                        best = j;
+                    }
+                } else if (x[j] != T()) {
+                    _upper.push_back(_pivots[j], x[j]);
+                }
+            }
+            if (best == -1 || x[best] == T()) {
+                throw MatrixException("Matrix is singular!");
+            }
+            if (_symmetric && _pivots[c] == -1 && std::abs(x[c]) >= PIVOT_TOLERANCE * std::abs(x[best])) {
+                best = c;
+            }
+            T pivot = x[best];
+            _upper.push_back(k, pivot);
+            _upper.ptr[k + 1] = _upper.nnz();
+            _pivots[best] = k;
+            _lower.push_back(best, T(1));
+            for (int j : pattern) {
+                if (_pivots[j] == -1 && x[j] != T()) {
+                    _lower.push_back(j, x[j] / pivot);
+                }
+                x[j] = T();
+            }
+            _lower.ptr[k + 1] = _lower.nnz();
+        }
+        for (int& row : _lower.idx) {
+            row = _pivots[row];
+        }
+        // sorted rows keep the diagonal first in L and last in U
+        for (Compressed_storage<T>* factor : {&_lower, &_upper}) {
+            std::vector<std::pair<int, T>> line;
+            for (int k = 0; k < _n; ++k) {
+                line.clear();
+                for (std::size_t t = factor->ptr[k]; t < factor->ptr[k + 1]; ++t) {
+                    line.push_back({factor->idx[t], factor->values[t]});
+                }
+                std::sort(line.begin(), line.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+                for (std::size_t t = 0; t < line.size(); ++t) {
+                    factor->idx[factor->ptr[k] + t] = line[t].first;
+                    factor->values[factor->ptr[k] + t] = line[t].second;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Solution x of A x = b by two triangular sweeps
+     *
+     * @param b right-hand side
+     * @return std::vector<T>
+     */
+    std::vector<T> solve(const std::vector<T>& b) const {
+        if (int(b.size()) != _n) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        std::vector<T> y(_n);
+        for (int i = 0; i < _n; ++i) {
+            y[_pivots[i]] = b[i];
+        }
+        for (int k = 0; k < _n; ++k) {
+            for (std::size_t t = _lower.ptr[k] + 1; t < _lower.ptr[k + 1]; ++t) {
+                y[_lower.idx[t]] -= _lower.values[t] * y[k];
+            }
+        }
+        for (int k = _n - 1; k >= 0; --k) {
+            y[k] /= _upper.values[_upper.ptr[k + 1] - 1];
+            for (std::size_t t = _upper.ptr[k]; t + 1 < _upper.ptr[k + 1]; ++t) {
+                y[_upper.idx[t]] -= _upper.values[t] * y[k];
+            }
+        }
+        std::vector<T> res(_n);
+        for (int k = 0; k < _n; ++k) {
+            res[_columns[k]] = y[k];
+        }
+        return res;
+    }
+
+    /**
+     * @brief Number of nonzeros of L and U
+     *
+     * @return std::size_t
+     */
+    std::size_t nnz() const {
+        return _lower.nnz() + _upper.nnz();
+    }
+};
+
+#endif
@@ -0,0 +1,716 @@
+#ifndef SPARSE_ORDERING_H
+#define SPARSE_ORDERING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+#include <utility>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Parallel_kernels.h"
+
+/**
+ * @brief Rows with more nonzeros than this share of sqrt(n) are left out of column orderings
+ */
+const double DENSE_ROW_RATIO = 10.0;
+
+/**
+ * @brief Vertices of a part of partition_ordering, x and y of a part stay in cache during SpMV
+ */
+const int PARTITION_SIZE = 4096;
+
+/**
+ * @brief Enum for bandwidth and locality reducing orderings
+ *
+ */
+enum class Reordering {
+    RCM,
+    PARTITION,
+};
+
+/**
+ * @brief Outcome of a symmetric reordering
+ */
+struct Reordering_report {
+    /**
+     * @brief old index of every new index
+     */
+    std::vector<int> permutation{};
+    int bandwidth_before = 0;
+    int bandwidth_after = 0;
+    std::size_t profile_before = 0;
+    std::size_t profile_after = 0;
+
+    /**
+     * @brief << operator
+     *
+     * @param out output stream
+     * @param report report
+     * @return std::ostream&
+     */
+    friend std::ostream& operator<<(std::ostream& out, const Reordering_report& report) {
+        return out << "bandwidth " << report.bandwidth_before << " -> " << report.bandwidth_after << ", profile "
+                   << report.profile_before << " -> " << report.profile_after;
+    }
+};
+
+/**
+ * @brief Adjacency of the pattern of A + A^T without the diagonal
+ *
+ * @param a rows of square matrix
+ * @return std::vector<std::vector<int>> sorted neighbours of every vertex
+ */
+template<typename T>
+std::vector<std::vector<int>> symmetric_adjacency(const Compressed_storage<T>& a) {
+    int n = a.major();
+    Compressed_storage<T> transposed = a.transposed(n);
+    std::vector<std::vector<int>> res(n);
+    for (int r = 0; r < n; ++r) {
+        // union of the sorted rows of A and A^T
+        auto& neighbours = res[r];
+        neighbours.reserve(std::max(a.ptr[r + 1] - a.ptr[r], transposed.ptr[r + 1] - transposed.ptr[r]));
+        std::size_t i = a.ptr[r], i_end = a.ptr[r + 1];
+        std::size_t j = transposed.ptr[r], j_end = transposed.ptr[r + 1];
+        while (i < i_end || j < j_end) {
+            int c = j == j_end || (i < i_end && a.idx[i] < transposed.idx[j]) ? a.idx[i++]
+                  : i == i_end || transposed.idx[j] < a.idx[i] ? transposed.idx[j++]
+                  : (++j, a.idx[i++]);
+            if (c != r) {
+                neighbours.push_back(c);
+            }
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief Minimum degree ordering on the quotient graph (AMD)
+ *
+ * Eliminated vertices become elements, a vertex is adjacent to the remaining
+ * vertices of its elements and to its own remaining neighbours. Degrees are
+ * the approximate external degrees of AMD, elements contained in a new one are
+ * absorbed. Supervariables are not detected.
+ *
+ * Initial elements describe cliques known in advance: the rows of A give the
+ * column ordering for A^T A (COLAMD) without forming the product.
+ *
+ * @param n number of vertices
+ * @param adjacency neighbours of every vertex, empty or of size n
+ * @param elements initial elements as lists of their vertices
+ * @return std::vector<int> vertices in order of elimination
+ */
+inline std::vector<int> minimum_degree_ordering(int n, std::vector<std::vector<int>> adjacency,
+                                                std::vector<std::vector<int>> elements = {}) {
+    adjacency.resize(n);
+    int m = elements.size();
+    // element e < m is initial, element m + p is made by the elimination of p
+    std::vector<std::vector<int>> members(m + n);
+    std::vector<std::vector<int>> incident(n);
+    for (int e = 0; e < m; ++e) {
+        members[e] = std::move(elements[e]);
+        for (int v : members[e]) {
+            incident[v].push_back(e);
+        }
+    }
+    std::vector<char> eliminated(n, false);
+    std::vector<char> absorbed(m + n, false);
+    // vertices of every degree in doubly linked lists
+    std::vector<int> degree(n);
+    std::vector<int> head(n, -1);
+    std::vector<int> next(n, -1);
+    std::vector<int> previous(n, -1);
+    int minimum = 0;
+    auto insert = [&](int v) {
+        int d = degree[v];
+        next[v] = head[d];
+        previous[v] = -1;
+        if (head[d] != -1) {
+            previous[head[d]] = v;
+        }
+        head[d] = v;
+        minimum = std::min(minimum, d);
+    };
+    auto remove = [&](int v) {
+        if (previous[v] != -1) {
+            next[previous[v]] = next[v];
+        } else {
+            head[degree[v]] = next[v];
+        }
+        if (next[v] != -1) {
+            previous[next[v]] = previous[v];
+        }
+    };
+    for (int v = 0; v < n; ++v) {
+        std::size_t d = adjacency[v].size();
+        for (int e : incident[v]) {
+            d += members[e].size() - 1;
+        }
+        degree[v] = std::min<std::size_t>(d, n - 1);
+        insert(v);
+    }
+    std::vector<int> mark(n, -1);
+    std::vector<int> stamp(m + n, -1);
+    std::vector<int> outside(m + n, 0);
+    std::vector<int> order;
+    order.reserve(n);
+    for (int step = 0; step < n; ++step) {
+        while (head[minimum] == -1) {
+            ++minimum;
+        }
+        int p = head[minimum];
+        remove(p);
+        eliminated[p] = true;
+        order.push_back(p);
+
+        // the new element holds the remaining neighbours of p and of its elements
+        std::vector<int>& pattern = members[m + p];
+        mark[p] = step;
+        for (int v : adjacency[p]) {
+            if (!eliminated[v] && mark[v] != step) {
+                mark[v] = step;
+                pattern.push_back(v);
+            }
+        }
+        for (int e : incident[p]) {
+            if (absorbed[e]) {
+                continue;
+            }
+            for (int v : members[e]) {
+                if (!eliminated[v] && mark[v] != step) {
+                    mark[v] = step;
+                    pattern.push_back(v);
+                }
+            }
+            absorbed[e] = true;
+            std::vector<int>().swap(members[e]);
+        }
+        std::vector<int>().swap(adjacency[p]);
+        std::vector<int>().swap(incident[p]);
+
+        for (int i : pattern) {
+            auto& neighbours = adjacency[i];
+            neighbours.erase(std::remove_if(neighbours.begin(), neighbours.end(), [&](int v) {
+                return eliminated[v] || mark[v] == step;
+            }), neighbours.end());
+            auto& own = incident[i];
+            own.erase(std::remove_if(own.begin(), own.end(), [&](int e) { return absorbed[e]; }), own.end());
+        }
+        // outside[e] = |L_e \ L_p| for elements of vertices of the new element, elements
+        // never hold eliminated vertices since the elimination of a vertex absorbs its elements
+        for (int i : pattern) {
+            for (int e : incident[i]) {
+                if (stamp[e] != step) {
+                    stamp[e] = step;
+                    outside[e] = members[e].size();
+                }
+                --outside[e];
+            }
+        }
+        for (int i : pattern) {
+            std::size_t d = adjacency[i].size() + pattern.size() - 1;
+            auto& own = incident[i];
+            for (int e : own) {
+                if (outside[e] == 0) {
+                    absorbed[e] = true;
+                    std::vector<int>().swap(members[e]);
+                } else {
+                    d += outside[e];
+                }
+            }
+            own.erase(std::remove_if(own.begin(), own.end(), [&](int e) { return absorbed[e]; }), own.end());
+            own.push_back(m + p);
+            remove(i);
+            degree[i] = std::min<std::size_t>(d, n - step - 2);
+            insert(i);
+        }
+    }
+    return order;
+}
+
+/**
+ * @brief Inverse of a permutation
+ *
+ * @param perm permutation, perm[k] is the old index of new index k
+ * @return std::vector<int> new index of every old index
+ */
+inline std::vector<int> inverse_permutation(const std::vector<int>& perm) {
+    std::vector<int> res(perm.size());
+    for (std::size_t k = 0; k < perm.size(); ++k) {
+        res[perm[k]] = k;
+    }
+    return res;
+}
+
+/**
+ * @brief Elimination tree of a symmetric matrix (Liu's algorithm with path compression)
+ *
+ * @param lower rows of the strictly lower triangle, row k holds columns j < k
+ * @return std::vector<int> parent of every column, -1 for roots
+ */
+inline std::vector<int> elimination_tree(const std::vector<std::vector<int>>& lower) {
+    int n = lower.size();
+    std::vector<int> parent(n, -1);
+    std::vector<int> ancestor(n, -1);
+    for (int k = 0; k < n; ++k) {
+        for (int j : lower[k]) {
+            while (j != -1 && j < k) {
+                int next = ancestor[j];
+                ancestor[j] = k;
+                if (next == -1) {
+                    parent[j] = k;
+                }
+                j = next;
+            }
+        }
+    }
+    return parent;
+}
+
+/**
+ * @brief Elimination tree of A^T A without forming it
+ *
+ * @param columns columns of A (rows of its transposed storage)
+ * @param rows number of rows of A
+ * @param order order of columns
+ * @return std::vector<int> parent of every step, -1 for roots
+ */
+template<typename T>
+std::vector<int> column_elimination_tree(const Compressed_storage<T>& columns, int rows, const std::vector<int>& order) {
+    int n = order.size();
+    std::vector<int> parent(n, -1);
+    std::vector<int> ancestor(n, -1);
+    // last step whose column has a nonzero in the row, rows of A are cliques of A^T A
+    std::vector<int> previous(rows, -1);
+    for (int k = 0; k < n; ++k) {
+        int c = order[k];
+        for (std::size_t t = columns.ptr[c]; t < columns.ptr[c + 1]; ++t) {
+            int i = columns.idx[t];
+            for (int j = previous[i]; j != -1 && j < k;) {
+                int next = ancestor[j];
+                ancestor[j] = k;
+                if (next == -1) {
+                    parent[j] = k;
+                }
+                j = next;
+            }
+            previous[i] = k;
+        }
+    }
+    return parent;
+}
+
+/**
+ * @brief Postorder of a forest, children are visited in increasing order
+ *
+ * @param parent parent of every vertex, -1 for roots
+ * @return std::vector<int> vertices in postorder
+ */
+inline std::vector<int> tree_postorder(const std::vector<int>& parent) {
+    int n = parent.size();
+    std::vector<int> head(n, -1);
+    std::vector<int> next(n, -1);
+    for (int j = n - 1; j >= 0; --j) {
+        if (parent[j] != -1) {
+            next[j] = head[parent[j]];
+            head[parent[j]] = j;
+        }
+    }
+    std::vector<int> res;
+    res.reserve(n);
+    std::vector<int> stack;
+    for (int root = 0; root < n; ++root) {
+        if (parent[root] != -1) {
+            continue;
+        }
+        stack.push_back(root);
+        while (!stack.empty()) {
+            int j = stack.back();
+            if (head[j] == -1) {
+                stack.pop_back();
+                res.push_back(j);
+            } else {
+                stack.push_back(head[j]);
+                head[j] = next[head[j]];
+            }
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief Is the pattern of square matrix symmetric
+ *
+ * @param a rows of square matrix
+ * @return true
+ * @return false
+ */
+template<typename T>
+bool symmetric_pattern(const Compressed_storage<T>& a) {
+    Compressed_storage<T> transposed = a.transposed(a.major());
+    return transposed.ptr == a.ptr && transposed.idx == a.idx;
+}
+
+/**
+ * @brief Symmetric order of A: minimum degree of A + A^T followed by postorder of the elimination tree
+ *
+ * The postorder keeps the fill and makes columns of supernodes contiguous.
+ *
+ * @param a rows of square matrix
+ * @return std::vector<int> vertices in order of elimination
+ */
+template<typename T>
+std::vector<int> symmetric_ordering(const Compressed_storage<T>& a) {
+    int n = a.major();
+    std::vector<std::vector<int>> adjacency = symmetric_adjacency(a);
+    std::vector<int> order = minimum_degree_ordering(n, adjacency);
+    std::vector<int> inverse = inverse_permutation(order);
+    std::vector<std::vector<int>> lower(n);
+    for (int k = 0; k < n; ++k) {
+        for (int v : adjacency[order[k]]) {
+            if (inverse[v] < k) {
+                lower[k].push_back(inverse[v]);
+            }
+        }
+    }
+    std::vector<int> post = tree_postorder(elimination_tree(lower));
+    std::vector<int> res(n);
+    for (int k = 0; k < n; ++k) {
+        res[k] = order[post[k]];
+    }
+    return res;
+}
+
+/**
+ * @brief Column order of A for LU factorization: minimum degree of A^T A followed by postorder
+ *
+ * Rows denser than DENSE_ROW_RATIO * sqrt(n) are left out, as COLAMD does.
+ *
+ * @param a rows of matrix
+ * @param columns number of columns
+ * @return std::vector<int> columns in order of elimination
+ */
+template<typename T>
+std::vector<int> column_ordering(const Compressed_storage<T>& a, int columns) {
+    std::size_t dense = std::max(16.0, DENSE_ROW_RATIO * std::sqrt(double(columns)));
+    std::vector<std::vector<int>> elements;
+    for (int r = 0; r < a.major(); ++r) {
+        if (a.ptr[r + 1] - a.ptr[r] <= dense) {
+            elements.emplace_back(a.idx.begin() + a.ptr[r], a.idx.begin() + a.ptr[r + 1]);
+        }
+    }
+    std::vector<int> order = minimum_degree_ordering(columns, {}, std::move(elements));
+    std::vector<int> post = tree_postorder(column_elimination_tree(a.transposed(columns), a.major(), order));
+    std::vector<int> res(columns);
+    for (int k = 0; k < columns; ++k) {
+        res[k] = order[post[k]];
+    }
+    return res;
+}
+
+/**
+ * @brief Breadth-first search from start over unvisited vertices with inside(v)
+ *
+ * Reached vertices are marked and appended to order, neighbours of a vertex in
+ * increasing degree if by_degree is set (Cuthill-McKee).
+ *
+ * @param adjacency neighbours of every vertex
+ * @param start first vertex
+ * @param inside predicate of vertices of the searched subgraph
+ * @param visited marks of reached vertices
+ * @param order output
+ * @param by_degree visit neighbours in increasing degree
+ * @return std::pair<int, std::size_t> number of levels and position of the last level in order
+ */
+template<typename Inside>
+std::pair<int, std::size_t> breadth_first_levels(const std::vector<std::vector<int>>& adjacency, int start,
+                                                 Inside inside, std::vector<char>& visited, std::vector<int>& order,
+                                                 bool by_degree) {
+    std::size_t head = order.size();
+    std::size_t level_begin = head;
+    std::size_t level_end = head + 1;
+    int levels = 1;
+    visited[start] = true;
+    order.push_back(start);
+    while (head < order.size()) {
+        if (head == level_end) {
+            level_begin = level_end;
+            level_end = order.size();
+            ++levels;
+        }
+        int v = order[head++];
+        std::size_t first = order.size();
+        for (int u : adjacency[v]) {
+            if (!visited[u] && inside(u)) {
+                visited[u] = true;
+                order.push_back(u);
+            }
+        }
+        if (by_degree) {
+            std::stable_sort(order.begin() + first, order.end(), [&adjacency](int a, int b) {
+                return adjacency[a].size() < adjacency[b].size();
+            });
+        }
+    }
+    return {levels, level_begin};
+}
+
+/**
+ * @brief Pseudo-peripheral vertex of the component of start (George and Liu)
+ *
+ * Searches restart from a vertex of least degree in the last level while the
+ * number of levels grows.
+ *
+ * @param adjacency neighbours of every vertex
+ * @param start vertex of the component
+ * @param inside predicate of vertices of the subgraph
+ * @param visited marks, unchanged on return
+ * @param scratch buffer for orders
+ * @return int
+ */
+template<typename Inside>
+int pseudo_peripheral_vertex(const std::vector<std::vector<int>>& adjacency, int start, Inside inside,
+                             std::vector<char>& visited, std::vector<int>& scratch) {
+    int res = start;
+    int levels = 0;
+    while (true) {
+        scratch.clear();
+        auto [count, last] = breadth_first_levels(adjacency, res, inside, visited, scratch, false);
+        int candidate = scratch[last];
+        for (std::size_t k = last; k < scratch.size(); ++k) {
+            if (adjacency[scratch[k]].size() < adjacency[candidate].size()) {
+                candidate = scratch[k];
+            }
+        }
+        for (int v : scratch) {
+            visited[v] = false;
+        }
+        if (count <= levels) {
+            return res;
+        }
+        levels = count;
+        res = candidate;
+    }
+}
+
+/**
+ * @brief Reverse Cuthill-McKee order of the vertices of a subgraph, appended to order
+ *
+ * Every component starts at a pseudo-peripheral vertex, the reversed
+ * Cuthill-McKee order has the same bandwidth and a smaller profile.
+ *
+ * @param adjacency neighbours of every vertex
+ * @param vertices vertices of the subgraph
+ * @param inside predicate of vertices of the subgraph
+ * @param visited marks, vertices of the subgraph are marked on return
+ * @param order output
+ */
+template<typename Inside>
+void append_reverse_cuthill_mckee(const std::vector<std::vector<int>>& adjacency, const std::vector<int>& vertices,
+                                  Inside inside, std::vector<char>& visited, std::vector<int>& order) {
+    std::size_t first = order.size();
+    std::vector<int> scratch;
+    std::vector<int> seeds(vertices);
+    std::stable_sort(seeds.begin(), seeds.end(), [&adjacency](int a, int b) {
+        return adjacency[a].size() < adjacency[b].size();
+    });
+    for (int v : seeds) {
+        if (!visited[v]) {
+            int start = pseudo_peripheral_vertex(adjacency, v, inside, visited, scratch);
+            breadth_first_levels(adjacency, start, inside, visited, order, true);
+        }
+    }
+    std::reverse(order.begin() + first, order.end());
+}
+
+/**
+ * @brief Reverse Cuthill-McKee order (RCM) reducing bandwidth and profile
+ *
+ * @param adjacency symmetric neighbours of every vertex
+ * @return std::vector<int> vertices in new order
+ */
+inline std::vector<int> reverse_cuthill_mckee(const std::vector<std::vector<int>>& adjacency) {
+    int n = adjacency.size();
+    std::vector<int> vertices(n);
+    for (int v = 0; v < n; ++v) {
+        vertices[v] = v;
+    }
+    std::vector<char> visited(n, false);
+    std::vector<int> res;
+    res.reserve(n);
+    append_reverse_cuthill_mckee(adjacency, vertices, [](int) { return true; }, visited, res);
+    return res;
+}
+
+/**
+ * @brief Order by recursive bisection into parts of at most part_size vertices
+ *
+ * A part is split in halves of a breadth-first order from a pseudo-peripheral
+ * vertex, so halves are compact and share a small level set. The half with
+ * more edges to placed vertices and fewer to waiting parts goes first. Leaves
+ * are ordered by RCM and laid out one after another: rows of a part touch
+ * mostly columns of the same and of neighbouring parts, which stay in cache.
+ * Bandwidth is not minimized.
+ *
+ * @param adjacency symmetric neighbours of every vertex
+ * @param part_size largest number of vertices of a part
+ * @return std::vector<int> vertices in new order
+ */
+inline std::vector<int> partition_ordering(const std::vector<std::vector<int>>& adjacency,
+                                           int part_size = PARTITION_SIZE) {
+    int n = adjacency.size();
+    part_size = std::max(part_size, 1);
+    std::vector<int> part(n, 0);
+    std::vector<char> visited(n, false);
+    std::vector<int> res;
+    res.reserve(n);
+    std::vector<int> scratch;
+    int parts = 1;
+    // parts waiting for a split, the last one is taken first to keep their order
+    // with an end of the breadth-first order of the parent, a peripheral start of the first component
+    struct Part {
+        std::vector<int> vertices;
+        int id;
+        int start;
+    };
+    std::vector<Part> stack;
+    std::vector<int> all(n);
+    for (int v = 0; v < n; ++v) {
+        all[v] = v;
+    }
+    stack.push_back({std::move(all), 0, -1});
+    while (!stack.empty()) {
+        Part current = std::move(stack.back());
+        stack.pop_back();
+        const std::vector<int>& vertices = current.vertices;
+        int id = current.id;
+        auto inside = [&part, id](int v) { return part[v] == id; };
+        if (int(vertices.size()) <= part_size) {
+            append_reverse_cuthill_mckee(adjacency, vertices, inside, visited, res);
+            continue;
+        }
+        std::vector<int> order;
+        order.reserve(vertices.size());
+        if (current.start != -1) {
+            breadth_first_levels(adjacency, current.start, inside, visited, order, false);
+        }
+        for (int v : vertices) {
+            if (!visited[v]) {
+                int start = pseudo_peripheral_vertex(adjacency, v, inside, visited, scratch);
+                breadth_first_levels(adjacency, start, inside, visited, order, false);
+            }
+        }
+        for (int v : order) {
+            visited[v] = false;
+        }
+        std::size_t half = order.size() / 2;
+        std::vector<int> first(order.begin(), order.begin() + half);
+        std::vector<int> second(order.begin() + half, order.end());
+        // the half with more edges to placed vertices and fewer to waiting ones goes first
+        auto closeness = [&](const std::vector<int>& vertices) {
+            long long res = 0;
+            for (int v : vertices) {
+                for (int u : adjacency[v]) {
+                    res += visited[u] ? 1 : part[u] != id ? -1 : 0;
+                }
+            }
+            return res;
+        };
+        int first_start = order.front();
+        int second_start = order.back();
+        if (closeness(second) > closeness(first)) {
+            first.swap(second);
+            std::swap(first_start, second_start);
+        }
+        int first_id = parts++;
+        int second_id = parts++;
+        for (int v : first) {
+            part[v] = first_id;
+        }
+        for (int v : second) {
+            part[v] = second_id;
+        }
+        stack.push_back({std::move(second), second_id, second_start});
+        stack.push_back({std::move(first), first_id, first_start});
+    }
+    return res;
+}
+
+/**
+ * @brief Storage of P A Q^T: new row k is old row rows[k], new column k is old column columns[k]
+ *
+ * Row lengths give the offsets, then rows are filled and sorted in parallel.
+ *
+ * @param a storage (CSR)
+ * @param rows old index of every new row
+ * @param columns old index of every new column
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<typename T>
+Compressed_storage<T> permute_storage(const Compressed_storage<T>& a, const std::vector<int>& rows,
+                                      const std::vector<int>& columns, int threads = matrix_thread_count()) {
+    int n = rows.size();
+    std::vector<int> new_column = inverse_permutation(columns);
+    Compressed_storage<T> res(n);
+    std::vector<std::size_t> work(n);
+    for (int k = 0; k < n; ++k) {
+        work[k] = a.ptr[rows[k] + 1] - a.ptr[rows[k]];
+        res.ptr[k + 1] = res.ptr[k] + work[k];
+    }
+    res.idx.resize(res.ptr[n]);
+    res.values.resize(res.ptr[n]);
+    parallel_ranges(partition_rows(work, useful_threads(a.nnz(), threads)), [&](int, int first, int last) {
+        std::vector<std::pair<int, std::size_t>> entries;
+        for (int k = first; k < last; ++k) {
+            int r = rows[k];
+            entries.clear();
+            for (std::size_t t = a.ptr[r]; t < a.ptr[r + 1]; ++t) {
+                entries.emplace_back(new_column[a.idx[t]], t);
+            }
+            std::sort(entries.begin(), entries.end());
+            std::size_t out = res.ptr[k];
+            for (const auto& [column, t] : entries) {
+                res.idx[out] = column;
+                res.values[out++] = a.values[t];
+            }
+        }
+    });
+    return res;
+}
+
+/**
+ * @brief Largest distance of a nonzero from the diagonal
+ *
+ * @param a storage (CSR) with sorted rows
+ * @return int
+ */
+template<typename T>
+int storage_bandwidth(const Compressed_storage<T>& a) {
+    int res = 0;
+    for (int r = 0; r < a.major(); ++r) {
+        if (a.ptr[r] != a.ptr[r + 1]) {
+            res = std::max({res, r - a.idx[a.ptr[r]], a.idx[a.ptr[r + 1] - 1] - r});
+        }
+    }
+    return res;
+}
+
+/**
+ * @brief Profile (envelope size): sum over rows of the distance from the first nonzero to the diagonal
+ *
+ * @param a storage (CSR) with sorted rows
+ * @return std::size_t
+ */
+template<typename T>
+std::size_t storage_profile(const Compressed_storage<T>& a) {
+    std::size_t res = 0;
+    for (int r = 0; r < a.major(); ++r) {
+        if (a.ptr[r] != a.ptr[r + 1] && a.idx[a.ptr[r]] < r) {
+            res += r - a.idx[a.ptr[r]];
+        }
+    }
+    return res;
+}
+
+#endif
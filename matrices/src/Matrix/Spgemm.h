@@ -0,0 +1,267 @@
+#ifndef SPGEMM_H
+#define SPGEMM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include "Compressed_storage.h"
+
+/**
+ * @brief Sparse accumulator for one output row (Gustavson's algorithm)
+ *
+ * Holds a dense value array over all columns and a marker array. A marker equal
+ * to the current row tag means the column has been touched in this row, so the
+ * arrays never have to be cleared between rows.
+ *
+ * @tparam T
+ */
+template<typename T>
+class Sparse_accumulator {
+    /**
+     * @brief Accumulated values
+     */
+    std::vector<T> _values;
+    /**
+     * @brief Tag of the last row that touched a column
+     */
+    std::vector<long long> _marker;
+    /**
+     * @brief Columns touched in the current row
+     */
+    std::vector<int> _columns{};
+    /**
+     * @brief Tag of the current row
+     */
+    long long _tag = 0;
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param columns number of output columns
+     */
+    explicit Sparse_accumulator(int columns) : _values(columns), _marker(columns, -1) {}
+
+    /**
+     * @brief Start a new row
+     *
+     */
+    void reset() {
+        ++_tag;
+        _columns.clear();
+    }
+
+    /**
+     * @brief Touch column without a value (symbolic phase)
+     *
+     * @param column column
+     */
+    void touch(int column) {
+        if (_marker[column] != _tag) {
+            _marker[column] = _tag;
+            _columns.push_back(column);
+        }
+    }
+
+    /**
+     * @brief Add value to column
+     *
+     * @param column column
+     * @param value value
+     */
+    void add(int column, const T& value) {
+        if (_marker[column] != _tag) {
+            _marker[column] = _tag;
+            _values[column] = value;
+            _columns.push_back(column);
+        } else {
+            _values[column] += value;
+        }
+    }
+
+    /**
+     * @brief Combine value into column with another addition, e.g. of a semiring
+     *
+     * @param column column
+     * @param value value
+     * @param combine combine(accumulated, value) gives the new accumulated value
+     */
+    template<typename Combine>
+    void add(int column, const T& value, Combine combine) {
+        if (_marker[column] != _tag) {
+            _marker[column] = _tag;
+            _values[column] = value;
+            _columns.push_back(column);
+        } else {
+            _values[column] = combine(_values[column], value);
+        }
+    }
+
+    /**
+     * @brief Number of columns touched in the current row
+     *
+     * @return std::size_t
+     */
+    std::size_t size() const {
+        return _columns.size();
+    }
+
+    /**
+     * @brief Write nonzeros of the current row sorted by column
+     *
+     * @param idx output indices
+     * @param values output values
+     * @param is_zero predicate for dropped values
+     * @return std::size_t number of written nonzeros
+     */
+    template<typename Predicate>
+    std::size_t gather(int* idx, T* values, Predicate is_zero) {
+        std::sort(_columns.begin(), _columns.end());
+        std::size_t out = 0;
+        for (int column : _columns) {
+            if (!is_zero(_values[column])) {
+                idx[out] = column;
+                values[out] = _values[column];
+                ++out;
+            }
+        }
+        return out;
+    }
+};
+
+/**
+ * @brief Number of multiplications needed for every row of a * b
+ *
+ * @param a left storage
+ * @param b right storage
+ * @return std::vector<std::size_t>
+ */
+template<typename T>
+std::vector<std::size_t> spgemm_flops(const Compressed_storage<T>& a, const Compressed_storage<T>& b) {
+    std::vector<std::size_t> flops(a.major(), 0);
+    for (int r = 0; r < a.major(); ++r) {
+        for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+            flops[r] += b.ptr[a.idx[k] + 1] - b.ptr[a.idx[k]];
+        }
+    }
+    return flops;
+}
+
+/**
+ * @brief Symbolic phase for rows [first, last): structural nonzeros of every row of a * b
+ *
+ * @param a left storage
+ * @param b right storage
+ * @param accumulator accumulator over columns of b
+ * @param counts output, counts[r] is set for rows in range
+ */
+template<typename T>
+void spgemm_symbolic(const Compressed_storage<T>& a, const Compressed_storage<T>& b, int first, int last,
+                     Sparse_accumulator<T>& accumulator, std::vector<std::size_t>& counts) {
+    for (int r = first; r < last; ++r) {
+        accumulator.reset();
+        for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+            int c = a.idx[k];
+            for (std::size_t t = b.ptr[c]; t < b.ptr[c + 1]; ++t) {
+                accumulator.touch(b.idx[t]);
+            }
+        }
+        counts[r] = accumulator.size();
+    }
+}
+
+/**
+ * @brief Numeric phase for rows [first, last)
+ *
+ * Row r is written from res.ptr[r], counts[r] receives the number of nonzeros
+ * left after dropping zeros, the holes are removed by spgemm_compact.
+ *
+ * @param a left storage
+ * @param b right storage
+ * @param accumulator accumulator over columns of b
+ * @param res output with ptr from the symbolic phase
+ * @param counts output, counts[r] is set for rows in range
+ * @param is_zero predicate for dropped values
+ */
+template<typename T, typename Predicate>
+void spgemm_numeric(const Compressed_storage<T>& a, const Compressed_storage<T>& b, int first, int last,
+                    Sparse_accumulator<T>& accumulator, Compressed_storage<T>& res,
+                    std::vector<std::size_t>& counts, Predicate is_zero) {
+    for (int r = first; r < last; ++r) {
+        accumulator.reset();
+        for (std::size_t k = a.ptr[r]; k < a.ptr[r + 1]; ++k) {
+            int c = a.idx[k];
+            const T& left = a.values[k];
+            for (std::size_t t = b.ptr[c]; t < b.ptr[c + 1]; ++t) {
+                accumulator.add(b.idx[t], left * b.values[t]);
+            }
+        }
+        counts[r] = accumulator.gather(res.idx.data() + res.ptr[r], res.values.data() + res.ptr[r], is_zero);
+    }
+}
+
+/**
+ * @brief Turn per-row counts into offsets (prefix sum)
+ *
+ * @param counts counts of rows
+ * @return std::vector<std::size_t>
+ */
+inline std::vector<std::size_t> counts_to_offsets(const std::vector<std::size_t>& counts) {
+    std::vector<std::size_t> ptr(counts.size() + 1, 0);
+    for (std::size_t r = 0; r < counts.size(); ++r) {
+        ptr[r + 1] = ptr[r] + counts[r];
+    }
+    return ptr;
+}
+
+/**
+ * @brief Close the holes left by values dropped in the numeric phase
+ *
+ * @param res storage with ptr from the symbolic phase
+ * @param counts numbers of kept nonzeros
+ */
+template<typename T>
+void spgemm_compact(Compressed_storage<T>& res, const std::vector<std::size_t>& counts) {
+    std::size_t out = 0;
+    for (int r = 0; r < res.major(); ++r) {
+        std::size_t begin = res.ptr[r];
+        for (std::size_t k = 0; k < counts[r]; ++k, ++out) {
+            if (out != begin + k) {
+                res.idx[out] = res.idx[begin + k];
+                res.values[out] = std::move(res.values[begin + k]);
+            }
+        }
+        res.ptr[r] = out - counts[r];
+    }
+    res.ptr[res.major()] = out;
+    res.idx.resize(out);
+    res.values.resize(out);
+}
+
+/**
+ * @brief Sparse matrix product a * b, O(flops) time
+ *
+ * @param a left storage (CSR)
+ * @param b right storage (CSR)
+ * @param columns number of columns of b
+ * @param is_zero predicate for dropped values
+ * @return Compressed_storage<T>
+ */
+template<typename T, typename Predicate>
+Compressed_storage<T> spgemm(const Compressed_storage<T>& a, const Compressed_storage<T>& b, int columns,
+                             Predicate is_zero) {
+    int rows = a.major();
+    Sparse_accumulator<T> accumulator(columns);
+    std::vector<std::size_t> counts(rows);
+
+    spgemm_symbolic(a, b, 0, rows, accumulator, counts);
+    Compressed_storage<T> res(rows);
+    res.ptr = counts_to_offsets(counts);
+    res.idx.resize(res.ptr[rows]);
+    res.values.resize(res.ptr[rows]);
+
+    spgemm_numeric(a, b, 0, rows, accumulator, res, counts, is_zero);
+    spgemm_compact(res, counts);
+    return res;
+}
+
+#endif
@@ -3,6 +3,11 @@
 #include "../Matrix.h"
 #include "assert.h"
 #include "iostream"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
 
 int main() {
     Matrix<Rational_number<int>> m1("input/MatRat1.txt");
@@ -86,6 +91,567 @@ int main() {
 
     assert(Rational_number<int>(3) * identity == Matrix<Rational_number<int>>(5, 5, 3, 0.0001, true)); // test multiply by value
 
+    Matrix<Rational_number<int>> from_data(m1_own.get_dimentions(), m1_own.get_data());
+
+    assert(from_data == m1_own); // test conversion from map-based data
+
+    from_data(0, 2) = 0;
+
+    assert(from_data.nnz() == 4); // test that assigned zero is dropped from storage
+
+    Matrix<Rational_number<int>> left(30, 40), right(40, 20), reference(30, 20);
+    for (int k = 0; k < 200; ++k) {
+        left(k * 7 % 30, k * 13 % 40) = k % 5 - 2;
+        right(k * 11 % 40, k * 3 % 20) = k % 3 + 1;
+    }
+    for (const auto& [l, lv] : left.get_data()) {
+        for (const auto& [r, rv] : right.get_data()) {
+            if (std::get<1>(l) == std::get<0>(r)) {
+                reference(std::get<0>(l), std::get<1>(r)) += lv * rv;
+            }
+        }
+    }
+
+    assert(left * right == reference); // test sparse product against the naive one
+
+    Matrix<Rational_number<int>> big(3000, 3000);
+    for (int k = 0; k < 60000; ++k) {
+        big(k % 3000, (k / 3000 * 97 + k * 13) % 3000) = k % 4 + 1;
+    }
+    set_matrix_threads(1);
+    auto sequential = big * big;
+    auto sequential_vector = big * std::vector<Rational_number<int>>(3000, 1);
+    auto sequential_difference = sequential;
+    sequential_difference -= big;
+    set_matrix_threads(4);
+
+    assert(big * big == sequential); // test multithreaded product
+
+    assert(big * std::vector<Rational_number<int>>(3000, 1) == sequential_vector); // test multithreaded matrix * vector
+
+    auto difference_big = sequential;
+    difference_big -= big;
+
+    assert(difference_big == sequential_difference && difference_big + big == sequential); // test multithreaded merge
+
+    Thread_pool pool(3);
+    std::vector<int> nested_parts(12, 0);
+    pool.run(4, [&](int outer) { pool.run(3, [&](int inner) { ++nested_parts[outer * 3 + inner]; }); });
+    bool pool_rethrown = false;
+    try {
+        pool.run(4, [](int part) {
+            if (part == 2) {
+                throw MatrixException("part failed");
+            }
+        });
+    } catch (const MatrixException&) {
+        pool_rethrown = true;
+    }
+
+    assert(nested_parts == std::vector<int>(12, 1) && pool_rethrown); // test nested pool loops and exceptions
+
+    const Matrix<double> dense_shared(64, 64, 1.0);
+    const Matrix<Rational_number<int>> sparse_shared = left;
+    std::vector<std::vector<double>> dense_products(4);
+    std::vector<int> reads_agree(4, 0);
+    std::vector<std::thread> const_readers;
+    for (int t = 0; t < 4; ++t) {
+        const_readers.emplace_back([&, t] {
+            dense_products[t] = dense_shared * std::vector<double>(64, 1.0);
+            reads_agree[t] = dense_shared.storage().nnz() == 64 * 64 && dense_shared.is_dense() &&
+                             sparse_shared.dense_values().size() == 30u * 40 && !sparse_shared.is_dense();
+        });
+    }
+    for (auto& reader : const_readers) {
+        reader.join();
+    }
+
+    assert(dense_products == std::vector<std::vector<double>>(4, std::vector<double>(64, 64.0)) &&
+           reads_agree == std::vector<int>(4, 1)); // test concurrent const reads keep the format
+
+    std::ofstream("input/big.txt") << big;
+
+    assert(Matrix<Rational_number<int>>("input/big.txt") == big); // test chunked loading
+
+    big.save_binary("input/big.bin");
+    Binary_matrix_view<Rational_number<int>> view("input/big.bin");
+
+    assert(view.nnz() == big.nnz() && view.at(13, 13) == big(13, 13)); // test binary view
+
+    Matrix<double> small_binary(2, 2);
+    small_binary(0, 1) = 1;
+    small_binary(1, 0) = 2;
+    auto corrupted_view = [&](std::streamoff position, std::uint64_t value, std::size_t size) {
+        small_binary.save_binary("input/corrupted.bin");
+        std::fstream file("input/corrupted.bin", std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(position);
+        file.write(reinterpret_cast<const char*>(&value), size);
+        file.close();
+        try {
+            Binary_matrix_view<double>("input/corrupted.bin").validate();
+        } catch (const FileException&) {
+            return true;
+        }
+        return false;
+    };
+
+    assert(corrupted_view(40, std::uint64_t(1) << 62, 8) && corrupted_view(128, 7, 4) &&
+           corrupted_view(72, 3, 8)); // test binary view rejects huge nnz, wrong columns and row offsets
+    std::remove("input/corrupted.bin");
+
+    assert(Matrix<Rational_number<int>>::load_binary("input/big.bin") == big); // test binary save and load
+
+    binary_to_text<Rational_number<int>>("input/big.bin", "input/big_converted.txt");
+
+    assert(Matrix<Rational_number<int>>("input/big_converted.txt") == big); // test binary to text conversion
+
+    std::ofstream("input/market.mtx") << "%%MatrixMarket matrix coordinate real symmetric\n% comment\n"
+                                      << "3 3 4\n1 1 2.5\n3 1 -1e-1\n2 2 4\n3 1 0.35\n";
+    Matrix<Rational_number<long long>> market("input/market.mtx");
+
+    assert(market(0, 2) == Rational_number<long long>(1, 4) && market(2, 0) == market(0, 2)); // test symmetric .mtx
+
+    market.save_matrix_market("input/market_saved.mtx", true);
+
+    assert(Matrix<Rational_number<long long>>("input/market_saved.mtx") == market); // test .mtx writer
+
+    Matrix_builder<Rational_number<int>> builder(3000, 3000, 4);
+    std::vector<std::thread> fillers;
+    for (int t = 0; t < 4; ++t) {
+        fillers.emplace_back([&builder, t] {
+            for (int k = t; k < 60000; k += 4) {
+                builder.add(t, k % 3000, (k / 3000 * 97 + k * 13) % 3000, k % 4 + 1);
+            }
+        });
+    }
+    for (auto& filler : fillers) {
+        filler.join();
+    }
+    builder.add(0, 0, 0, 1);
+    builder.add(1, 0, 0, -1);
+
+    assert(builder.build() == big); // test multithreaded builder, duplicates are summed and zeros dropped
+
+    const auto& const_big = big;
+    std::size_t big_nnz = big.nnz();
+
+    assert(const_big.at(1, 2) == 0 && const_big.at(0, 0) == big(0, 0) && big.nnz() == big_nnz); // test read-only access
+
+    std::ofstream("input/unsorted.txt") << "matrix rational 2 2 # comment\n1 1 <3/4>\n0 0 1\n1 1 -2\n0 1 5\n0 1 0\n";
+    Matrix<Rational_number<int>> unsorted("input/unsorted.txt");
+
+    assert(unsorted.nnz() == 2 && unsorted(1, 1) == -2 && unsorted(0, 0) == 1); // test the last value of a cell wins
+
+    std::ofstream("input/wrong.txt") << "matrix rational 2 2\n0 2 1\n";
+    bool thrown = false;
+    try {
+        Matrix<Rational_number<int>> wrong("input/wrong.txt");
+    } catch (const FileException&) {
+        thrown = true;
+    }
+
+    assert(thrown); // test out of range index is rejected
+
+    Matrix<Rational_number<int>> filled(6, 4, 2), filled_product(6, 5, 24);
+
+    assert(filled.is_dense()); // test dense representation of filled matrix
+
+    assert(filled * Matrix<Rational_number<int>>(4, 5, 3) == filled_product); // test dense product
+
+    assert((filled * Matrix<Rational_number<int>>(4, 5, 3)).get_data() == filled_product.get_data()); // test dense to sparse
+
+    Rational_number<int> two(2);
+    assert(left + two * left - left == left * two); // test fused expression
+
+    assert(~(left - -left) == ~left * two); // test transposed expression
+
+    auto lazy = Matrix<Rational_number<int>>(6, 4, 1) + filled; // operand is a temporary held by value
+    Matrix<Rational_number<int>> evaluated = lazy;
+    assert(evaluated.is_dense() && evaluated == Matrix<Rational_number<int>>(6, 4, 3)); // test dense expression
+
+    auto block = left.view(Matrix_coords{5, 10, 24, 29});
+    Matrix<Rational_number<int>> copied(20, 20);
+    for (int i = 0; i < 20; ++i) {
+        for (int j = 0; j < 20; ++j) {
+            copied(i, j) = left.at(5 + i, 10 + j);
+        }
+    }
+
+    assert(block == copied && block.nnz() == copied.nnz()); // test block view
+
+    assert(block + block - copied == copied && block * block == copied * copied); // test arithmetic on views
+
+    assert(~left.view(Matrix_row_coord(7)) * ~left.view(Matrix_column_coord(3)) ==
+           ~Matrix<Rational_number<int>>(left.view(Matrix_row_coord(7))) *
+           ~Matrix<Rational_number<int>>(left.view(Matrix_column_coord(3)))); // test row and column views
+
+    assert(filled.view(Matrix_coords{1, 1, 2, 3}) * two == Matrix<Rational_number<int>>(2, 3, 4)); // test dense view
+
+    Matrix<Rational_number<int>> difference = left, product(30, 40), inside(30, 40), outside = left;
+    difference -= left * right * ~right;
+    for (const auto& [cell, value] : left.get_data()) {
+        auto [i, j] = cell;
+        product(i, j) = value * difference.at(i, j);
+        if (i < 10) {
+            inside(i, j) = value;
+            outside(i, j) = 0;
+        }
+    }
+
+    assert(difference + left * right * ~right == left); // test in-place subtraction
+
+    assert(left.hadamard(difference) == product); // test Hadamard product
+
+    Matrix<Rational_number<int>> top(30, 40, 1);
+    for (int i = 10; i < 30; ++i) {
+        for (int j = 0; j < 40; ++j) {
+            top(i, j) = 0;
+        }
+    }
+
+    assert(left.masked(top) == inside && left.masked(top, true) == outside); // test masked selection
+
+    Matrix<Rational_number<int>> shared = big;
+
+    assert(shared.shares_values(big)); // test copy shares values
+
+    shared(0, 0) += 1;
+
+    assert(!shared.shares_values(big) && shared(0, 0) == big(0, 0) + 1); // test copy on write
+
+    big.storage(); // readers never merge pending writes
+    std::vector<std::thread> readers;
+    std::vector<int> read_ok(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&big, &sequential_vector, &read_ok, t] {
+            Matrix<Rational_number<int>> copy = big;
+            read_ok[t] = copy * std::vector<Rational_number<int>>(3000, 1) == sequential_vector;
+        });
+    }
+    shared = big;
+    shared *= two;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    assert(std::count(read_ok.begin(), read_ok.end(), 1) == 4 && shared == big * two); // test concurrent readers
+
+    using Exact = Rational_number<long long>;
+    Matrix<Exact> hilbert(6, 6), swapped(3, 3), dependent(3, 3);
+    for (int i = 0; i < 6; ++i) {
+        for (int j = 0; j < 6; ++j) {
+            hilbert(i, j) = Exact(1, i + j + 1);
+        }
+    }
+    swapped(0, 1) = Exact(1, 2);
+    swapped(1, 0) = 3;
+    swapped(2, 2) = Exact(-2, 3);
+    for (int j = 0; j < 3; ++j) {
+        dependent(0, j) = Exact(j + 1, 2);
+        dependent(1, j) = j * j;
+        dependent(2, j) = dependent(0, j) - dependent(1, j) * 3;
+    }
+
+    // operator== of rationals multiplies denominators, which overflows for the Hilbert determinant
+    auto same_exact = [](const Exact& a, const Exact& b) {
+        return a.numerator() == b.numerator() && a.denominator() == b.denominator();
+    };
+
+    assert(same_exact(hilbert.determinant(), Exact(1, 186313420339200000LL)) &&
+           swapped.determinant() == 1); // test determinant
+
+    assert(dependent.rank() == 2 && dependent.determinant() == Exact() && hilbert.rank() == 6); // test rank
+
+    assert(hilbert.inverse() * hilbert == Matrix<Exact>(6, 6, 1, 0.0001, true)); // test inverse
+
+    assert(Matrix<Exact>(3, 3, 20000, 0.0001, true).inverse().at(0, 0) == Exact(1, 20000)); // test inverse keeps small entries
+
+    assert(hilbert.solve(hilbert * std::vector<Exact>(6, Exact(1, 3))) == std::vector<Exact>(6, Exact(1, 3))); // test solve
+
+    std::vector<Exact> thirds(6, Exact(1, 3));
+    assert(same_exact(hilbert.determinant(Exact_method::MODULAR), hilbert.determinant()) &&
+           dependent.determinant(Exact_method::MODULAR) == Exact() &&
+           swapped.determinant(Exact_method::MODULAR) == 1); // test multi-modular determinant
+
+    assert(hilbert.solve(hilbert * thirds, Exact_method::MODULAR) == thirds &&
+           swapped.solve({1, 2, 3}, Exact_method::MODULAR) == swapped.solve({1, 2, 3})); // test multi-modular solve
+
+    Matrix<Exact> big_entry(1, 1);
+    big_entry(0, 0) = Exact(4743729080978854881LL, 402342);
+    Exact big_solution = big_entry.solve({1})[0];
+    assert(same_exact(big_solution, Exact(134114, 1581243026992951627LL)) &&
+           same_exact(big_solution, big_entry.solve({1}, Exact_method::MODULAR)[0])); // test solve reduces big fractions
+
+    const int grid = 6;
+    Matrix<double> laplacian(grid * grid, grid * grid), pivoting(3, 3);
+    for (int v = 0; v < grid * grid; ++v) {
+        laplacian(v, v) = 4;
+        if (v % grid > 0) {
+            laplacian(v, v - 1) = laplacian(v - 1, v) = -1;
+        }
+        if (v >= grid) {
+            laplacian(v, v - grid) = laplacian(v - grid, v) = -1;
+        }
+    }
+    pivoting(0, 1) = 2;
+    pivoting(1, 2) = 1;
+    pivoting(2, 0) = 4;
+    pivoting(2, 2) = 3;
+    auto residual = [](const Matrix<double>& a, const std::vector<double>& x, const std::vector<double>& b) {
+        std::vector<double> ax = a * x;
+        double res = 0;
+        for (std::size_t k = 0; k < b.size(); ++k) {
+            res = std::max(res, std::abs(ax[k] - b[k]));
+        }
+        return res;
+    };
+    std::vector<double> ones(grid * grid, 1.0), ramp(grid * grid);
+    for (int v = 0; v < grid * grid; ++v) {
+        ramp[v] = v;
+    }
+    auto cholesky = laplacian.cholesky();
+    auto lu = laplacian.lu();
+
+    assert(residual(laplacian, cholesky.solve(ones), ones) < 1e-12 &&
+           residual(laplacian, cholesky.solve(ramp), ramp) < 1e-12 &&
+           cholesky.nnz() < std::size_t(grid * grid * grid)); // test sparse Cholesky factorization
+
+    assert(residual(laplacian, lu.solve(ramp), ramp) < 1e-12 &&
+           residual(pivoting, pivoting.lu().solve({1, 2, 3}), {1, 2, 3}) < 1e-12); // test sparse LU factorization
+
+    Matrix<double> convective = laplacian;
+    for (int v = 1; v < grid * grid; ++v) {
+        if (convective.at(v, v - 1) != 0) {
+            convective(v, v - 1) = -1.5;
+        }
+    }
+    Solver_options options;
+    options.tolerance = 1e-10;
+    int monitored = 0;
+    options.monitor = [&monitored](int, double) { ++monitored; };
+    std::vector<double> guess, preconditioned, restarted, stabilized;
+    Solver_report plain = laplacian.iterative_solve(ramp, guess, Krylov_method::CG, Preconditioner_type::NONE, options);
+    Solver_report ichol = laplacian.iterative_solve(ramp, preconditioned, Krylov_method::CG,
+                                                    Preconditioner_type::ICHOL0, options);
+
+    assert(plain.converged && ichol.converged && ichol.iterations < plain.iterations &&
+           monitored == plain.iterations + ichol.iterations &&
+           residual(laplacian, preconditioned, ramp) < 1e-8); // test preconditioned conjugate gradient
+
+    assert(convective.iterative_solve(ramp, stabilized, Krylov_method::BICGSTAB, Preconditioner_type::ILU0,
+                                      options).converged &&
+           convective.iterative_solve(ramp, restarted, Krylov_method::GMRES, Preconditioner_type::JACOBI,
+                                      options).converged &&
+           residual(convective, stabilized, ramp) < 1e-8 &&
+           residual(convective, restarted, ramp) < 1e-8); // test BiCGSTAB and GMRES on a nonsymmetric matrix
+
+    laplacian(0, 0) = -4;
+    bool indefinite = false, singular = false;
+    try {
+        laplacian.cholesky();
+    } catch (const MatrixException&) {
+        indefinite = true;
+    }
+    pivoting(2, 0) = 0;
+    try {
+        pivoting.lu();
+    } catch (const MatrixException&) {
+        singular = true;
+    }
+
+    assert(indefinite && singular); // test factorization failures
+
+    Matrix<double> coupled(20, 20);
+    for (int node = 0; node < 6; ++node) {
+        for (int other : {node - 1, node, node + 1}) {
+            for (int i = 0; i < 3 && other >= 0 && 3 * other + i < 20; ++i) {
+                for (int j = 0; j < 3 && 3 * node + j < 20; ++j) {
+                    coupled(3 * node + j, 3 * other + i) = (node == other ? 4 : -1) * (i + 1) + j;
+                }
+            }
+        }
+    }
+    std::vector<double> sweep(20);
+    for (int k = 0; k < 20; ++k) {
+        sweep[k] = k % 5 - 2;
+    }
+    Block_matrix<double, 3> blocked(coupled);
+    Block_matrix<double, 4> padded(coupled);
+
+    assert(coupled.block_size() == 3 && blocked.to_matrix() == coupled &&
+           padded.to_matrix() == coupled); // test conversion to and from block-sparse format
+
+    assert(blocked * sweep == coupled * sweep && padded * sweep == coupled * sweep &&
+           (blocked * blocked).to_matrix() == coupled * coupled &&
+           (padded * padded).to_matrix() == coupled * coupled); // test block-sparse products
+
+    Matrix<double> dense_left(37, 70, 1.0), dense_right(70, 45, 1.0);
+    for (int i = 0; i < 70; ++i) {
+        for (int j = 0; j < 45; ++j) {
+            dense_right(i, j) = (i * 3 + j) % 7 - 3;
+            if (j < 37) {
+                dense_left(j, i) = (i + j * 5) % 4 - 1;
+            }
+        }
+    }
+    Block_matrix<double, 8> wide_blocks(coupled);
+    set_simd_level(Simd_level::SCALAR);
+    auto scalar_product = dense_left * dense_right;
+    auto scalar_blocks = (wide_blocks * wide_blocks).to_matrix();
+    auto scalar_sweep = wide_blocks * sweep;
+    set_simd_level(Simd_level::AVX512);
+
+    assert(dense_left * dense_right == scalar_product && (wide_blocks * wide_blocks).to_matrix() == scalar_blocks &&
+           wide_blocks * sweep == scalar_sweep); // test SIMD kernels of the running CPU against scalar ones
+
+    int detected = 0;
+    visit_blocks(coupled, [&](const auto& matrix) {
+        detected = matrix.block_size();
+        assert(matrix * sweep == coupled * sweep);
+    });
+
+    assert(detected == 3 && laplacian.block_size() == 1); // test block size detection
+
+    Matrix<double> graph(6, 6);
+    for (auto [from, to, weight] : std::vector<std::tuple<int, int, double>>{
+            {0, 1, 2}, {0, 2, 5}, {1, 2, 1}, {1, 3, 7}, {2, 4, 3}, {4, 3, 1}, {3, 5, 2}, {4, 5, 6}}) {
+        graph(from, to) = weight;
+    }
+    std::vector<double> distances(6, Min_plus<double>::zero());
+    distances[0] = 0;
+    for (int step = 0; step < 5; ++step) {
+        graph.vxm<Min_plus<double>>(distances, distances, {}, Semiring_accumulator<Min_plus<double>>());
+    }
+
+    assert((distances == std::vector<double>{0, 2, 3, 7, 6, 9})); // test shortest paths in (min, +)
+
+    Matrix<double> reverse = ~graph;
+    std::vector<char> visited(6, 0);
+    std::vector<double> frontier(6, 0.0);
+    std::vector<int> levels(6, -1);
+    frontier[0] = 1;
+    for (int level = 0; std::count(frontier.begin(), frontier.end(), 0.0) < 6; ++level) {
+        for (int v = 0; v < 6; ++v) {
+            if (frontier[v] != 0) {
+                visited[v] = 1;
+                levels[v] = level;
+            }
+        }
+        std::vector<double> next(6, 0.0), pushed(6, 0.0);
+        reverse.mxv<Or_and<double>>(next, frontier, Vector_mask{&visited, true});
+        graph.vxm<Or_and<double>>(pushed, frontier, Vector_mask{&visited, true});
+        assert(next == pushed);
+        frontier = next;
+    }
+
+    assert((levels == std::vector<int>{0, 1, 1, 2, 2, 3})); // test masked BFS in (or, and)
+
+    Matrix<double> lower(4, 4);
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < i; ++j) {
+            lower(i, j) = 1;
+        }
+    }
+    Matrix<double> wedges = lower.mxm<Plus_times<double>>(lower, lower);
+    double triangles = 0;
+    for (double value : wedges.storage().values) {
+        triangles += value;
+    }
+    Matrix<double> widest = graph.mxm<Max_min<double>>(graph);
+    Matrix<double> common = lower.mxm<Plus_times<double>>(~lower, lower);
+    double dots = 0;
+    for (double value : common.storage().values) {
+        dots += value;
+    }
+
+    assert(triangles == 4 && dots == 4 && wedges.nnz() == 3 && lower.mxm<Plus_times<double>>(lower).nnz() == 3 &&
+           lower.mxm<Plus_times<double>>(lower, lower, true).nnz() == 0 &&
+           widest(0, 2) == 1 && widest(0, 3) == 2 && widest(0, 4) == 3 &&
+           widest.nnz() == 8); // test masked products in semirings
+
+    Matrix<double> undirected = graph.ewise_add<Min_plus<double>>(reverse);
+
+    assert(undirected.nnz() == 16 && undirected(1, 0) == 2 && undirected(3, 4) == 1 &&
+           graph.ewise_mult<Or_and<double>>(reverse).nnz() == 0 &&
+           graph.ewise_mult<Max_min<double>>(graph) == graph); // test element-wise semiring operations
+
+    std::vector<int> scramble(36), reversed(36);
+    for (int k = 0; k < 36; ++k) {
+        scramble[k] = k * 7 % 36;
+        reversed[k] = 35 - k;
+    }
+    Matrix<double> scrambled = convective, skewed = convective;
+    scrambled.permute(scramble);
+    skewed.permute(scramble, reversed);
+    bool permuted = true;
+    for (int i = 0; i < 36; ++i) {
+        for (int j = 0; j < 36; ++j) {
+            permuted = permuted && scrambled.at(i, j) == convective.at(scramble[i], scramble[j]) &&
+                       skewed.at(i, j) == convective.at(scramble[i], reversed[j]);
+        }
+    }
+
+    assert(permuted && scrambled.nnz() == convective.nnz() && convective.bandwidth() == 6 &&
+           convective.profile() == 6 * 30 + 5); // test symmetric and unsymmetric permutations
+
+    Matrix<double> banded = scrambled;
+    Reordering_report report = banded.reorder(Reordering::RCM);
+    std::vector<int> parts = partition_ordering(symmetric_adjacency(scrambled.storage()), 8);
+    std::vector<int> sorted_parts(parts);
+    std::sort(sorted_parts.begin(), sorted_parts.end());
+    Matrix<double> partitioned = scrambled;
+    partitioned.permute(parts);
+
+    assert(report.bandwidth_before == scrambled.bandwidth() && report.bandwidth_after == banded.bandwidth() &&
+           report.bandwidth_after <= 11 && report.profile_after < report.profile_before &&
+           sorted_parts == std::vector<int>(reversed.rbegin(), reversed.rend()) &&
+           partitioned.profile() < scrambled.profile()); // test RCM and partition orderings
+
+    bool rejected = false;
+    try {
+        banded.permute(std::vector<int>(36, 0));
+    } catch (const MatrixException&) {
+        rejected = true;
+    }
+
+    assert(rejected); // test invalid permutation
+
+    own3.save_tiled("input/own3.tiles", 1 << 16);
+    Tiled_matrix<Rational_number<int>> tiled_own3("input/own3.tiles");
+    Tiled_matrix<Rational_number<int>> tiled_own3_t = tiled_own3.transpose("input/own3_t.tiles");
+
+    assert(tiled_own3.nnz() == own3.nnz() && tiled_own3_t.to_matrix() == ~own3); // test out-of-core transpose
+
+    Matrix_builder<double> tall_builder(300, 250), wide_builder(250, 300);
+    for (int k = 0; k < 3000; ++k) {
+        tall_builder.add(k * 37 % 300, k * 101 % 250, k % 7 - 3);
+        wide_builder.add(k * 53 % 250, k * 29 % 300, k % 5 + 1);
+    }
+    Matrix<double> tall = tall_builder.build(), wide = wide_builder.build();
+    std::size_t budget = 8 * (65 * sizeof(std::size_t) + 200 * (sizeof(int) + sizeof(double)));
+    auto tiled_tall = Tiled_matrix<double>::create("input/tall.tiles", tall, 64, budget);
+    auto tiled_wide = Tiled_matrix<double>::create("input/wide.tiles", wide, 64, budget);
+    auto tiled_product = tiled_tall.multiply(tiled_wide, "input/product.tiles");
+    auto tiled_tall_t = tiled_tall.transpose("input/tall_t.tiles");
+    auto tiled_sum = tiled_tall_t.add(tiled_wide, "input/sum.tiles");
+
+    assert(tiled_tall.to_matrix() == tall && tiled_product.to_matrix() == tall * wide &&
+           tiled_sum.to_matrix() == ~tall + wide); // test out-of-core multiply and add
+
+    Tile_statistics io = tiled_tall.statistics();
+
+    assert(io.reads > 0 && io.evictions > 0 && io.prefetch_hits > 0 && io.hits > 0 &&
+           io.peak_bytes <= budget && tiled_product.statistics().writes > 0); // test tile cache statistics
+
+    for (const char* name : {"input/own3.tiles", "input/own3_t.tiles", "input/tall.tiles", "input/wide.tiles",
+                             "input/product.tiles", "input/tall_t.tiles", "input/sum.tiles"}) {
+        std::remove(name);
+    }
+    for (const char* name : {"input/big.txt", "input/unsorted.txt", "input/wrong.txt", "input/big.bin",
+                             "input/big_converted.txt", "input/market.mtx", "input/market_saved.mtx"}) {
+        std::remove(name);
+    }
+
     std::cout << "====== Matrix tests COMPLETE ======" << std::endl;
 
     return 0;
@@ -0,0 +1,166 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Persistent workers for fork-join loops of Matrix kernels
+ *
+ * Workers are started once, so a parallel loop costs a queue push per part
+ * instead of a thread start. The thread that calls run() executes part 0 and
+ * then helps with queued parts until its own parts are done: nested loops
+ * and pools without workers cannot deadlock.
+ *
+ */
+class Thread_pool {
+    /**
+     * @brief Parts of one run() still in flight and its first exception
+     */
+    struct Group {
+        int remaining;
+        std::exception_ptr error{};
+        std::mutex mutex{};
+        std::condition_variable done{};
+    };
+
+    std::vector<std::thread> _workers{};
+    std::deque<std::function<void()>> _tasks{};
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _stopped = false;
+
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condition.wait(lock, [this] { return _stopped || !_tasks.empty(); });
+                if (_stopped && _tasks.empty()) {
+                    return;
+                }
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    bool pop(std::function<void()>& task) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_tasks.empty()) {
+            return false;
+        }
+        task = std::move(_tasks.front());
+        _tasks.pop_front();
+        return true;
+    }
+
+    template<typename Function>
+    static void run_part(Group& group, Function& f, int part) {
+        try {
+            f(part);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(group.mutex);
+            if (!group.error) {
+                group.error = std::current_exception();
+            }
+        }
+    }
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param workers number of worker threads, the calling threads work as well
+     */
+    explicit Thread_pool(int workers) {
+        for (int i = 0; i < workers; ++i) {
+            _workers.emplace_back([this] { work(); });
+        }
+    }
+
+    Thread_pool(const Thread_pool&) = delete;
+    Thread_pool& operator=(const Thread_pool&) = delete;
+
+    /**
+     * @brief Destructor, finishes queued tasks
+     *
+     */
+    ~Thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _condition.notify_all();
+        for (auto& worker : _workers) {
+            worker.join();
+        }
+    }
+
+    /**
+     * @brief Pool shared by Matrix kernels, one worker less than hardware threads
+     *
+     * @return Thread_pool&
+     */
+    static Thread_pool& shared() {
+        static Thread_pool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+    int size() const {
+        return _workers.size();
+    }
+
+    /**
+     * @brief Run f(part) for every part in [0, parts) and wait, rethrows the first exception
+     *
+     * @param parts number of parts
+     * @param f function
+     */
+    template<typename Function>
+    void run(int parts, Function f) {
+        if (parts <= 1) {
+            if (parts == 1) {
+                f(0);
+            }
+            return;
+        }
+        Group group{parts - 1};
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (int part = 1; part < parts; ++part) {
+                _tasks.emplace_back([&group, &f, part] {
+                    run_part(group, f, part);
+                    std::lock_guard<std::mutex> lock(group.mutex);
+                    if (--group.remaining == 0) {
+                        group.done.notify_all();
+                    }
+                });
+            }
+        }
+        _condition.notify_all();
+        run_part(group, f, 0);
+
+        std::function<void()> task;
+        while (pop(task)) {
+            task();
+            std::lock_guard<std::mutex> lock(group.mutex);
+            if (group.remaining == 0) {
+                break;
+            }
+        }
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.done.wait(lock, [&group] { return group.remaining == 0; });
+        if (group.error) {
+            std::rethrow_exception(group.error);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include "iostream"
+
+/**
+ * @brief I/O counters of an out-of-core matrix
+ *
+ */
+struct Tile_statistics {
+    /**
+     * @brief tiles read from file and bytes read
+     */
+    std::size_t reads = 0;
+    std::size_t bytes_read = 0;
+    /**
+     * @brief tiles and bytes written when the file was produced
+     */
+    std::size_t writes = 0;
+    std::size_t bytes_written = 0;
+    /**
+     * @brief requests served from memory, by a finished or running prefetch, or by a read on demand
+     */
+    std::size_t hits = 0;
+    std::size_t prefetch_hits = 0;
+    std::size_t misses = 0;
+    /**
+     * @brief tiles dropped to stay within the budget
+     */
+    std::size_t evictions = 0;
+    /**
+     * @brief largest number of bytes held by the cache
+     */
+    std::size_t peak_bytes = 0;
+    /**
+     * @brief time spent waiting for tiles
+     */
+    double wait_seconds = 0;
+
+    /**
+     * @brief Overload of ostream
+     *
+     * @param os ostream
+     * @param statistics statistics
+     * @return std::ostream&
+     */
+    friend std::ostream& operator<<(std::ostream& os, const Tile_statistics& statistics) {
+        return os << "reads: " << statistics.reads << " (" << statistics.bytes_read << " bytes), writes: "
+                  << statistics.writes << " (" << statistics.bytes_written << " bytes), hits: " << statistics.hits
+                  << ", prefetch hits: " << statistics.prefetch_hits << ", misses: " << statistics.misses
+                  << ", evictions: " << statistics.evictions << ", peak: " << statistics.peak_bytes
+                  << " bytes, waiting: " << statistics.wait_seconds << " s";
+    }
+};
+
+/**
+ * @brief LRU cache of tiles within a memory budget
+ *
+ * Tiles are loaded by the loader either on demand in the requesting thread or
+ * ahead of time by prefetch() in a background thread. When a new tile does not
+ * fit into the budget, least recently used tiles are dropped; tiles still being
+ * loaded are never dropped, and a tile that does not fit anyway is returned
+ * without caching it (or not prefetched). Callers keep tiles alive through
+ * shared pointers, so the tiles in use by an operation may be held on top of
+ * the budget.
+ *
+ * @tparam Tile
+ */
+template<typename Tile>
+class Tile_cache {
+public:
+    using Pointer = std::shared_ptr<const Tile>;
+    using Loader = std::function<Tile(std::size_t)>;
+private:
+    struct Entry {
+        std::shared_future<Pointer> tile;
+        std::size_t bytes;
+        std::list<std::size_t>::iterator position;
+        bool prefetched;
+    };
+    /**
+     * @brief loads tile by key
+     */
+    Loader _load;
+    /**
+     * @brief memory budget in bytes
+     */
+    std::size_t _budget;
+    /**
+     * @brief bytes of cached tiles
+     */
+    std::size_t _used = 0;
+    /**
+     * @brief keys, most recently used first
+     */
+    std::list<std::size_t> _recent;
+    std::unordered_map<std::size_t, Entry> _entries;
+    Tile_statistics _statistics;
+    mutable std::mutex _mutex;
+
+    std::shared_future<Pointer> start(std::size_t key, std::launch policy) {
+        return std::async(policy, [this, key] { return Pointer(std::make_shared<const Tile>(_load(key))); }).share();
+    }
+
+    /**
+     * @brief Drop least recently used tiles until bytes fit into the budget, requires the lock
+     *
+     * @param bytes bytes of the tile to insert
+     */
+    void evict(std::size_t bytes) {
+        auto it = _recent.end();
+        while (_used + bytes > _budget && it != _recent.begin()) {
+            --it;
+            Entry& entry = _entries.at(*it);
+            if (entry.tile.wait_for(std::chrono::seconds(0)) == std::future_status::timeout) {
+                continue;
+            }
+            _used -= entry.bytes;
+            _entries.erase(*it);
+            it = _recent.erase(it);
+            ++_statistics.evictions;
+        }
+    }
+
+    /**
+     * @brief Cache tile if it fits into the budget after eviction, requires the lock
+     *
+     * @return bool tile is cached
+     */
+    bool insert(std::size_t key, std::size_t bytes, std::shared_future<Pointer> tile, bool prefetched) {
+        evict(bytes);
+        if (_used + bytes > _budget) {
+            return false;
+        }
+        _recent.push_front(key);
+        _entries.emplace(key, Entry{std::move(tile), bytes, _recent.begin(), prefetched});
+        _used += bytes;
+        _statistics.peak_bytes = std::max(_statistics.peak_bytes, _used);
+        return true;
+    }
+public:
+    /**
+     * @brief Constructor
+     *
+     * @param load loads tile by key, may be called from a background thread
+     * @param budget memory budget in bytes
+     */
+    Tile_cache(Loader load, std::size_t budget) : _load(std::move(load)), _budget(budget) {}
+
+    Tile_cache(const Tile_cache&) = delete;
+    Tile_cache& operator=(const Tile_cache&) = delete;
+
+    /**
+     * @brief Destructor, waits for running prefetches
+     *
+     */
+    ~Tile_cache() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        auto entries = std::move(_entries);
+        lock.unlock();
+    }
+
+    /**
+     * @brief Get tile, waits for its prefetch or loads it
+     *
+     * @param key key of tile
+     * @param bytes memory taken by the tile
+     * @return Pointer
+     */
+    Pointer get(std::size_t key, std::size_t bytes) {
+        std::shared_future<Pointer> tile;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto found = _entries.find(key);
+            if (found != _entries.end()) {
+                Entry& entry = found->second;
+                _recent.splice(_recent.begin(), _recent, entry.position);
+                if (entry.prefetched) {
+                    ++_statistics.prefetch_hits;
+                    entry.prefetched = false;
+                } else {
+                    ++_statistics.hits;
+                }
+                tile = entry.tile;
+            } else {
+                ++_statistics.misses;
+                tile = start(key, std::launch::deferred);
+                insert(key, bytes, tile, false);
+            }
+        }
+        auto begin = std::chrono::steady_clock::now();
+        Pointer res = tile.get();
+        std::chrono::duration<double> waited = std::chrono::steady_clock::now() - begin;
+        std::lock_guard<std::mutex> lock(_mutex);
+        _statistics.wait_seconds += waited.count();
+        return res;
+    }
+
+    /**
+     * @brief Start loading tile in a background thread unless it is cached
+     *
+     * @param key key of tile
+     * @param bytes memory taken by the tile
+     */
+    void prefetch(std::size_t key, std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_entries.count(key) == 0) {
+            evict(bytes);
+            if (_used + bytes <= _budget) {
+                insert(key, bytes, start(key, std::launch::async), true);
+            }
+        }
+    }
+
+    /**
+     * @brief Count a read of the loader
+     *
+     * @param bytes bytes read
+     */
+    void count_read(std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_statistics.reads;
+        _statistics.bytes_read += bytes;
+    }
+
+    /**
+     * @brief Count writes that produced the file
+     *
+     * @param tiles tiles written
+     * @param bytes bytes written
+     */
+    void count_writes(std::size_t tiles, std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _statistics.writes += tiles;
+        _statistics.bytes_written += bytes;
+    }
+
+    Tile_statistics statistics() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _statistics;
+    }
+
+    std::size_t budget() const {
+        return _budget;
+    }
+};
+
+#endif
@@ -0,0 +1,712 @@
+#ifndef TILED_MATRIX_H
+#define TILED_MATRIX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Elementwise_kernels.h"
+#include "Mapped_file.h"
+#include "Matrix_binary.h"
+#include "Parallel_kernels.h"
+#include "Tile_cache.h"
+#include "../Exceptions/Exceptions.h"
+
+template<typename T>
+class Matrix;
+
+/**
+ * @brief Default side of tiles
+ */
+const int TILE_SIZE = 4096;
+/**
+ * @brief Default memory budget of the tile cache in bytes
+ */
+const std::size_t TILE_MEMORY_BUDGET = std::size_t(256) << 20;
+/**
+ * @brief Number of scheduled steps whose tiles are loaded ahead
+ */
+const int TILE_PREFETCH_DEPTH = 2;
+
+/**
+ * @brief Footer of the tiled format
+ *
+ * Tiles are written one after another as they are produced, each in the
+ * layout of the binary format without header: local row offsets (uint64,
+ * tile rows + 1), local column indices (int32) and value components, every
+ * array aligned to BINARY_MATRIX_ALIGNMENT. The directory of tiles (one
+ * Tile_entry per tile, row-major, empty tiles have nnz 0) and this footer
+ * follow the last tile, so a file is written strictly sequentially.
+ */
+struct Tiled_matrix_footer {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t value_kind;
+    std::uint32_t component_size;
+    std::int64_t rows;
+    std::int64_t columns;
+    std::int64_t tile_size;
+    std::uint64_t directory_offset;
+    std::uint64_t reserved[1];
+};
+
+static_assert(sizeof(Tiled_matrix_footer) == BINARY_MATRIX_ALIGNMENT, "footer must fill one aligned block");
+
+/**
+ * @brief Magic bytes of the tiled format
+ */
+const char TILED_MATRIX_MAGIC[8] = {'M', 'A', 'T', 'R', 'X', 'T', 'I', 'L'};
+
+/**
+ * @brief Position of a tile in the file
+ */
+struct Tile_entry {
+    std::uint64_t offset;
+    std::uint64_t bytes;
+    std::uint64_t nnz;
+};
+
+/**
+ * @brief Number of tiles covering size elements
+ *
+ * @param size number of rows or columns
+ * @param tile_size side of tiles
+ * @return int
+ */
+inline int tile_count(int size, int tile_size) {
+    return int((std::int64_t(size) + tile_size - 1) / tile_size);
+}
+
+/**
+ * @brief Bytes of a tile in the file
+ *
+ * @param rows rows of the tile
+ * @param nnz nonzeros of the tile
+ * @return std::size_t
+ */
+template<typename T>
+std::size_t tile_file_bytes(int rows, std::size_t nnz) {
+    using Traits = Binary_value_traits<T>;
+    return binary_align((rows + 1) * sizeof(std::uint64_t)) + binary_align(nnz * sizeof(int)) +
+           Traits::components * binary_align(nnz * sizeof(typename Traits::Component));
+}
+
+/**
+ * @brief Writes tiles of a matrix in any order, tiles that are not written are zero
+ *
+ * Results of out-of-core operations are written tile by tile, so only the
+ * tile being written has to be in memory. The file is usable after finish().
+ *
+ * @tparam T
+ */
+template<typename T>
+class Tile_writer {
+    using Traits = Binary_value_traits<T>;
+    using Component = typename Traits::Component;
+    Output_file _file;
+    std::tuple<int, int> _dimentions;
+    int _tile_size;
+    int _tile_columns;
+    std::vector<Tile_entry> _directory;
+    std::size_t _tiles = 0;
+    bool _finished = false;
+public:
+    /**
+     * @brief Constructor, truncates existing file
+     *
+     * @param filename filename
+     * @param dimentions dimentions of matrix
+     * @param tile_size side of tiles
+     */
+    Tile_writer(const std::string& filename, std::tuple<int, int> dimentions, int tile_size = TILE_SIZE) :
+            _file(filename), _dimentions(dimentions), _tile_size(tile_size) {
+        auto [n, m] = dimentions;
+        if (n < 0 || m < 0 || tile_size <= 0) {
+            throw MatrixException("Wrong input - expected dimentions!");
+        }
+        _tile_columns = tile_count(m, tile_size);
+        _directory.assign(std::size_t(tile_count(n, tile_size)) * _tile_columns, Tile_entry{0, 0, 0});
+    }
+
+    int tile_size() const {
+        return _tile_size;
+    }
+
+    /**
+     * @brief Number of tiles in a column and in a row of tiles
+     *
+     * @return std::tuple<int, int>
+     */
+    std::tuple<int, int> tiles() const {
+        return {tile_count(std::get<0>(_dimentions), _tile_size), _tile_columns};
+    }
+
+    /**
+     * @brief Rows of tile row i
+     *
+     * @param i tile row
+     * @return int
+     */
+    int tile_rows(int i) const {
+        return std::min(_tile_size, std::get<0>(_dimentions) - i * _tile_size);
+    }
+
+    /**
+     * @brief Columns of tile column j
+     *
+     * @param j tile column
+     * @return int
+     */
+    int tile_columns(int j) const {
+        return std::min(_tile_size, std::get<1>(_dimentions) - j * _tile_size);
+    }
+
+    /**
+     * @brief Write tile (i, j)
+     *
+     * @param i tile row
+     * @param j tile column
+     * @param tile storage with local indices
+     */
+    void write(int i, int j, const Compressed_storage<T>& tile) {
+        if (_finished || i < 0 || j < 0 || i >= std::get<0>(tiles()) || j >= _tile_columns) {
+            throw MatrixException("Indices of slice are wrong!");
+        }
+        if (tile.major() != tile_rows(i) ||
+            (tile.nnz() != 0 && *std::max_element(tile.idx.begin(), tile.idx.end()) >= tile_columns(j))) {
+            throw MatrixException("Storage does not match dimentions!");
+        }
+        Tile_entry& entry = _directory[std::size_t(i) * _tile_columns + j];
+        if (entry.nnz != 0) {
+            throw MatrixException("Wrong input - tile is written twice!");
+        }
+        if (tile.nnz() == 0) {
+            return;
+        }
+
+        entry.offset = _file.offset();
+        _file.write(tile.ptr.data(), tile.ptr.size() * sizeof(std::uint64_t));
+        _file.pad(BINARY_MATRIX_ALIGNMENT);
+        _file.write(tile.idx.data(), tile.nnz() * sizeof(int));
+        _file.pad(BINARY_MATRIX_ALIGNMENT);
+        for (int part = 0; part < Traits::components; ++part) {
+            if constexpr (std::is_same_v<T, Component>) {
+                _file.write(tile.values.data(), tile.nnz() * sizeof(Component));
+            } else {
+                std::vector<Component> buffer(tile.nnz());
+                for (std::size_t k = 0; k < tile.nnz(); ++k) {
+                    buffer[k] = Traits::component(tile.values[k], part);
+                }
+                _file.write(buffer.data(), buffer.size() * sizeof(Component));
+            }
+            _file.pad(BINARY_MATRIX_ALIGNMENT);
+        }
+        entry.bytes = _file.offset() - entry.offset;
+        entry.nnz = tile.nnz();
+        ++_tiles;
+    }
+
+    /**
+     * @brief Write directory and footer
+     *
+     */
+    void finish() {
+        if (_finished) {
+            return;
+        }
+        Tiled_matrix_footer footer{};
+        std::memcpy(footer.magic, TILED_MATRIX_MAGIC, sizeof(footer.magic));
+        footer.version = BINARY_MATRIX_VERSION;
+        footer.byte_order = BINARY_MATRIX_BYTE_ORDER;
+        footer.value_kind = Traits::kind;
+        footer.component_size = sizeof(Component);
+        footer.rows = std::get<0>(_dimentions);
+        footer.columns = std::get<1>(_dimentions);
+        footer.tile_size = _tile_size;
+        footer.directory_offset = _file.offset();
+        _file.write(_directory.data(), _directory.size() * sizeof(Tile_entry));
+        _file.pad(BINARY_MATRIX_ALIGNMENT);
+        _file.write(&footer, sizeof(footer));
+        _finished = true;
+    }
+
+    /**
+     * @brief Number of nonempty tiles written
+     *
+     * @return std::size_t
+     */
+    std::size_t written() const {
+        return _tiles;
+    }
+
+    std::size_t bytes() const {
+        return _file.offset();
+    }
+};
+
+/**
+ * @brief Write all tiles of a matrix, one row of tiles at a time, and finish the file
+ *
+ * @param writer writer with the dimentions of storage
+ * @param storage CSR storage
+ */
+template<typename T>
+void write_tiled_matrix(Tile_writer<T>& writer, const Compressed_storage<T>& storage) {
+    auto [tile_rows, tile_columns] = writer.tiles();
+    int tile_size = writer.tile_size();
+    for (int i = 0; i < tile_rows; ++i) {
+        int first = i * tile_size;
+        int rows = writer.tile_rows(i);
+        std::vector<Compressed_storage<T>> tiles(tile_columns, Compressed_storage<T>(rows));
+        for (int r = 0; r < rows; ++r) {
+            for (std::size_t k = storage.ptr[first + r]; k < storage.ptr[first + r + 1]; ++k) {
+                tiles[storage.idx[k] / tile_size].push_back(storage.idx[k] % tile_size, storage.values[k]);
+            }
+            for (auto& tile : tiles) {
+                tile.ptr[r + 1] = tile.nnz();
+            }
+        }
+        for (int j = 0; j < tile_columns; ++j) {
+            writer.write(i, j, tiles[j]);
+        }
+    }
+    writer.finish();
+}
+
+/**
+ * @brief Write matrix in the tiled format
+ *
+ * @param filename filename
+ * @param dimentions dimentions
+ * @param storage CSR storage
+ * @param tile_size side of tiles
+ */
+template<typename T>
+void write_tiled_matrix(const std::string& filename, std::tuple<int, int> dimentions,
+                        const Compressed_storage<T>& storage, int tile_size = TILE_SIZE) {
+    Tile_writer<T> writer(filename, dimentions, tile_size);
+    write_tiled_matrix(writer, storage);
+}
+
+/**
+ * @brief Matrix stored as tiles in a file, for matrices that do not fit into memory
+ *
+ * Tiles are read through an LRU cache bounded by a memory budget. Operations
+ * walk the tiles in a fixed schedule, load the tiles of the next steps in the
+ * background while the current step computes, and write the result tile by
+ * tile into a new file, so the matrices themselves are never held in memory.
+ *
+ * @tparam T
+ */
+template<typename T>
+class Tiled_matrix {
+    using Traits = Binary_value_traits<T>;
+    using Component = typename Traits::Component;
+    using Storage = Compressed_storage<T>;
+    std::string _filename;
+    Input_file _file;
+    Tiled_matrix_footer _footer{};
+    std::vector<Tile_entry> _directory;
+    int _tile_rows = 0;
+    int _tile_columns = 0;
+    double _eps;
+    std::unique_ptr<Tile_cache<Storage>> _cache;
+
+    bool is_zero(const T& value) const {
+        return double(value) < _eps && double(value) > -_eps;
+    }
+
+    std::size_t key(int i, int j) const {
+        return std::size_t(i) * _tile_columns + j;
+    }
+
+    /**
+     * @brief Memory taken by a loaded tile
+     *
+     * @param key key of tile
+     * @return std::size_t
+     */
+    std::size_t memory_bytes(std::size_t key) const {
+        return (tile_rows(key / _tile_columns) + 1) * sizeof(std::size_t) +
+               _directory[key].nnz * (sizeof(int) + sizeof(T));
+    }
+
+    Storage read_tile(std::size_t key) const {
+        const Tile_entry& entry = _directory[key];
+        int rows = tile_rows(key / _tile_columns);
+        Storage res(rows);
+        if (entry.nnz == 0) {
+            return res;
+        }
+        std::vector<std::uint64_t> buffer(entry.bytes / sizeof(std::uint64_t));
+        _file.read(buffer.data(), entry.bytes, entry.offset);
+        _cache->count_read(entry.bytes);
+
+        const char* data = reinterpret_cast<const char*>(buffer.data());
+        std::size_t offset = binary_align((rows + 1) * sizeof(std::uint64_t));
+        std::memcpy(res.ptr.data(), data, res.ptr.size() * sizeof(std::size_t));
+        if (res.ptr[0] != 0 || res.ptr[rows] != entry.nnz) {
+            throw FileException("Wrong input - tiled matrix is corrupted!");
+        }
+        res.idx.resize(entry.nnz);
+        std::memcpy(res.idx.data(), data + offset, entry.nnz * sizeof(int));
+        offset += binary_align(entry.nnz * sizeof(int));
+        const Component* components[Traits::components];
+        for (int part = 0; part < Traits::components; ++part) {
+            components[part] = reinterpret_cast<const Component*>(data + offset);
+            offset += binary_align(entry.nnz * sizeof(Component));
+        }
+        res.values.resize(entry.nnz);
+        for (std::size_t k = 0; k < entry.nnz; ++k) {
+            res.values[k] = Traits::make(components, k);
+        }
+        return res;
+    }
+
+    /**
+     * @brief Walk steps of a schedule, tiles of the next steps are prefetched
+     *
+     * @param steps number of steps
+     * @param tiles tiles(s) is list of (matrix, key) needed by step s
+     * @param f f(s) computes step s
+     */
+    template<typename Tiles, typename Function>
+    static void run_schedule(std::size_t steps, Tiles tiles, Function f) {
+        for (std::size_t s = 0; s < steps; ++s) {
+            for (std::size_t ahead = s + 1; ahead < std::min(steps, s + 1 + TILE_PREFETCH_DEPTH); ++ahead) {
+                for (auto [matrix, key] : tiles(ahead)) {
+                    matrix->prefetch(key);
+                }
+            }
+            f(s);
+        }
+    }
+
+    /**
+     * @brief Open result of an operation, writes of the writer are counted in its statistics
+     *
+     * @param filename filename
+     * @param memory_budget bytes of tiles kept in memory
+     * @param eps epsilon
+     * @param writer finished writer of the file
+     */
+    Tiled_matrix(const std::string& filename, std::size_t memory_budget, double eps, const Tile_writer<T>& writer) :
+            Tiled_matrix(filename, memory_budget, eps) {
+        _cache->count_writes(writer.written(), writer.bytes());
+    }
+public:
+    /**
+     * @brief Open matrix in the tiled format
+     *
+     * @param filename filename
+     * @param memory_budget bytes of tiles kept in memory
+     * @param eps epsilon
+     */
+    explicit Tiled_matrix(const std::string& filename, std::size_t memory_budget = TILE_MEMORY_BUDGET,
+                          double eps = 0.0001) : _filename(filename), _file(filename), _eps(eps) {
+        if (_file.size() < sizeof(Tiled_matrix_footer)) {
+            throw FileException("Wrong input - not a tiled matrix!");
+        }
+        _file.read(&_footer, sizeof(_footer), _file.size() - sizeof(_footer));
+        if (std::memcmp(_footer.magic, TILED_MATRIX_MAGIC, sizeof(_footer.magic)) != 0) {
+            throw FileException("Wrong input - not a tiled matrix!");
+        }
+        if (_footer.version != BINARY_MATRIX_VERSION) {
+            throw FileException("Wrong input - unsupported tiled matrix version!");
+        }
+        if (_footer.byte_order != BINARY_MATRIX_BYTE_ORDER) {
+            throw FileException("Wrong input - tiled matrix has other byte order!");
+        }
+        if (_footer.value_kind != Traits::kind || _footer.component_size != sizeof(Component)) {
+            throw FileException("Wrong input - tiled matrix has other value type!");
+        }
+        if (_footer.rows < 0 || _footer.columns < 0 || _footer.rows > INT32_MAX || _footer.columns > INT32_MAX ||
+            _footer.tile_size <= 0 || _footer.tile_size > INT32_MAX) {
+            throw FileException("Wrong input - expected dimentions!");
+        }
+        _tile_rows = tile_count(_footer.rows, _footer.tile_size);
+        _tile_columns = tile_count(_footer.columns, _footer.tile_size);
+        _directory.resize(std::size_t(_tile_rows) * _tile_columns);
+        std::size_t directory_bytes = _directory.size() * sizeof(Tile_entry);
+        if (_footer.directory_offset + binary_align(directory_bytes) + sizeof(_footer) != _file.size()) {
+            throw FileException("Wrong input - tiled matrix is truncated!");
+        }
+        _file.read(_directory.data(), directory_bytes, _footer.directory_offset);
+        for (std::size_t k = 0; k < _directory.size(); ++k) {
+            const Tile_entry& entry = _directory[k];
+            if (entry.nnz != 0 && (entry.offset + entry.bytes > _footer.directory_offset ||
+                                   entry.bytes != tile_file_bytes<T>(tile_rows(k / _tile_columns), entry.nnz))) {
+                throw FileException("Wrong input - tiled matrix is corrupted!");
+            }
+        }
+        _cache = std::make_unique<Tile_cache<Storage>>([this](std::size_t k) { return read_tile(k); },
+                                                       memory_budget);
+    }
+
+    Tiled_matrix(const Tiled_matrix&) = delete;
+    Tiled_matrix& operator=(const Tiled_matrix&) = delete;
+
+    /**
+     * @brief Write matrix in the tiled format and open it
+     *
+     * @param filename filename
+     * @param matrix matrix
+     * @param tile_size side of tiles
+     * @param memory_budget bytes of tiles kept in memory
+     * @return Tiled_matrix
+     */
+    static Tiled_matrix create(const std::string& filename, const Matrix<T>& matrix, int tile_size = TILE_SIZE,
+                               std::size_t memory_budget = TILE_MEMORY_BUDGET) {
+        Tile_writer<T> writer(filename, matrix.get_dimentions(), tile_size);
+        write_tiled_matrix(writer, matrix.storage());
+        return Tiled_matrix(filename, memory_budget, matrix.get_eps(), writer);
+    }
+
+    /**
+     * @brief Get the dimentions of matrix
+     *
+     * @return std::tuple<int, int>
+     */
+    std::tuple<int, int> get_dimentions() const {
+        return {int(_footer.rows), int(_footer.columns)};
+    }
+
+    const std::string& filename() const {
+        return _filename;
+    }
+
+    int tile_size() const {
+        return _footer.tile_size;
+    }
+
+    /**
+     * @brief Number of tiles in a column and in a row of tiles
+     *
+     * @return std::tuple<int, int>
+     */
+    std::tuple<int, int> tiles() const {
+        return {_tile_rows, _tile_columns};
+    }
+
+    int tile_rows(int i) const {
+        return std::min<std::int64_t>(_footer.tile_size, _footer.rows - i * _footer.tile_size);
+    }
+
+    int tile_columns(int j) const {
+        return std::min<std::int64_t>(_footer.tile_size, _footer.columns - j * _footer.tile_size);
+    }
+
+    /**
+     * @brief Number of nonzeros, from the directory
+     *
+     * @return std::size_t
+     */
+    std::size_t nnz() const {
+        std::size_t res = 0;
+        for (const Tile_entry& entry : _directory) {
+            res += entry.nnz;
+        }
+        return res;
+    }
+
+    /**
+     * @brief Number of nonzeros of tile (i, j) without reading it
+     *
+     * @param i tile row
+     * @param j tile column
+     * @return std::size_t
+     */
+    std::size_t tile_nnz(int i, int j) const {
+        return _directory[key(i, j)].nnz;
+    }
+
+    /**
+     * @brief Tile (i, j) with local indices, read through the cache
+     *
+     * @param i tile row
+     * @param j tile column
+     * @return std::shared_ptr<const Compressed_storage<T>>
+     */
+    std::shared_ptr<const Storage> tile(int i, int j) const {
+        if (i < 0 || j < 0 || i >= _tile_rows || j >= _tile_columns) {
+            throw MatrixException("Indices of slice are wrong!");
+        }
+        return _cache->get(key(i, j), memory_bytes(key(i, j)));
+    }
+
+    /**
+     * @brief Start reading tile with key in the background
+     *
+     * @param k key of tile
+     */
+    void prefetch(std::size_t k) const {
+        if (_directory[k].nnz != 0) {
+            _cache->prefetch(k, memory_bytes(k));
+        }
+    }
+
+    /**
+     * @brief I/O statistics of this matrix
+     *
+     * @return Tile_statistics
+     */
+    Tile_statistics statistics() const {
+        return _cache->statistics();
+    }
+
+    /**
+     * @brief Load the whole matrix into memory
+     *
+     * @return Matrix<T>
+     */
+    Matrix<T> to_matrix() const {
+        Storage res(_footer.rows);
+        int size = _footer.tile_size;
+        for (int i = 0; i < _tile_rows; ++i) {
+            std::vector<std::shared_ptr<const Storage>> row(_tile_columns);
+            run_schedule(_tile_columns, [this, i](std::size_t j) {
+                return std::vector<std::pair<const Tiled_matrix*, std::size_t>>{{this, key(i, j)}};
+            }, [&](std::size_t j) {
+                if (tile_nnz(i, j) != 0) {
+                    row[j] = tile(i, j);
+                }
+            });
+            for (int r = 0; r < tile_rows(i); ++r) {
+                for (int j = 0; j < _tile_columns; ++j) {
+                    if (row[j] != nullptr) {
+                        for (std::size_t k = row[j]->ptr[r]; k < row[j]->ptr[r + 1]; ++k) {
+                            res.push_back(j * size + row[j]->idx[k], row[j]->values[k]);
+                        }
+                    }
+                }
+                res.ptr[i * size + r + 1] = res.nnz();
+            }
+        }
+        return Matrix<T>(get_dimentions(), std::move(res), _eps);
+    }
+
+    /**
+     * @brief Transposed matrix, tile (j, i) of the result is tile (i, j) transposed
+     *
+     * @param filename file of the result
+     * @return Tiled_matrix
+     */
+    Tiled_matrix transpose(const std::string& filename) const {
+        std::vector<std::size_t> schedule;
+        for (int j = 0; j < _tile_columns; ++j) {
+            for (int i = 0; i < _tile_rows; ++i) {
+                if (tile_nnz(i, j) != 0) {
+                    schedule.push_back(key(i, j));
+                }
+            }
+        }
+        Tile_writer<T> writer(filename, {int(_footer.columns), int(_footer.rows)}, _footer.tile_size);
+        run_schedule(schedule.size(), [&](std::size_t s) {
+            return std::vector<std::pair<const Tiled_matrix*, std::size_t>>{{this, schedule[s]}};
+        }, [&](std::size_t s) {
+            int i = schedule[s] / _tile_columns, j = schedule[s] % _tile_columns;
+            writer.write(j, i, tile(i, j)->transposed(tile_columns(j)));
+        });
+        writer.finish();
+        return Tiled_matrix(filename, _cache->budget(), _eps, writer);
+    }
+
+    /**
+     * @brief Sum of matrices, tile by tile
+     *
+     * @param rhs matrix with the same dimentions and tile size
+     * @param filename file of the result
+     * @return Tiled_matrix
+     */
+    Tiled_matrix add(const Tiled_matrix& rhs, const std::string& filename) const {
+        if (get_dimentions() != rhs.get_dimentions() || tile_size() != rhs.tile_size()) {
+            throw MatrixException("Dimentions of matrices are not equal!");
+        }
+        std::vector<std::size_t> schedule;
+        for (std::size_t k = 0; k < _directory.size(); ++k) {
+            if (_directory[k].nnz != 0 || rhs._directory[k].nnz != 0) {
+                schedule.push_back(k);
+            }
+        }
+        Tile_writer<T> writer(filename, get_dimentions(), _footer.tile_size);
+        run_schedule(schedule.size(), [&](std::size_t s) {
+            return std::vector<std::pair<const Tiled_matrix*, std::size_t>>{{this, schedule[s]},
+                                                                             {&rhs, schedule[s]}};
+        }, [&](std::size_t s) {
+            int i = schedule[s] / _tile_columns, j = schedule[s] % _tile_columns;
+            Storage sum = merge_storages<true, true, true>(*tile(i, j), *rhs.tile(i, j),
+                    [](const T& a, const T& b) { return a + b; }, [this](const T& value) { return is_zero(value); });
+            writer.write(i, j, sum);
+        });
+        writer.finish();
+        return Tiled_matrix(filename, _cache->budget(), _eps, writer);
+    }
+
+    /**
+     * @brief Product of matrices, tile (i, j) of the result is the sum of tile products (i, k) * (k, j)
+     *
+     * Steps run over k inside (i, j) inside i, so a row of tiles of this
+     * matrix is reused from the cache for every j when it fits into the budget.
+     * Products of tiles are accumulated exactly, values below eps are dropped
+     * once per result tile.
+     *
+     * @param rhs matrix with compatible dimentions and the same tile size
+     * @param filename file of the result
+     * @return Tiled_matrix
+     */
+    Tiled_matrix multiply(const Tiled_matrix& rhs, const std::string& filename) const {
+        if (_footer.columns != rhs._footer.rows) {
+            throw MatrixException("Dimentions are not compatible!");
+        }
+        if (tile_size() != rhs.tile_size()) {
+            throw MatrixException("Wrong input - tile sizes differ!");
+        }
+        struct Step {
+            int i, j, k;
+        };
+        std::vector<Step> schedule;
+        for (int i = 0; i < _tile_rows; ++i) {
+            for (int j = 0; j < rhs._tile_columns; ++j) {
+                for (int k = 0; k < _tile_columns; ++k) {
+                    if (tile_nnz(i, k) != 0 && rhs.tile_nnz(k, j) != 0) {
+                        schedule.push_back({i, j, k});
+                    }
+                }
+            }
+        }
+        Tile_writer<T> writer(filename, {int(_footer.rows), int(rhs._footer.columns)}, _footer.tile_size);
+        auto exact_zero = [](const T& value) { return value == T(); };
+        Storage sum;
+        run_schedule(schedule.size(), [&](std::size_t s) {
+            const Step& step = schedule[s];
+            return std::vector<std::pair<const Tiled_matrix*, std::size_t>>{
+                    {this, key(step.i, step.k)}, {&rhs, rhs.key(step.k, step.j)}};
+        }, [&](std::size_t s) {
+            const Step& step = schedule[s];
+            Storage product = parallel_spgemm(*tile(step.i, step.k), *rhs.tile(step.k, step.j),
+                                              rhs.tile_columns(step.j), exact_zero);
+            bool first = s == 0 || schedule[s - 1].i != step.i || schedule[s - 1].j != step.j;
+            bool last = s + 1 == schedule.size() || schedule[s + 1].i != step.i || schedule[s + 1].j != step.j;
+            if (first) {
+                sum = std::move(product);
+            } else {
+                sum = merge_storages<true, true, true>(sum, product, [](const T& a, const T& b) { return a + b; },
+                                                       exact_zero);
+            }
+            if (last) {
+                sum.remove_if([this](const T& value) { return is_zero(value); });
+                writer.write(step.i, step.j, sum);
+            }
+        });
+        writer.finish();
+        return Tiled_matrix(filename, _cache->budget(), _eps, writer);
+    }
+};
+
+#endif
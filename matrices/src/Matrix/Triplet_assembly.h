@@ -0,0 +1,235 @@
+#ifndef TRIPLET_ASSEMBLY_H
+#define TRIPLET_ASSEMBLY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "Compressed_storage.h"
+#include "Parallel_kernels.h"
+#include "Spgemm.h"
+
+/**
+ * @brief Element given by its cell
+ *
+ * @tparam T
+ */
+template<typename T>
+struct Matrix_triplet {
+    int i;
+    int j;
+    T value;
+};
+
+/**
+ * @brief Elements in several buffers, in order of buffers
+ */
+template<typename T>
+using Triplet_parts = std::vector<std::vector<Matrix_triplet<T>>>;
+
+/**
+ * @brief Later element of a cell replaces earlier ones
+ */
+struct Keep_last {
+    template<typename T>
+    void operator()(T& accumulated, T&& value) const {
+        accumulated = std::move(value);
+    }
+};
+
+/**
+ * @brief Elements of a cell are summed
+ */
+struct Sum_duplicates {
+    template<typename T>
+    void operator()(T& accumulated, T&& value) const {
+        accumulated += value;
+    }
+};
+
+/**
+ * @brief Rows up to this length are sorted by insertion
+ */
+const std::size_t INSERTION_SORT_LENGTH = 32;
+/**
+ * @brief Rows in a block of the first bucketing pass, a block is small enough to be sorted in cache
+ */
+const int ASSEMBLY_BLOCK_ROWS = 1024;
+
+/**
+ * @brief Sort nonzeros of one row by column keeping the order of equal columns
+ *
+ * @param idx columns
+ * @param values values
+ * @param row buffer
+ */
+template<typename T>
+void sort_row(int* idx, T* values, std::size_t size, std::vector<std::pair<int, T>>& row) {
+    if (std::is_sorted(idx, idx + size)) {
+        return;
+    }
+    row.clear();
+    for (std::size_t k = 0; k < size; ++k) {
+        row.emplace_back(idx[k], std::move(values[k]));
+    }
+    auto less = [](const auto& a, const auto& b) { return a.first < b.first; };
+    if (size <= INSERTION_SORT_LENGTH) {
+        for (std::size_t k = 1; k < size; ++k) {
+            for (std::size_t t = k; t > 0 && less(row[t], row[t - 1]); --t) {
+                std::swap(row[t], row[t - 1]);
+            }
+        }
+    } else {
+        std::stable_sort(row.begin(), row.end(), less);
+    }
+    for (std::size_t k = 0; k < size; ++k) {
+        idx[k] = row[k].first;
+        values[k] = std::move(row[k].second);
+    }
+}
+
+/**
+ * @brief Sort rows [first, last) of storage by column, combine elements of a cell and drop zeros
+ *
+ * Rows stay at their offsets, counts receive their new lengths for spgemm_compact().
+ *
+ * @param res storage with unsorted rows
+ * @param counts new lengths of rows
+ * @param row buffer
+ */
+template<typename T, typename Predicate, typename Combine>
+void combine_rows(Compressed_storage<T>& res, int first, int last, Predicate is_zero, Combine combine,
+                  std::vector<std::size_t>& counts, std::vector<std::pair<int, T>>& row) {
+    for (int r = first; r < last; ++r) {
+        std::size_t begin = res.ptr[r];
+        std::size_t end = res.ptr[r + 1];
+        sort_row(res.idx.data() + begin, res.values.data() + begin, end - begin, row);
+        std::size_t out = begin;
+        for (std::size_t k = begin; k < end;) {
+            std::size_t same = k + 1;
+            while (same < end && res.idx[same] == res.idx[k]) {
+                combine(res.values[k], std::move(res.values[same++]));
+            }
+            if (!is_zero(res.values[k])) {
+                res.idx[out] = res.idx[k];
+                if (out != k) {
+                    res.values[out] = std::move(res.values[k]);
+                }
+                ++out;
+            }
+            k = same;
+        }
+        counts[r] = out - begin;
+    }
+}
+
+/**
+ * @brief Build storage from elements sorted by cell without duplicates
+ *
+ * @param parts elements, emptied
+ * @param n number of rows
+ * @param is_zero predicate for dropped values
+ * @return Compressed_storage<T>
+ */
+template<typename T, typename Predicate>
+Compressed_storage<T> sorted_triplets_to_storage(Triplet_parts<T>& parts, int n, Predicate is_zero) {
+    std::size_t total = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+    Compressed_storage<T> res(n);
+    res.idx.reserve(total);
+    res.values.reserve(total);
+    for (auto& part : parts) {
+        for (auto& triplet : part) {
+            if (!is_zero(triplet.value)) {
+                ++res.ptr[triplet.i + 1];
+                res.push_back(triplet.j, std::move(triplet.value));
+            }
+        }
+        part = std::vector<Matrix_triplet<T>>{};
+    }
+    for (int r = 0; r < n; ++r) {
+        res.ptr[r + 1] += res.ptr[r];
+    }
+    return res;
+}
+
+/**
+ * @brief Build storage from elements, combining elements of one cell in their order
+ *
+ * Elements are bucketed twice with stable counting sorts: by blocks of
+ * ASSEMBLY_BLOCK_ROWS rows, which keeps the scatter cache-friendly, then by
+ * rows inside every block on its own thread. Rows are then sorted by column,
+ * combined and cleared of zeros.
+ *
+ * @param parts elements, emptied
+ * @param n number of rows
+ * @param is_zero predicate for dropped values
+ * @param combine combine(accumulated, value) merges elements of one cell
+ * @param threads number of threads
+ * @return Compressed_storage<T>
+ */
+template<typename T, typename Predicate, typename Combine = Keep_last>
+Compressed_storage<T> triplets_to_storage(Triplet_parts<T>& parts, int n, Predicate is_zero,
+                                          Combine combine = Combine{}, int threads = matrix_thread_count()) {
+    int blocks = (n + ASSEMBLY_BLOCK_ROWS - 1) / ASSEMBLY_BLOCK_ROWS;
+    std::vector<std::size_t> block_sizes(blocks, 0);
+    // files written by save() are sorted and have no duplicates
+    bool sorted = true;
+    const Matrix_triplet<T>* previous = nullptr;
+    for (const auto& part : parts) {
+        for (const auto& triplet : part) {
+            ++block_sizes[triplet.i / ASSEMBLY_BLOCK_ROWS];
+            if (previous != nullptr &&
+                (previous->i > triplet.i || (previous->i == triplet.i && previous->j >= triplet.j))) {
+                sorted = false;
+            }
+            previous = &triplet;
+        }
+    }
+    if (sorted) {
+        return sorted_triplets_to_storage(parts, n, is_zero);
+    }
+    std::vector<std::size_t> block_ptr = counts_to_offsets(block_sizes);
+    std::size_t total = block_ptr[blocks];
+    std::vector<Matrix_triplet<T>> blocked(total);
+    std::vector<std::size_t> next(block_ptr.begin(), block_ptr.end() - 1);
+    for (auto& part : parts) {
+        for (auto& triplet : part) {
+            blocked[next[triplet.i / ASSEMBLY_BLOCK_ROWS]++] = std::move(triplet);
+        }
+        part = std::vector<Matrix_triplet<T>>{};
+    }
+
+    Compressed_storage<T> res(n);
+    res.idx.resize(total);
+    res.values.resize(total);
+    std::vector<std::size_t> counts(n, 0);
+    parallel_ranges(partition_rows(block_sizes, useful_threads(total, threads)), [&](int, int first, int last) {
+        std::vector<std::pair<int, T>> row;
+        for (int b = first; b < last; ++b) {
+            int first_row = b * ASSEMBLY_BLOCK_ROWS;
+            int last_row = std::min(n, first_row + ASSEMBLY_BLOCK_ROWS);
+            for (std::size_t k = block_ptr[b]; k < block_ptr[b + 1]; ++k) {
+                ++counts[blocked[k].i];
+            }
+            res.ptr[first_row] = block_ptr[b];
+            for (int r = first_row; r < last_row; ++r) {
+                res.ptr[r + 1] = res.ptr[r] + counts[r];
+            }
+            std::vector<std::size_t> position(res.ptr.begin() + first_row, res.ptr.begin() + last_row);
+            for (std::size_t k = block_ptr[b]; k < block_ptr[b + 1]; ++k) {
+                std::size_t pos = position[blocked[k].i - first_row]++;
+                res.idx[pos] = blocked[k].j;
+                res.values[pos] = std::move(blocked[k].value);
+            }
+
+            combine_rows(res, first_row, last_row, is_zero, combine, counts, row);
+        }
+    });
+    spgemm_compact(res, counts);
+    return res;
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <utility>
 #include <numeric>
 #include <climits>
+#include <cstdlib>
 #include <cstdint>
 #include <string>
 #include "../Exceptions/Exceptions.h"
@@ -441,6 +442,24 @@ public:
         return "<" + std::to_string(_numerator) + "/" + std::to_string(_denominator) + ">";
     }
 
+    /**
+     * @brief Get numerator
+     *
+     * @return const T&
+     */
+    const T& numerator() const {
+        return _numerator;
+    }
+
+    /**
+     * @brief Get denominator
+     *
+     * @return const T&
+     */
+    const T& denominator() const {
+        return _denominator;
+    }
+
     /**
      * @brief Reduce to canonical form
      * 
@@ -448,7 +467,7 @@ public:
      */
     Rational_number& make_canonical() {
         if (_numerator != 0) {
-            T div = std::gcd(abs(_numerator), abs(_denominator));
+            T div = std::gcd(std::abs(_numerator), std::abs(_denominator));
             _numerator /= div;
             _denominator /= div;
         } else {
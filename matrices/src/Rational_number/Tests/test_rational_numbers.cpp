@@ -39,6 +39,11 @@ int main() {
 
     assert(rmul == mul_canonical); // test make_canonical
 
+    Rational_number<long long> big_canonical(402342, 4743729080978854881LL);
+    big_canonical.make_canonical();
+    assert(big_canonical.numerator() == 134114 &&
+           big_canonical.denominator() == 1581243026992951627LL); // test make_canonical of long long
+
     assert(int(rsum) == 1); // test int()
 
     assert(make_floor.floor() == -2); // test floor()